@@ -0,0 +1,67 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/driftsort.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+struct alignas(64) Record {
+  uint64_t key;
+  uint64_t payload[7];
+};
+
+int compare_records(const void *a, const void *b) {
+  uint64_t x = static_cast<const Record *>(a)->key;
+  uint64_t y = static_cast<const Record *>(b)->key;
+  return (x > y) - (x < y);
+}
+
+std::vector<Record> random_records(size_t n) {
+  std::vector<Record> data(n);
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<uint64_t> dist;
+  for (auto &x : data)
+    x.key = dist(g);
+  return data;
+}
+} // namespace
+
+// Cache-line aligned records, which `qsort_r` heap sorts.
+static void benchmark_qsort_r_over_aligned(benchmark::State &state) {
+  std::vector<Record> data = random_records(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<Record> copy = data;
+    state.ResumeTiming();
+    driftsort::qsort_r(copy.data(), copy.size(), sizeof(Record),
+                       driftsort::three_way(compare_records));
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations() * data.size());
+}
+
+static void benchmark_qsort_aligned(benchmark::State &state) {
+  std::vector<Record> data = random_records(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<Record> copy = data;
+    state.ResumeTiming();
+    driftsort::qsort_aligned(copy.data(), copy.size(), sizeof(Record),
+                             alignof(Record),
+                             driftsort::three_way(compare_records));
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK(benchmark_qsort_r_over_aligned)
+    ->RangeMultiplier(8)
+    ->Range(64, 1 << 21);
+BENCHMARK(benchmark_qsort_aligned)->RangeMultiplier(8)->Range(64, 1 << 21);
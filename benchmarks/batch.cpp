@@ -0,0 +1,77 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "benchmark_common.h"
+#include "driftsort/batch.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+
+// Random ints split into segments of random length up to `max_length`,
+// returned as CSR offsets.
+static std::vector<size_t> generate_segments(std::vector<int> &data,
+                                             size_t n, size_t max_length) {
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<int> dist;
+  std::uniform_int_distribution<size_t> length_dist(5, max_length);
+  data.resize(n);
+  for (auto &x : data)
+    x = dist(g);
+  std::vector<size_t> offsets{0};
+  while (offsets.back() < n)
+    offsets.push_back(std::min(n, offsets.back() + length_dist(g)));
+  return offsets;
+}
+
+template <typename QSortImpl>
+static void benchmark_qsort_each_segment(benchmark::State &state) {
+  size_t n = state.range(0);
+  std::vector<int> data;
+  std::vector<size_t> offsets = generate_segments(data, n, state.range(1));
+  std::vector<int> copy(n);
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = data;
+    state.ResumeTiming();
+    for (size_t i = 0; i + 1 < offsets.size(); i++)
+      QSortImpl::qsort(copy.data() + offsets[i], offsets[i + 1] - offsets[i],
+                       sizeof(int), compare_ints);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void benchmark_sort_csr(benchmark::State &state) {
+  size_t n = state.range(0);
+  std::vector<int> data;
+  std::vector<size_t> offsets = generate_segments(data, n, state.range(1));
+  std::vector<int> copy(n);
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = data;
+    state.ResumeTiming();
+    driftsort::sort_csr(copy.data(), offsets.data(), offsets.size() - 1,
+                        sizeof(int), compare_ints, state.range(2));
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(benchmark_qsort_each_segment, driftsort::DriftSort)
+    ->ArgsProduct({{1 << 20}, {8, 16, 64}});
+
+// The third argument is the number of workers.
+BENCHMARK(benchmark_sort_csr)
+    ->ArgsProduct({{1 << 20}, {8, 16, 64}, {1, 4}})
+    ->UseRealTime();
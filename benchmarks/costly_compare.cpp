@@ -5,6 +5,8 @@
  */
 
 #include "benchmark_common.h"
+#include "driftsort/cachedkey.h"
+#include "driftsort/driftsort.h"
 #include <benchmark/benchmark.h>
 #include <cmath>
 #include <cstdlib>
@@ -42,3 +44,42 @@ BENCHMARK_TEMPLATE(benchmark_qsort_with_costly_compare, driftsort::DriftSort)
 BENCHMARK_TEMPLATE(benchmark_qsort_with_costly_compare, driftsort::LibcSort)
     ->RangeMultiplier(2)
     ->Range(1, 1 << 16);
+
+static long double costly_key(const void *a) {
+  int x = *static_cast<const int *>(a);
+  return std::log2(static_cast<long double>(x) + 1.0L);
+}
+
+// Sorts shuffled ints by a derived key, with a comparator that derives it
+// for every comparison if `state.range(1)` is zero and with
+// `sort_by_cached_key` otherwise.
+static void benchmark_sort_by_costly_key(benchmark::State &state) {
+  size_t n = state.range(0);
+  bool cached = state.range(1) != 0;
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 0);
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::shuffle(data.begin(), data.end(), g);
+    state.ResumeTiming();
+    if (cached) {
+      driftsort::sort_by_cached_key(data.data(), n, sizeof(int),
+                                    [](const void *a) {
+                                      return static_cast<double>(
+                                          costly_key(a));
+                                    });
+    } else {
+      driftsort::qsort_r(data.data(), n, sizeof(int),
+                         [](const void *a, const void *b) {
+                           return -(costly_key(a) < costly_key(b));
+                         });
+    }
+    benchmark::DoNotOptimize(data);
+  }
+  state.SetBytesProcessed(state.iterations() * n * sizeof(int));
+}
+
+BENCHMARK(benchmark_sort_by_costly_key)
+    ->ArgsProduct({{1 << 10, 1 << 16}, {0, 1}});
@@ -0,0 +1,158 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Sorts with full-length scratch backed by small pages or by
+// `hugepage::allocate`, the choice `with_scratch` makes above
+// `policy::HUGE_PAGE_MIN_BYTES`. Where perf events are available, the dTLB
+// load misses of the sort are reported as well.
+
+#include "driftsort/driftsort.h"
+#include "driftsort/hugepage.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HAS_PERF_EVENTS 1
+#else
+#define HAS_PERF_EVENTS 0
+#endif
+
+namespace {
+int compare_ints(const void *a, const void *b) {
+  uint32_t x = *static_cast<const uint32_t *>(a);
+  uint32_t y = *static_cast<const uint32_t *>(b);
+  return (x > y) - (x < y);
+}
+
+// Counts the dTLB load misses of this thread while it is enabled. Stays
+// invalid where the counter cannot be opened, e.g. without permission.
+class DtlbMisses {
+  int fd = -1;
+
+public:
+  DtlbMisses() {
+#if HAS_PERF_EVENTS
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+  ~DtlbMisses() {
+#if HAS_PERF_EVENTS
+    if (fd >= 0)
+      ::close(fd);
+#endif
+  }
+  bool valid() const { return fd >= 0; }
+  void start() {
+#if HAS_PERF_EVENTS
+    if (fd >= 0)
+      ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+  void stop() {
+#if HAS_PERF_EVENTS
+    if (fd >= 0)
+      ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+  }
+  uint64_t read() const {
+    uint64_t count = 0;
+#if HAS_PERF_EVENTS
+    if (fd >= 0 && ::read(fd, &count, sizeof(count)) != sizeof(count))
+      count = 0;
+#endif
+    return count;
+  }
+};
+
+// Full-length scratch for `bytes`, on huge pages or explicitly kept on
+// small pages, so that the comparison holds whatever the system-wide THP
+// setting is.
+class Scratch {
+  void *data;
+  size_t bytes;
+  bool huge;
+
+public:
+  Scratch(size_t bytes, bool huge) : bytes(bytes), huge(huge) {
+    if (huge) {
+      data = driftsort::hugepage::allocate(bytes);
+      return;
+    }
+    data = ::operator new(bytes, std::align_val_t{4096}, std::nothrow);
+#ifdef MADV_NOHUGEPAGE
+    if (data != nullptr)
+      ::madvise(data, bytes, MADV_NOHUGEPAGE);
+#endif
+  }
+  ~Scratch() {
+    if (data == nullptr)
+      return;
+    if (huge)
+      driftsort::hugepage::release(data, bytes);
+    else
+      ::operator delete(data, std::align_val_t{4096});
+  }
+  void *get() const { return data; }
+};
+} // namespace
+
+// Sorts `state.range(0)` bytes of random 32-bit keys, with huge page scratch
+// if `state.range(1)` is set.
+static void benchmark_sort_scratch_pages(benchmark::State &state) {
+  size_t n = state.range(0) / sizeof(uint32_t);
+  bool huge = state.range(1) != 0;
+  std::vector<uint32_t> data(n);
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<uint32_t> dist;
+  for (auto &x : data)
+    x = dist(g);
+
+  driftsort::BlobComparator comp{sizeof(uint32_t), alignof(uint32_t),
+                                 compare_ints};
+  Scratch scratch(n * sizeof(uint32_t), huge);
+  if (scratch.get() == nullptr) {
+    state.SkipWithError("scratch allocation failed");
+    return;
+  }
+  std::vector<uint32_t> copy(n);
+  DtlbMisses misses;
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = data;
+    state.ResumeTiming();
+    misses.start();
+    driftsort::drift::sort<false>(copy.data(), n, scratch.get(), n, comp);
+    misses.stop();
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetBytesProcessed(state.iterations() * n * sizeof(uint32_t));
+  if (misses.valid())
+    state.counters["dtlb_misses"] = benchmark::Counter(
+        static_cast<double>(misses.read()), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(benchmark_sort_scratch_pages)
+    ->ArgsProduct({{int64_t{1} << 28, int64_t{1} << 30}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
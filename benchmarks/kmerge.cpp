@@ -0,0 +1,69 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "benchmark_common.h"
+#include "driftsort/kmerge.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+
+// `state.range(1)` sorted shards of random ints, `state.range(0)` in total.
+static std::vector<int> generate_shards(size_t n, size_t k) {
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<int> dist;
+  std::vector<int> data(n);
+  for (auto &x : data)
+    x = dist(g);
+  for (size_t i = 0; i < k; i++)
+    std::sort(data.begin() + n * i / k, data.begin() + n * (i + 1) / k);
+  return data;
+}
+
+template <typename QSortImpl>
+static void benchmark_qsort_on_shards(benchmark::State &state) {
+  size_t n = state.range(0);
+  std::vector<int> data = generate_shards(n, state.range(1));
+  std::vector<int> copy(n);
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = data;
+    state.ResumeTiming();
+    QSortImpl::qsort(copy.data(), n, sizeof(int), compare_ints);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void benchmark_merge_runs_on_shards(benchmark::State &state) {
+  size_t n = state.range(0);
+  size_t k = state.range(1);
+  std::vector<int> data = generate_shards(n, k);
+  std::vector<driftsort::SortedRun> runs;
+  for (size_t i = 0; i < k; i++)
+    runs.push_back({data.data() + n * i / k, n * (i + 1) / k - n * i / k});
+  std::vector<int> dest(n);
+  for (auto _ : state) {
+    driftsort::merge_runs(runs.data(), k, sizeof(int), dest.data(),
+                          compare_ints);
+    benchmark::DoNotOptimize(dest);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(benchmark_qsort_on_shards, driftsort::DriftSort)
+    ->ArgsProduct({{1 << 20}, {16, 128, 1024}});
+
+BENCHMARK(benchmark_merge_runs_on_shards)
+    ->ArgsProduct({{1 << 20}, {16, 128, 1024}});
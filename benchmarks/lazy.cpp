@@ -0,0 +1,41 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/lazy.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+static int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+
+// Takes the first `state.range(1)` elements of a shuffled sequence, like the
+// first pages of a paginated result.
+static void benchmark_lazy_sort_first_elements(benchmark::State &state) {
+  size_t n = state.range(0);
+  size_t count = std::min<size_t>(state.range(1), n);
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 0);
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::shuffle(data.begin(), data.end(), g);
+    state.ResumeTiming();
+    driftsort::LazySorter sorter(data.data(), n, sizeof(int), compare_ints);
+    for (size_t i = 0; i < count; i++)
+      benchmark::DoNotOptimize(sorter.next());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(benchmark_lazy_sort_first_elements)
+    ->ArgsProduct({{1 << 16, 1 << 20}, {50, 500, 1 << 20}});
@@ -0,0 +1,68 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Arrays around and beyond `policy::PREFETCH_MIN_BYTES`. Compare against a
+// build with -DDRIFTSORT_PREFETCH_MIN_BYTES=SIZE_MAX to see the effect of
+// software prefetching.
+
+#include "benchmark_common.h"
+#include "driftsort/policy.h"
+#include <array>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+template <size_t Size> struct Record {
+  uint32_t key;
+  std::array<uint8_t, Size - sizeof(uint32_t)> payload;
+};
+
+template <size_t Size>
+static int compare_records(const void *a, const void *b) {
+  uint32_t x = static_cast<const Record<Size> *>(a)->key;
+  uint32_t y = static_cast<const Record<Size> *>(b)->key;
+  return (x > y) - (x < y);
+}
+
+// Sorts `state.range(0)` bytes of random records of `Size` bytes.
+template <size_t Size>
+static void benchmark_qsort_beyond_cache(benchmark::State &state) {
+  size_t n = state.range(0) / Size;
+  std::vector<Record<Size>> data(n);
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<uint32_t> dist;
+  for (auto &x : data)
+    x.key = dist(g);
+  std::vector<Record<Size>> copy(n);
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = data;
+    state.ResumeTiming();
+    driftsort::DriftSort::qsort(copy.data(), n, Size, compare_records<Size>);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetBytesProcessed(state.iterations() * n * Size);
+  state.counters["prefetch"] =
+      n * Size >= driftsort::policy::PREFETCH_MIN_BYTES;
+}
+
+BENCHMARK_TEMPLATE(benchmark_qsort_beyond_cache, 4)
+    ->RangeMultiplier(4)
+    ->Range(1 << 22, 1 << 28)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(benchmark_qsort_beyond_cache, 16)
+    ->RangeMultiplier(4)
+    ->Range(1 << 22, 1 << 28)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(benchmark_qsort_beyond_cache, 64)
+    ->RangeMultiplier(4)
+    ->Range(1 << 22, 1 << 28)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,105 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/blob.h"
+#include "driftsort/setops.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+static int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+
+// Two sorted arrays of `state.range(0)` random ints from a range twice as
+// long, so that about two fifths of the elements of each are in the other.
+static void generate_sets(size_t n, std::vector<int> &a, std::vector<int> &b) {
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(2 * n));
+  a.resize(n);
+  b.resize(n);
+  for (auto &x : a)
+    x = dist(g);
+  for (auto &x : b)
+    x = dist(g);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+}
+
+static void benchmark_std_set_union(benchmark::State &state) {
+  std::vector<int> a, b;
+  generate_sets(state.range(0), a, b);
+  std::vector<int> dest(a.size() + b.size());
+  for (auto _ : state) {
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), dest.begin(),
+                   [](const int &x, const int &y) {
+                     return compare_ints(&x, &y) < 0;
+                   });
+    benchmark::DoNotOptimize(dest);
+  }
+  state.SetItemsProcessed(state.iterations() * (a.size() + b.size()));
+}
+
+static void benchmark_set_union(benchmark::State &state) {
+  std::vector<int> a, b;
+  generate_sets(state.range(0), a, b);
+  std::vector<int> dest(a.size() + b.size());
+  for (auto _ : state) {
+    driftsort::set_union(a.data(), a.size(), b.data(), b.size(), sizeof(int),
+                         dest.data(), driftsort::three_way(compare_ints));
+    benchmark::DoNotOptimize(dest);
+  }
+  state.SetItemsProcessed(state.iterations() * (a.size() + b.size()));
+}
+
+static void benchmark_std_set_intersection(benchmark::State &state) {
+  std::vector<int> a, b;
+  generate_sets(state.range(0), a, b);
+  std::vector<int> dest(a.size());
+  for (auto _ : state) {
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                          dest.begin(), [](const int &x, const int &y) {
+                            return compare_ints(&x, &y) < 0;
+                          });
+    benchmark::DoNotOptimize(dest);
+  }
+  state.SetItemsProcessed(state.iterations() * (a.size() + b.size()));
+}
+
+static void benchmark_set_intersection(benchmark::State &state) {
+  std::vector<int> a, b;
+  generate_sets(state.range(0), a, b);
+  std::vector<int> dest(a.size());
+  for (auto _ : state) {
+    driftsort::set_intersection(a.data(), a.size(), b.data(), b.size(),
+                                sizeof(int), dest.data(),
+                                driftsort::three_way(compare_ints));
+    benchmark::DoNotOptimize(dest);
+  }
+  state.SetItemsProcessed(state.iterations() * (a.size() + b.size()));
+}
+
+static void benchmark_merge_join(benchmark::State &state) {
+  std::vector<int> a, b;
+  generate_sets(state.range(0), a, b);
+  std::vector<driftsort::JoinRange> ranges(a.size());
+  for (auto _ : state) {
+    driftsort::merge_join(a.data(), a.size(), b.data(), b.size(), sizeof(int),
+                          ranges.data(), driftsort::three_way(compare_ints));
+    benchmark::DoNotOptimize(ranges);
+  }
+  state.SetItemsProcessed(state.iterations() * (a.size() + b.size()));
+}
+
+BENCHMARK(benchmark_std_set_union)->Arg(1 << 20);
+BENCHMARK(benchmark_set_union)->Arg(1 << 20);
+BENCHMARK(benchmark_std_set_intersection)->Arg(1 << 20);
+BENCHMARK(benchmark_set_intersection)->Arg(1 << 20);
+BENCHMARK(benchmark_merge_join)->Arg(1 << 20);
@@ -0,0 +1,39 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/stream.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+
+// Pushes random data in chunks of `state.range(1)` elements, then finishes.
+static void benchmark_stream_sort_chunks(benchmark::State &state) {
+  size_t n = state.range(0);
+  size_t chunk = state.range(1);
+  std::vector<int> data(n);
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<int> dist;
+  for (auto &x : data)
+    x = dist(g);
+  for (auto _ : state) {
+    driftsort::StreamSorter sorter(sizeof(int), compare_ints);
+    for (size_t i = 0; i < n; i += chunk)
+      sorter.push(data.data() + i, std::min(chunk, n - i));
+    benchmark::DoNotOptimize(sorter.finish());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(benchmark_stream_sort_chunks)
+    ->ArgsProduct({{1 << 20}, {1 << 10, 1 << 14, 1 << 20}});
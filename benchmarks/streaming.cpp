@@ -0,0 +1,140 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Bulk copies and sorts beyond the last level cache, while another thread
+// keeps reading a buffer that fits into it. The rate of those reads shows
+// how much of the cache the copies evict. Compare the sorts of a build with
+// -DDRIFTSORT_STREAMING_STORE_MIN_BYTES=33554432 against one with
+// -DDRIFTSORT_STREAMING_STORE_MIN_BYTES=SIZE_MAX to see the effect of
+// non-temporal stores on both. The neighbour needs a core of its own.
+
+#include "benchmark_common.h"
+#include "driftsort/blob.h"
+#include "driftsort/policy.h"
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+// Reads random cache lines of a buffer of `bytes` on its own thread, and
+// counts the reads between `start` and `stop`.
+class CacheNeighbour {
+  std::vector<uint64_t> buffer;
+  std::atomic<bool> measuring{false};
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> reads{0};
+  std::thread thread;
+
+  void run() {
+    size_t lines = buffer.size() / 8;
+    uint64_t state = 0x9E3779B97F4A7C15;
+    uint64_t sum = 0;
+    while (!done.load(std::memory_order_relaxed)) {
+      uint64_t batch = 0;
+      for (; batch < 1024; batch++) {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        sum += buffer[(state >> 33) % lines * 8];
+      }
+      if (measuring.load(std::memory_order_relaxed))
+        reads.fetch_add(batch, std::memory_order_relaxed);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+public:
+  explicit CacheNeighbour(size_t bytes)
+      : buffer(bytes / sizeof(uint64_t), 1), thread([this] { run(); }) {}
+  ~CacheNeighbour() {
+    done.store(true, std::memory_order_relaxed);
+    thread.join();
+  }
+  void start() { measuring.store(true, std::memory_order_relaxed); }
+  void stop() { measuring.store(false, std::memory_order_relaxed); }
+  uint64_t count() const { return reads.load(std::memory_order_relaxed); }
+};
+
+// A quarter of a typical last level cache.
+constexpr size_t NEIGHBOUR_BYTES = size_t{4} << 20;
+
+int compare_ints(const void *a, const void *b) {
+  uint32_t x = *static_cast<const uint32_t *>(a);
+  uint32_t y = *static_cast<const uint32_t *>(b);
+  return (x > y) - (x < y);
+}
+} // namespace
+
+// Copies `state.range(0)` bytes with `memcpy`, or with non-temporal stores
+// if `state.range(1)` is set.
+static void benchmark_bulk_copy(benchmark::State &state) {
+  size_t bytes = state.range(0);
+  bool streaming = state.range(1) != 0;
+  std::vector<std::byte> src(bytes, std::byte{1});
+  std::vector<std::byte> dst(bytes);
+  CacheNeighbour neighbour(NEIGHBOUR_BYTES);
+  for (auto _ : state) {
+    neighbour.start();
+#if DRIFTSORT_HAS_STREAMING_STORES
+    if (streaming)
+      driftsort::stream_bytes(dst.data(), src.data(), bytes);
+    else
+#endif
+      std::memcpy(dst.data(), src.data(), bytes);
+    neighbour.stop();
+    benchmark::DoNotOptimize(dst.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+  state.counters["neighbour_reads"] = benchmark::Counter(
+      static_cast<double>(neighbour.count()), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(benchmark_bulk_copy)
+    ->ArgsProduct({{int64_t{1} << 26, int64_t{1} << 28}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Sorts `state.range(0)` bytes of 32-bit keys in 16 sorted runs next to the
+// reading thread. Merging the runs saves and flushes runs in bulk, where
+// random keys would be partitioned back and forth between array and scratch
+// instead.
+static void benchmark_qsort_next_to_neighbour(benchmark::State &state) {
+  size_t n = state.range(0) / sizeof(uint32_t);
+  std::vector<uint32_t> data(n);
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<uint32_t> dist;
+  for (auto &x : data)
+    x = dist(g);
+  for (size_t run = 0; run < 16; run++)
+    std::sort(data.begin() + run * n / 16, data.begin() + (run + 1) * n / 16);
+  std::vector<uint32_t> copy(n);
+  CacheNeighbour neighbour(NEIGHBOUR_BYTES);
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = data;
+    state.ResumeTiming();
+    neighbour.start();
+    driftsort::DriftSort::qsort(copy.data(), n, sizeof(uint32_t),
+                                compare_ints);
+    neighbour.stop();
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetBytesProcessed(state.iterations() * n * sizeof(uint32_t));
+  state.counters["neighbour_reads"] = benchmark::Counter(
+      static_cast<double>(neighbour.count()), benchmark::Counter::kIsRate);
+  state.counters["streaming"] =
+      n * sizeof(uint32_t) >= driftsort::policy::streaming_store_min_bytes();
+}
+
+BENCHMARK(benchmark_qsort_next_to_neighbour)
+    ->RangeMultiplier(4)
+    ->Range(1 << 24, 1 << 28)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
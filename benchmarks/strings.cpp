@@ -0,0 +1,79 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "benchmark_common.h"
+#include "driftsort/strsort.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// URL-like strings sharing long prefixes, with some duplicates.
+static std::vector<std::string> generate_urls(size_t n) {
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<int> host(0, 15);
+  std::uniform_int_distribution<int> dir(0, 63);
+  std::uniform_int_distribution<int> file(0, 1 << 20);
+  std::vector<std::string> urls;
+  urls.reserve(n);
+  for (size_t i = 0; i < n; i++)
+    urls.push_back("https://www.example-host-" + std::to_string(host(g)) +
+                   ".com/static/assets/dir" + std::to_string(dir(g)) +
+                   "/file-" + std::to_string(file(g)) + ".html");
+  return urls;
+}
+
+template <typename QSortImpl>
+static void benchmark_qsort_on_urls(benchmark::State &state) {
+  size_t n = state.range(0);
+  std::vector<std::string> urls = generate_urls(n);
+  std::vector<const char *> data;
+  for (auto &url : urls)
+    data.push_back(url.c_str());
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector data_copy = data;
+    state.ResumeTiming();
+    QSortImpl::qsort(data_copy.data(), n, sizeof(const char *),
+                     [](const void *a, const void *b) {
+                       return std::strcmp(*static_cast<const char *const *>(a),
+                                          *static_cast<const char *const *>(b));
+                     });
+    benchmark::DoNotOptimize(data_copy);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void benchmark_sort_strings_on_urls(benchmark::State &state) {
+  size_t n = state.range(0);
+  std::vector<std::string> urls = generate_urls(n);
+  std::vector<const char *> data;
+  for (auto &url : urls)
+    data.push_back(url.c_str());
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector data_copy = data;
+    state.ResumeTiming();
+    driftsort::sort_strings(data_copy.data(), n);
+    benchmark::DoNotOptimize(data_copy);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(benchmark_qsort_on_urls, driftsort::DriftSort)
+    ->RangeMultiplier(8)
+    ->Range(1024, 1 << 22);
+
+BENCHMARK_TEMPLATE(benchmark_qsort_on_urls, driftsort::LibcSort)
+    ->RangeMultiplier(8)
+    ->Range(1024, 1 << 22);
+
+BENCHMARK(benchmark_sort_strings_on_urls)
+    ->RangeMultiplier(8)
+    ->Range(1024, 1 << 22);
@@ -10,12 +10,13 @@
 
 extern "C" void driftsort_qsort_r(void *base, size_t nmemb, size_t size,
                                   compar_d_fn_t compar, void *arg) {
-  driftsort::qsort_r(base, nmemb, size,
-                     [compar, arg](const void *a, const void *b) {
-                       return compar(a, b, arg);
-                     });
+  driftsort::qsort_r(
+      base, nmemb, size,
+      driftsort::three_way([compar, arg](const void *a, const void *b) {
+        return compar(a, b, arg);
+      }));
 }
 extern "C" void driftsort_qsort(void *base, size_t nmemb, size_t size,
                                 compar_fn_t compar) {
-  driftsort::qsort_r(base, nmemb, size, compar);
+  driftsort::qsort_r(base, nmemb, size, driftsort::three_way(compar));
 }
@@ -0,0 +1,66 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "benchmark_common.h"
+#include "driftsort/unique.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+
+// `state.range(0)` random ints drawn from `state.range(1)` distinct values.
+static std::vector<int> generate_duplicates(size_t n, int distinct) {
+  std::random_device rd;
+  std::default_random_engine g(rd());
+  std::uniform_int_distribution<int> dist(0, distinct - 1);
+  std::vector<int> data(n);
+  for (auto &x : data)
+    x = dist(g);
+  return data;
+}
+
+template <typename QSortImpl>
+static void benchmark_qsort_then_unique(benchmark::State &state) {
+  size_t n = state.range(0);
+  std::vector<int> data = generate_duplicates(n, state.range(1));
+  std::vector<int> copy(n);
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = data;
+    state.ResumeTiming();
+    QSortImpl::qsort(copy.data(), n, sizeof(int), compare_ints);
+    auto last = std::unique(copy.begin(), copy.end());
+    benchmark::DoNotOptimize(last);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void benchmark_sort_unique(benchmark::State &state) {
+  size_t n = state.range(0);
+  std::vector<int> data = generate_duplicates(n, state.range(1));
+  std::vector<int> copy(n);
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy = data;
+    state.ResumeTiming();
+    size_t distinct =
+        driftsort::sort_unique(copy.data(), n, sizeof(int), compare_ints);
+    benchmark::DoNotOptimize(distinct);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(benchmark_qsort_then_unique, driftsort::DriftSort)
+    ->ArgsProduct({{1 << 20}, {16, 1024, 1 << 30}});
+
+BENCHMARK(benchmark_sort_unique)->ArgsProduct({{1 << 20}, {16, 1024, 1 << 30}});
@@ -0,0 +1,132 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/common.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/key.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+namespace indirect {
+/// A compact sort entry: the encoded key prefix and the element index.
+template <typename Index> struct KeyIndex {
+  uint64_t prefix;
+  Index index;
+};
+
+template <typename Index>
+inline void write_ranks(const Index *perm, size_t length, Index *ranks) {
+  if (ranks == nullptr)
+    return;
+  for (size_t i = 0; i < length; i++)
+    ranks[perm[i]] = static_cast<Index>(i);
+}
+
+/// Sorts `perm[..length]`, which holds indices into `data`, with the element
+/// comparator. The sort is stable, so increasing indices keep their order.
+template <typename Index, typename Comp>
+inline void sort_indices(const void *data, size_t length, size_t element_size,
+                         Index *perm, Comp compare) {
+  const std::byte *base = static_cast<const std::byte *>(data);
+  driftsort::qsort_r(perm, length, sizeof(Index),
+                     [base, element_size, &compare](const void *a,
+                                                    const void *b) {
+                       Index x = *static_cast<const Index *>(a);
+                       Index y = *static_cast<const Index *>(b);
+                       return compare(base + x * element_size,
+                                      base + y * element_size);
+                     });
+}
+
+/// Sorts `pairs[..length]` by prefix, breaking prefix ties with the rest of the
+/// key. Elements are only read to break ties of long byte keys.
+template <typename Index>
+inline void sort_pairs(const void *data, size_t element_size,
+                       KeyIndex<Index> *pairs, size_t length,
+                       const KeySpec &spec) {
+  const std::byte *base = static_cast<const std::byte *>(data);
+  if (key::prefix_is_exact(spec)) {
+    driftsort::qsort_r(pairs, length, sizeof(KeyIndex<Index>),
+                       [](const void *a, const void *b) {
+                         uint64_t x =
+                             static_cast<const KeyIndex<Index> *>(a)->prefix;
+                         uint64_t y =
+                             static_cast<const KeyIndex<Index> *>(b)->prefix;
+                         return (x > y) - (x < y);
+                       });
+    return;
+  }
+  driftsort::qsort_r(
+      pairs, length, sizeof(KeyIndex<Index>),
+      [base, element_size, &spec](const void *a, const void *b) {
+        auto x = static_cast<const KeyIndex<Index> *>(a);
+        auto y = static_cast<const KeyIndex<Index> *>(b);
+        if (x->prefix != y->prefix)
+          return x->prefix < y->prefix ? -1 : 1;
+        return key::compare_tail(base + x->index * element_size,
+                                 base + y->index * element_size, spec);
+      });
+}
+} // namespace indirect
+
+/// Returns the size in bytes of the indices `argsort` writes for `length`
+/// elements: 4 if every index fits into 32 bits and 8 otherwise.
+inline size_t argsort_index_size(size_t length) {
+  return static_cast<uint64_t>(length) <= uint64_t{1} << 32 ? sizeof(uint32_t)
+                                                          : sizeof(uint64_t);
+}
+
+/// Computes the permutation that stably sorts `data` without modifying it.
+///
+/// Afterwards `data[perm[i]]` is the i-th element in sorted order. If `ranks`
+/// is not null it receives the inverse permutation, the sorted position of
+/// each element.
+template <typename Index, typename Comp>
+inline void argsort(const void *data, size_t length, size_t element_size,
+                    Index *perm, Index *ranks, Comp compare) {
+  for (size_t i = 0; i < length; i++)
+    perm[i] = static_cast<Index>(i);
+  indirect::sort_indices(data, length, element_size, perm, compare);
+  indirect::write_ranks(perm, length, ranks);
+}
+
+/// Like `argsort`, but orders elements by the key described by `spec`.
+///
+/// This sorts compact (key prefix, index) pairs, so the elements are read
+/// once to encode their keys and afterwards only to break ties between long
+/// byte keys. Returns false without doing anything if `spec` is invalid.
+template <typename Index>
+inline bool argsort_key(const void *data, size_t length, size_t element_size,
+                        const KeySpec &spec, Index *perm, Index *ranks) {
+  if (!key::is_valid(spec, element_size))
+    return false;
+  const std::byte *base = static_cast<const std::byte *>(data);
+  void *raw_pairs =
+      ::operator new(length * sizeof(indirect::KeyIndex<Index>), std::nothrow);
+  if (DRIFTSORT_UNLIKELY(raw_pairs == nullptr)) {
+    argsort(data, length, element_size, perm, ranks,
+            [&spec](const void *a, const void *b) {
+              return key::compare(a, b, spec);
+            });
+    return true;
+  }
+
+  auto pairs = static_cast<indirect::KeyIndex<Index> *>(raw_pairs);
+  for (size_t i = 0; i < length; i++)
+    pairs[i] = {key::prefix(base + i * element_size, spec),
+                static_cast<Index>(i)};
+  indirect::sort_pairs(data, element_size, pairs, length, spec);
+  for (size_t i = 0; i < length; i++)
+    perm[i] = pairs[i].index;
+  ::operator delete(raw_pairs);
+  indirect::write_ranks(perm, length, ranks);
+  return true;
+}
+} // namespace DRIFTSORT_HIDDEN driftsort
@@ -0,0 +1,148 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/quicksort.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <memory>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+/// Cancels one sort by `sort_cancellable` or `sort_async` and tracks its
+/// progress. `cancel`, `cancelled` and `progress` may be called from any
+/// thread, the rest only by the sorting one.
+class SortControl {
+  using Clock = std::chrono::steady_clock;
+
+  /// Passes over this many elements go between two looks at the clock.
+  static constexpr size_t DEADLINE_INTERVAL = size_t{1} << 16;
+
+  std::atomic<bool> stop{false};
+  std::atomic<bool> finished{false};
+  std::atomic<size_t> done{0};
+  std::atomic<size_t> total{0};
+  Clock::time_point deadline = Clock::time_point::max();
+  size_t next_deadline_check = DEADLINE_INTERVAL;
+  bool stopped = false;
+
+public:
+  SortControl() = default;
+  /// A control that cancels the sort once `deadline` has passed.
+  explicit SortControl(Clock::time_point deadline) : deadline(deadline) {}
+  SortControl(const SortControl &) = delete;
+  SortControl &operator=(const SortControl &) = delete;
+
+  /// Asks the sort to stop. It does so at its next run, merge or partition,
+  /// so it may still take as long as one pass over the array. The sort may
+  /// also finish first.
+  void cancel() { stop.store(true, std::memory_order_relaxed); }
+  /// Whether `cancel` was called or the deadline passed.
+  bool cancelled() const { return stop.load(std::memory_order_relaxed); }
+
+  /// Estimates the fraction of the sort that is done, from 0 before it
+  /// starts to 1 once it has finished. The estimate counts the elements of
+  /// each finished partition, merge and run against about log2(length)
+  /// such passes over the whole array, the number a sort of shuffled
+  /// elements takes. It never goes down, and stays below 1 until the sort
+  /// has finished, but sorts of runs or of many equal elements need fewer
+  /// passes and jump to 1 early.
+  double progress() const {
+    if (finished.load(std::memory_order_acquire))
+      return 1.0;
+    size_t expected = total.load(std::memory_order_relaxed);
+    if (expected == 0)
+      return 0.0;
+    size_t passes = done.load(std::memory_order_relaxed);
+    double fraction =
+        static_cast<double>(passes) / static_cast<double>(expected);
+    return std::min(fraction, 0.99);
+  }
+
+  /// Starts tracking a sort of about `passes` elements in total.
+  void start(size_t passes) { total.store(passes, std::memory_order_relaxed); }
+
+  /// Counts a finished pass over `length` elements, and cancels the sort
+  /// if it has passed the deadline.
+  void advance(size_t length) {
+    // Only the sorting thread writes, so this needs no atomic addition.
+    size_t passes = done.load(std::memory_order_relaxed) + length;
+    done.store(passes, std::memory_order_relaxed);
+    if (passes >= next_deadline_check) {
+      next_deadline_check = passes + DEADLINE_INTERVAL;
+      if (deadline != Clock::time_point::max() && Clock::now() >= deadline)
+        cancel();
+    }
+  }
+
+  /// Whether the sort is to stop now. Remembers if it did, see `finish`.
+  bool should_stop() {
+    stopped = stopped || cancelled();
+    return stopped;
+  }
+
+  /// Ends the sort, and returns whether it ran to the end, which it may
+  /// have done even if it was cancelled late.
+  bool finish() {
+    if (!stopped)
+      finished.store(true, std::memory_order_release);
+    return !stopped;
+  }
+};
+
+/// Sorts like `qsort_r`, but stops early if `control` is cancelled, see
+/// `SortControl::cancel`. Returns whether the array is sorted. Otherwise it
+/// still holds all of its elements, in unspecified order.
+///
+/// Runs are created, merged and partitioned as usual and only between them
+/// does the sort look at `control`, which costs a relaxed atomic load each
+/// time. Arrays up to `max_len_always_insertion_sort` elements are sorted
+/// without looking.
+template <typename Comp>
+inline bool sort_cancellable(void *data, size_t length, size_t element_size,
+                             Comp compare, SortControl &control) {
+  if (control.should_stop())
+    return control.finish();
+  size_t leaves =
+      length / std::max<size_t>(quick::smallsort_threshold(element_size), 1);
+  control.start(length * (std::bit_width(leaves) + 1));
+  qsort_r(data, length, element_size, Cancellable<Comp>{compare, &control});
+  return control.finish();
+}
+
+/// Runs `sort_cancellable` on a new thread. The future holds its result.
+/// `data` and `control` must outlive the sort. Throws `std::system_error`
+/// if the thread cannot be started.
+template <typename Comp>
+inline std::future<bool> sort_async(void *data, size_t length,
+                                    size_t element_size, Comp compare,
+                                    SortControl &control) {
+  return std::async(std::launch::async, [=, &control] {
+    return sort_cancellable(data, length, element_size, compare, control);
+  });
+}
+
+/// Like `sort_async`, but hands the sort to `executor`, which is called with
+/// a copyable function object that runs it and may run that on any thread.
+template <typename Executor, typename Comp>
+inline std::future<bool> sort_async(Executor &&executor, void *data,
+                                    size_t length, size_t element_size,
+                                    Comp compare, SortControl &control) {
+  auto task = std::make_shared<std::packaged_task<bool()>>([=, &control] {
+    return sort_cancellable(data, length, element_size, compare, control);
+  });
+  std::future<bool> result = task->get_future();
+  executor([task] { (*task)(); });
+  return result;
+}
+} // namespace DRIFTSORT_HIDDEN driftsort
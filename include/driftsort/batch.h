@@ -0,0 +1,199 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/drift.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/quicksort.h"
+#include "driftsort/smallsort.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <system_error>
+#include <thread>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+
+/// An array of `length` elements to be sorted as part of a batch.
+struct Segment {
+  void *data;
+  size_t length;
+};
+
+namespace batch {
+/// Segments of at least this many elements go through the sorting networks
+/// and branchless merges of `small::small_sort_general` rather than
+/// insertion sort, even below `max_len_always_insertion_sort`. Without data
+/// dependent branches, the sort of one segment overlaps with that of the
+/// next instead of waiting on its mispredictions.
+inline constexpr size_t MIN_SMALL_SORT = 8;
+
+/// Elements each worker thread gets at least. Starting a thread costs about
+/// as much as sorting that many elements in tiny segments.
+inline constexpr size_t MIN_WORKER_ELEMENTS = size_t{1} << 16;
+
+/// Sorts one segment without any of the setup of `qsort_r`. `scratch` holds
+/// `scratch_length` elements, at least `quick::smallsort_threshold + 16` and
+/// as many as `driftsort` would allocate for the segment.
+template <typename Comp>
+inline void sort_segment(BlobPtr v, size_t length, BlobPtr scratch,
+                         size_t scratch_length,
+                         const BlobComparator<Comp> &comp) {
+  if (length < 2)
+    return;
+  size_t small_length = quick::smallsort_threshold(comp.size());
+  if (length < MIN_SMALL_SORT)
+    small::insertion_sort_shift_left(v, length, 1, comp);
+  else if (length <= small_length)
+    small::small_sort_general(v, length, scratch, comp);
+  else if (length <= small_length * 2)
+    drift::sort<true>(v, length, scratch, scratch_length, comp);
+  else
+    drift::sort<false>(v, length, scratch, scratch_length, comp);
+}
+
+/// Sorts the segments `segment_at(begin..end)` on the calling thread, with
+/// one scratch buffer of `scratch_length` elements for all of them.
+template <typename Comp, typename SegmentAt>
+inline void sort_range(size_t begin, size_t end, const SegmentAt &segment_at,
+                       size_t scratch_length,
+                       const BlobComparator<Comp> &comp) {
+  // As in `qsort_r`, over-aligned elements take the slow path.
+  if (DRIFTSORT_UNLIKELY(comp.align() > MAX_ALIGNMENT)) {
+    for (size_t i = begin; i < end; i++) {
+      Segment segment = segment_at(i);
+      if (segment.length < 2)
+        continue;
+      if (segment.length <= max_len_always_insertion_sort(comp.size()))
+        small::insertion_sort_shift_left(comp.lift(segment.data),
+                                         segment.length, 1, comp);
+      else
+        trivial_heap_sort(segment.data, segment.length, comp);
+    }
+    return;
+  }
+  bool allocated = with_scratch(scratch_length, comp, [&](BlobPtr scratch) {
+    for (size_t i = begin; i < end; i++) {
+      Segment segment = segment_at(i);
+      sort_segment(comp.lift(segment.data), segment.length, scratch,
+                   scratch_length, comp);
+    }
+  });
+  if (DRIFTSORT_UNLIKELY(!allocated)) {
+    for (size_t i = begin; i < end; i++) {
+      Segment segment = segment_at(i);
+      if (segment.length >= 2)
+        trivial_heap_sort(segment.data, segment.length, comp);
+    }
+  }
+}
+
+/// Sorts the `count` segments returned by `segment_at(i)`. `addresses` is
+/// the bitwise or of their addresses, `longest` the maximum length and
+/// `total` the sum of the lengths.
+///
+/// Up to `workers` threads share the work: the segments are cut into that
+/// many consecutive ranges of about the same number of elements, but at
+/// least `MIN_WORKER_ELEMENTS` each, and every range but the last is sorted
+/// on a thread of its own. Ranges whose thread cannot be started are sorted
+/// on the calling thread.
+template <typename Comp, typename SegmentAt>
+inline void sort_all(size_t count, SegmentAt segment_at, size_t element_size,
+                     uintptr_t addresses, size_t longest, size_t total,
+                     Comp compare, size_t workers) {
+  if (element_size == 0 || longest < 2)
+    return;
+  size_t alignment =
+      guess_alignment(element_size, reinterpret_cast<void *>(addresses));
+  BlobComparator<Comp> comp{element_size, alignment, compare};
+  // One scratch buffer per thread, sized like `driftsort` sizes it for the
+  // longest segment, serves every segment.
+  size_t scratch_length = scratch_length_for(longest, element_size);
+  workers = std::min(workers, total / MIN_WORKER_ELEMENTS);
+  std::thread *threads = nullptr;
+  if (workers > 1)
+    threads = new (std::nothrow) std::thread[workers - 1];
+  if (threads == nullptr) {
+    sort_range(0, count, segment_at, scratch_length, comp);
+    return;
+  }
+
+  size_t begin = 0;
+  size_t end = 0;
+  size_t elements = 0;
+  for (size_t w = 0; w + 1 < workers; w++) {
+    size_t target = total / workers * (w + 1);
+    while (end < count && elements < target)
+      elements += segment_at(end++).length;
+    try {
+      threads[w] = std::thread([=, &segment_at, &comp] {
+        sort_range(begin, end, segment_at, scratch_length, comp);
+      });
+    } catch (const std::system_error &) {
+      sort_range(begin, end, segment_at, scratch_length, comp);
+    } catch (const std::bad_alloc &) {
+      // `std::thread` allocates the state it passes to the new thread.
+      sort_range(begin, end, segment_at, scratch_length, comp);
+    }
+    begin = end;
+  }
+  sort_range(begin, count, segment_at, scratch_length, comp);
+  for (size_t w = 0; w + 1 < workers; w++) {
+    if (threads[w].joinable())
+      threads[w].join();
+  }
+  delete[] threads;
+}
+} // namespace batch
+
+/// Sorts each of `segments[..count]` independently, sharing the setup of
+/// `qsort_r` and one scratch buffer between them. Segments must not
+/// overlap. This is meant for many tiny arrays, where that setup would
+/// otherwise dominate. Up to `workers` threads sort the batch, the calling
+/// one included, and `compare` must then be safe to call from all of them.
+template <typename Comp>
+inline void sort_segments(const Segment *segments, size_t count,
+                          size_t element_size, Comp compare,
+                          size_t workers = 1) {
+  uintptr_t addresses = 0;
+  size_t longest = 0;
+  size_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    addresses |= reinterpret_cast<uintptr_t>(segments[i].data);
+    longest = std::max(longest, segments[i].length);
+    total += segments[i].length;
+  }
+  batch::sort_all(
+      count, [segments](size_t i) { return segments[i]; }, element_size,
+      addresses, longest, total, compare, workers);
+}
+
+/// Like `sort_segments` for `count` segments stored back to back in `data`,
+/// in compressed sparse row layout: segment `i` is the elements
+/// `data[offsets[i]..offsets[i + 1]]`, so `offsets` holds `count + 1`
+/// non-decreasing indices.
+template <typename Comp>
+inline void sort_csr(void *data, const size_t *offsets, size_t count,
+                     size_t element_size, Comp compare, size_t workers = 1) {
+  size_t longest = 0;
+  for (size_t i = 0; i < count; i++)
+    longest = std::max(longest, offsets[i + 1] - offsets[i]);
+  auto base = static_cast<std::byte *>(data);
+  batch::sort_all(
+      count,
+      [=](size_t i) {
+        return Segment{base + offsets[i] * element_size,
+                       offsets[i + 1] - offsets[i]};
+      },
+      element_size, reinterpret_cast<uintptr_t>(data), longest,
+      count == 0 ? 0 : offsets[count] - offsets[0], compare, workers);
+}
+
+} // namespace DRIFTSORT_HIDDEN driftsort
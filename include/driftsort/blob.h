@@ -7,14 +7,55 @@
 #pragma once
 
 #include "driftsort/common.h"
+#include "driftsort/policy.h"
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <new>
 #include <type_traits>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#define DRIFTSORT_HAS_STREAMING_STORES 1
+#else
+#define DRIFTSORT_HAS_STREAMING_STORES 0
+#endif
+
 namespace DRIFTSORT_HIDDEN driftsort {
 
+#if DRIFTSORT_HAS_STREAMING_STORES
+/// Copies `bytes` from `src` to `dest` with non-temporal stores, which write
+/// whole cache lines to memory without reading them first or keeping them
+/// in the cache. The final fence orders them before any later store, as
+/// they are weakly ordered otherwise.
+inline void stream_bytes(std::byte *dest, const std::byte *src,
+                         size_t bytes) {
+  constexpr size_t VECTOR = sizeof(__m128i);
+  size_t head = (-reinterpret_cast<uintptr_t>(dest)) & (VECTOR - 1);
+  head = head < bytes ? head : bytes;
+  std::memcpy(dest, src, head);
+  dest += head;
+  src += head;
+  bytes -= head;
+  for (; bytes >= 4 * VECTOR; bytes -= 4 * VECTOR) {
+    auto s = reinterpret_cast<const __m128i *>(src);
+    __m128i a = _mm_loadu_si128(s);
+    __m128i b = _mm_loadu_si128(s + 1);
+    __m128i c = _mm_loadu_si128(s + 2);
+    __m128i d = _mm_loadu_si128(s + 3);
+    auto t = reinterpret_cast<__m128i *>(dest);
+    _mm_stream_si128(t, a);
+    _mm_stream_si128(t + 1, b);
+    _mm_stream_si128(t + 2, c);
+    _mm_stream_si128(t + 3, d);
+    src += 4 * VECTOR;
+    dest += 4 * VECTOR;
+  }
+  std::memcpy(dest, src, bytes);
+  _mm_sfence();
+}
+#endif
+
 // A fat pointer with size
 class BlobPtr {
   size_t element_size;
@@ -53,6 +94,20 @@ public:
 #endif
     std::memcpy(dst, data, element_size * n);
   }
+  /// Like `copy_nonoverlapping`, for bulk copies. From
+  /// `policy::streaming_store_min_bytes()` on, the start of the destination
+  /// would be evicted before it is read again anyway, so the copy bypasses
+  /// the cache.
+  void copy_streaming(BlobPtr dst, size_t n) const {
+    size_t bytes = element_size * n;
+#if DRIFTSORT_HAS_STREAMING_STORES
+    if (bytes >= policy::streaming_store_min_bytes()) {
+      stream_bytes(dst.data, data, bytes);
+      return;
+    }
+#endif
+    std::memcpy(dst, data, bytes);
+  }
   void *get() const { return data; }
   size_t size() const { return element_size; }
   constexpr operator void *() const { return data; }
@@ -68,6 +123,68 @@ public:
   }
 };
 
+/// Wraps a comparator whose result is zero exactly for equal elements, as
+/// the C standard requires of qsort comparators. Sorting then separates the
+/// elements equal to a pivot in the same pass that partitions the rest.
+/// Comparators that only distinguish "less" from "not less" must not be
+/// wrapped.
+template <class Comparator> struct ThreeWay {
+  Comparator compare;
+  int operator()(const void *a, const void *b) const { return compare(a, b); }
+};
+
+template <class Comparator>
+constexpr ThreeWay<Comparator> three_way(Comparator compare) {
+  return {compare};
+}
+
+template <class Comparator> inline constexpr bool is_three_way = false;
+template <class Comparator>
+inline constexpr bool is_three_way<ThreeWay<Comparator>> = true;
+
+/// Wraps a comparator that is expensive enough to outweigh everything else,
+/// such as one calling into a collator or a scripting engine. Sorting then
+/// uses the algorithms that call it the fewest times rather than the fastest
+/// ones, and counts the calls in `*count`. On random input that takes close
+/// to log2(length!) comparisons; inputs with few distinct keys take more
+/// than the default, whose quicksort partitions out equal elements.
+template <class Comparator> struct FewestCompares {
+  Comparator compare;
+  size_t *count;
+  int operator()(const void *a, const void *b) const {
+    ++*count;
+    return compare(a, b);
+  }
+};
+
+template <class Comparator>
+constexpr FewestCompares<Comparator> fewest_compares(Comparator compare,
+                                                     size_t &count) {
+  return {compare, &count};
+}
+
+template <class Comparator> inline constexpr bool is_fewest_compares = false;
+template <class Comparator>
+inline constexpr bool is_fewest_compares<FewestCompares<Comparator>> = true;
+
+class SortControl;
+
+/// Wraps a comparator for a sort that `control` can cancel and that reports
+/// its progress there, see `sort_cancellable`. The wrapped comparator may
+/// itself be a `ThreeWay` one.
+template <class Comparator> struct Cancellable {
+  Comparator compare;
+  SortControl *control;
+  int operator()(const void *a, const void *b) const { return compare(a, b); }
+};
+
+template <class Comparator> inline constexpr bool is_cancellable = false;
+template <class Comparator>
+inline constexpr bool is_cancellable<Cancellable<Comparator>> = true;
+template <class Comparator>
+inline constexpr bool is_three_way<Cancellable<Comparator>> =
+    is_three_way<Comparator>;
+
 template <class Comparator> class BlobComparator {
   size_t element_size;
   size_t alignment;
@@ -83,6 +200,31 @@ public:
   bool operator()(const void *a, const void *b) const {
     return compare(a, b) < 0;
   }
+  /// Whether `compare_three_way` tells equal elements apart from greater
+  /// ones.
+  static constexpr bool THREE_WAY = is_three_way<Comparator>;
+  /// Whether to minimize calls to the comparator, see `FewestCompares`.
+  static constexpr bool FEWEST_COMPARES = is_fewest_compares<Comparator>;
+  /// Whether the sort can be cancelled, see `Cancellable`.
+  static constexpr bool CANCELLABLE = is_cancellable<Comparator>;
+  int compare_three_way(const void *a, const void *b) const {
+    return compare(a, b);
+  }
+  /// Whether a `Cancellable` sort is to stop. Sorts only ask between runs,
+  /// merges and partitions, where the array holds all of its elements, and
+  /// then return at once.
+  bool cancelled() const {
+    if constexpr (CANCELLABLE)
+      return compare.control->should_stop();
+    else
+      return false;
+  }
+  /// Reports that a pass over `length` elements is done, see
+  /// `SortControl::progress`.
+  void progress(size_t length) const {
+    if constexpr (CANCELLABLE)
+      compare.control->advance(length);
+  }
   size_t size() const { return element_size; }
   size_t align() const { return alignment; }
   size_t alloca_padding() const {
@@ -0,0 +1,164 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/argsort.h"
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/key.h"
+#include "driftsort/permute.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+namespace cached {
+/// A tie breaker that keeps elements with equal keys in their order.
+struct NoTieBreak {
+  int operator()(const void *, const void *) const { return 0; }
+};
+
+/// The key description `key::prefix` encodes an arithmetic `Key` with.
+template <typename Key> inline constexpr KeySpec arithmetic_spec() {
+  static_assert(std::is_arithmetic_v<Key> &&
+                    (sizeof(Key) == 1 || sizeof(Key) == 2 ||
+                     sizeof(Key) == 4 || sizeof(Key) == 8),
+                "keys are integers of 1 to 8 bytes, floats or doubles");
+  KeyType type = std::is_floating_point_v<Key> ? KeyType::floating
+                 : std::is_signed_v<Key>       ? KeyType::signed_int
+                                               : KeyType::unsigned_int;
+  return {0, sizeof(Key), type, false};
+}
+
+/// Indexes the element indices of (prefix, index) pairs, for
+/// `permute::apply`.
+template <typename Index> struct PairIndices {
+  indirect::KeyIndex<Index> *pairs;
+  Index &operator[](size_t i) const { return pairs[i].index; }
+};
+
+/// Sorts the (key prefix, element index) pairs of `data`, breaking prefix
+/// ties with `tail(i, j)` on element indices and then with `tie_break` on
+/// the elements, and moves the elements into the order of the pairs.
+template <typename Index, typename Tail, typename TieBreak>
+inline void sort_and_permute(void *data, size_t length, size_t element_size,
+                             indirect::KeyIndex<Index> *pairs, Tail tail,
+                             TieBreak &tie_break) {
+  const std::byte *base = static_cast<const std::byte *>(data);
+  driftsort::qsort_r(
+      pairs, length, sizeof(indirect::KeyIndex<Index>),
+      driftsort::three_way([base, element_size, &tail,
+                            &tie_break](const void *a, const void *b) {
+        auto x = static_cast<const indirect::KeyIndex<Index> *>(a);
+        auto y = static_cast<const indirect::KeyIndex<Index> *>(b);
+        if (x->prefix != y->prefix)
+          return x->prefix < y->prefix ? -1 : 1;
+        if (int res = tail(x->index, y->index); res != 0)
+          return res;
+        return tie_break(base + x->index * element_size,
+                         base + y->index * element_size);
+      }));
+  permute::apply(data, length, element_size, PairIndices<Index>{pairs});
+}
+
+template <typename Index, typename KeyOf, typename TieBreak>
+inline bool sort_arithmetic(void *data, size_t length, size_t element_size,
+                            KeyOf &key_of, TieBreak &tie_break) {
+  using Key = std::remove_cvref_t<decltype(key_of(data))>;
+  constexpr KeySpec spec = arithmetic_spec<Key>();
+  void *raw_pairs =
+      ::operator new(length * sizeof(indirect::KeyIndex<Index>), std::nothrow);
+  if (DRIFTSORT_UNLIKELY(raw_pairs == nullptr))
+    return false;
+  auto pairs = static_cast<indirect::KeyIndex<Index> *>(raw_pairs);
+  const std::byte *base = static_cast<const std::byte *>(data);
+  for (size_t i = 0; i < length; i++) {
+    Key key = key_of(base + i * element_size);
+    pairs[i] = {key::prefix(&key, spec), static_cast<Index>(i)};
+  }
+  sort_and_permute(
+      data, length, element_size, pairs, [](Index, Index) { return 0; },
+      tie_break);
+  ::operator delete(raw_pairs);
+  return true;
+}
+
+template <typename Index, typename WriteKey, typename TieBreak>
+inline bool sort_bytes(void *data, size_t length, size_t element_size,
+                       size_t key_size, WriteKey &write_key,
+                       TieBreak &tie_break) {
+  KeySpec spec{0, key_size, KeyType::bytes, false};
+  // Keys of up to eight bytes fit into the prefix. Longer ones are kept
+  // after the pairs to break prefix ties.
+  bool exact = key::prefix_is_exact(spec);
+  size_t pair_bytes = length * sizeof(indirect::KeyIndex<Index>);
+  size_t key_bytes = exact ? 0 : length * key_size;
+  if (!exact && key_bytes / key_size != length)
+    return false;
+  void *raw_pairs = ::operator new(pair_bytes + key_bytes, std::nothrow);
+  if (DRIFTSORT_UNLIKELY(raw_pairs == nullptr))
+    return false;
+  auto pairs = static_cast<indirect::KeyIndex<Index> *>(raw_pairs);
+  std::byte *keys = static_cast<std::byte *>(raw_pairs) + pair_bytes;
+  const std::byte *base = static_cast<const std::byte *>(data);
+  for (size_t i = 0; i < length; i++) {
+    std::byte short_key[sizeof(uint64_t)];
+    std::byte *key = exact ? short_key : keys + i * key_size;
+    write_key(base + i * element_size, static_cast<void *>(key));
+    pairs[i] = {key::prefix(key, spec), static_cast<Index>(i)};
+  }
+  sort_and_permute(
+      data, length, element_size, pairs,
+      [keys, key_size, &spec](Index i, Index j) {
+        return key::compare_tail(keys + i * key_size, keys + j * key_size,
+                                 spec);
+      },
+      tie_break);
+  ::operator delete(raw_pairs);
+  return true;
+}
+} // namespace cached
+
+/// Sorts `data` stably by the key `key_of(element)` returns, an integer, a
+/// float or a double, calling `key_of` exactly once per element. This pays
+/// off over `qsort_r` when deriving the key is what makes comparisons
+/// expensive, as a comparator derives it about log2(length) times per
+/// element.
+///
+/// The keys are sorted together with the element indices, with doubles in
+/// the IEEE totalOrder of `KeyType::floating`, and the elements are then
+/// moved into place once. Elements with equal keys are ordered by the
+/// three-way comparator `tie_break` if given, and otherwise keep their
+/// order. Returns false without sorting if the keys cannot be allocated.
+template <typename KeyOf, typename TieBreak = cached::NoTieBreak>
+inline bool sort_by_cached_key(void *data, size_t length, size_t element_size,
+                               KeyOf key_of, TieBreak tie_break = {}) {
+  if (argsort_index_size(length) == sizeof(uint32_t))
+    return cached::sort_arithmetic<uint32_t>(data, length, element_size,
+                                             key_of, tie_break);
+  return cached::sort_arithmetic<uint64_t>(data, length, element_size, key_of,
+                                           tie_break);
+}
+
+/// Like `sort_by_cached_key` for keys of `key_size` bytes compared like
+/// memcmp, such as collation keys. `write_key(element, key)` stores the key
+/// of `element` to `key`, and is called exactly once per element. Keys of up
+/// to eight bytes are sorted as integers; longer ones are stored in full.
+template <typename WriteKey, typename TieBreak = cached::NoTieBreak>
+inline bool sort_by_cached_key_bytes(void *data, size_t length,
+                                     size_t element_size, size_t key_size,
+                                     WriteKey write_key,
+                                     TieBreak tie_break = {}) {
+  if (argsort_index_size(length) == sizeof(uint32_t))
+    return cached::sort_bytes<uint32_t>(data, length, element_size, key_size,
+                                        write_key, tie_break);
+  return cached::sort_bytes<uint64_t>(data, length, element_size, key_size,
+                                      write_key, tie_break);
+}
+} // namespace DRIFTSORT_HIDDEN driftsort
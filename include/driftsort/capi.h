@@ -0,0 +1,374 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int (*driftsort_compar_fn_t)(const void *, const void *, void *);
+
+/// Key types of `struct driftsort_key`, see driftsort::KeyType.
+enum {
+  DRIFTSORT_KEY_UNSIGNED = 0,
+  DRIFTSORT_KEY_SIGNED = 1,
+  DRIFTSORT_KEY_FLOAT = 2,
+  DRIFTSORT_KEY_BYTES = 3,
+};
+
+/// A key of `width` bytes stored at `offset` inside each element.
+struct driftsort_key {
+  size_t offset;
+  size_t width;
+  int type;
+  int descending;
+};
+
+/// A string given by pointer and length. It may contain zero bytes.
+struct driftsort_string {
+  const char *data;
+  size_t length;
+};
+
+/// Sorts NUL-terminated strings. The result is the same as a stable sort with
+/// `strcmp`.
+void driftsort_sort_cstrings(const char **strings, size_t nmemb);
+
+/// Sorts strings with explicit length by their bytes as unsigned char, shorter
+/// prefixes first. The sort is stable.
+void driftsort_sort_strings(struct driftsort_string *strings, size_t nmemb);
+
+/// Size in bytes of the indices written by the argsort functions for `nmemb`
+/// elements: 4 if all indices fit into 32 bits, 8 otherwise.
+size_t driftsort_argsort_index_size(size_t nmemb);
+
+/// Writes the permutation that stably sorts `base` to `perm`, and its inverse
+/// to `ranks` unless it is NULL. `base` is not modified. Both arrays hold
+/// `driftsort_argsort_index_size(nmemb)`-byte indices.
+void driftsort_argsort_r(const void *base, size_t nmemb, size_t size,
+                         void *perm, void *ranks, driftsort_compar_fn_t compar,
+                         void *arg);
+
+/// Like driftsort_argsort_r, but orders the elements by `key`. Returns 0 on
+/// success and -1 if `key` is invalid.
+int driftsort_argsort_key(const void *base, size_t nmemb, size_t size,
+                          const struct driftsort_key *key, void *perm,
+                          void *ranks);
+
+/// Reorders `base` so that element `k` is the one a stable sort would put
+/// there, with no greater element before and no smaller one after it. Does
+/// nothing if `k >= nmemb`.
+void driftsort_nth_element_r(void *base, size_t nmemb, size_t size, size_t k,
+                             driftsort_compar_fn_t compar, void *arg);
+
+/// Reorders `base` so that its first `k` elements are its `k` smallest in
+/// stable sorted order. The order of the other elements is unspecified.
+void driftsort_partial_sort_r(void *base, size_t nmemb, size_t size, size_t k,
+                              driftsort_compar_fn_t compar, void *arg);
+
+/// Copies the `min(k, nmemb)` smallest elements of `base` to `dest` in stable
+/// sorted order. `base` is not modified and must not overlap `dest`.
+void driftsort_top_k_r(const void *base, size_t nmemb, size_t size, size_t k,
+                       void *dest, driftsort_compar_fn_t compar, void *arg);
+
+/// Lazily sorts an array, see driftsort::LazySorter.
+struct driftsort_cursor;
+
+/// Starts producing the elements of `base` in stable sorted order. The array
+/// is reordered in place as elements are taken and must outlive the cursor.
+/// Returns NULL if the cursor cannot be allocated.
+struct driftsort_cursor *driftsort_cursor_new_r(void *base, size_t nmemb,
+                                                size_t size,
+                                                driftsort_compar_fn_t compar,
+                                                void *arg);
+
+/// Returns the next element in sorted order, or NULL once all elements have
+/// been taken. Taken elements stay at the front of the array.
+void *driftsort_cursor_next(struct driftsort_cursor *cursor);
+
+/// Frees a cursor. The elements not yet taken are left in unspecified order.
+void driftsort_cursor_free(struct driftsort_cursor *cursor);
+
+/// Sorts elements pushed in chunks, see driftsort::StreamSorter.
+struct driftsort_stream;
+
+/// Creates an empty stream sorter for elements of `size` bytes. Returns NULL
+/// if it cannot be allocated.
+struct driftsort_stream *driftsort_stream_new_r(size_t size,
+                                                driftsort_compar_fn_t compar,
+                                                void *arg);
+
+/// Appends and sorts `nmemb` elements. Returns 0 on success and -1 without
+/// appending anything if memory runs out.
+int driftsort_stream_push(struct driftsort_stream *stream, const void *base,
+                          size_t nmemb);
+
+/// Returns the pushed elements and stores the length of their sorted prefix
+/// in `*nmemb`. The pointer is invalidated by the next push.
+const void *driftsort_stream_sorted_prefix(struct driftsort_stream *stream,
+                                           size_t *nmemb);
+
+/// Sorts all pushed elements, stores their number in `*nmemb` and returns
+/// them. The pointer is invalidated by the next push.
+const void *driftsort_stream_finish(struct driftsort_stream *stream,
+                                    size_t *nmemb);
+
+/// Frees a stream sorter and its elements.
+void driftsort_stream_free(struct driftsort_stream *stream);
+
+/// Sorts a file of `size`-byte records by `key`, see driftsort::sort_file.
+/// The result goes to `output`, or back to `input` if `output` is NULL.
+/// Uses about `memory_budget` bytes and spills runs to `temp_dir`. Returns 0
+/// on success or an errno value. Only available on POSIX systems.
+int driftsort_sort_file(const char *input, const char *output, size_t size,
+                        const struct driftsort_key *key, size_t memory_budget,
+                        const char *temp_dir);
+
+/// A sorted array of `length` elements, see driftsort::SortedRun.
+struct driftsort_run {
+  const void *data;
+  size_t length;
+};
+
+/// Merges the sorted `runs[..nruns]` into `dest`, which must hold all their
+/// elements. Equal elements keep the order of their runs. Returns 0 on
+/// success and -1 if memory runs out.
+int driftsort_merge_runs_r(const struct driftsort_run *runs, size_t nruns,
+                           size_t size, void *dest,
+                           driftsort_compar_fn_t compar, void *arg);
+
+/// Like driftsort_merge_runs_r, but passes the merged elements to `sink` in
+/// batches of `nmemb` elements instead of storing them.
+int driftsort_merge_runs_sink_r(const struct driftsort_run *runs,
+                                size_t nruns, size_t size,
+                                void (*sink)(const void *elements,
+                                             size_t nmemb, void *sink_arg),
+                                void *sink_arg, driftsort_compar_fn_t compar,
+                                void *arg);
+
+/// Sorts `base` and removes duplicates, keeping the first of every group of
+/// equal elements. Returns the number of distinct elements, which are then
+/// the first ones of `base`.
+size_t driftsort_sort_unique_r(void *base, size_t nmemb, size_t size,
+                               driftsort_compar_fn_t compar, void *arg);
+
+/// Sorts `base` and calls `reduce` on every group of equal elements in
+/// sorted order, which folds the group into its first element. Returns the
+/// number of groups, whose reduced elements are then the first ones of
+/// `base`.
+size_t driftsort_sort_group_r(void *base, size_t nmemb, size_t size,
+                              void (*reduce)(void *group, size_t nmemb,
+                                             void *reduce_arg),
+                              void *reduce_arg, driftsort_compar_fn_t compar,
+                              void *arg);
+
+/// An array of `length` elements, see driftsort::Segment.
+struct driftsort_segment {
+  void *data;
+  size_t length;
+};
+
+/// Sorts each of `segments[..nsegments]` independently with one setup and
+/// one scratch buffer for the whole batch. Up to `nthreads` threads share a
+/// large batch, the calling one included, and `compar` must then be safe to
+/// call from all of them. 0 and 1 sort on the calling thread only.
+void driftsort_sort_segments_r(const struct driftsort_segment *segments,
+                               size_t nsegments, size_t size, size_t nthreads,
+                               driftsort_compar_fn_t compar, void *arg);
+
+/// Sorts the `nsegments` segments `base[offsets[i]..offsets[i + 1]]`
+/// independently, like driftsort_sort_segments_r. `offsets` holds
+/// `nsegments + 1` indices.
+void driftsort_sort_csr_r(void *base, const size_t *offsets, size_t nsegments,
+                          size_t size, size_t nthreads,
+                          driftsort_compar_fn_t compar, void *arg);
+
+/// Like qsort_r for elements aligned to `alignment`, a power of two of at
+/// most 4096 that divides `size` and the address of `base`. Unlike qsort_r,
+/// which sorts elements it cannot rule out to be aligned to more than 32
+/// bytes with a heap sort, this sorts them stably. Returns 0 on success and
+/// -1 without sorting if `alignment` is invalid.
+int driftsort_qsort_aligned_r(void *base, size_t nmemb, size_t size,
+                              size_t alignment, driftsort_compar_fn_t compar,
+                              void *arg);
+
+/// The ISA level whose kernels qsort and qsort_r run, "baseline" or
+/// "x86-64-v2" to "x86-64-v4". The library picks the highest level the CPU
+/// supports when it is loaded; the environment variable DRIFTSORT_ISA can
+/// name a lower one.
+const char *driftsort_isa(void);
+
+/// Sorts `base` stably by the keys `key(element, arg)` returns, calling it
+/// exactly once per element, see driftsort::sort_by_cached_key. Elements
+/// with equal keys are ordered by `compar` unless it is NULL, in which case
+/// they keep their order. Returns 0 on success and -1 without sorting if
+/// memory runs out.
+int driftsort_sort_by_u64_key_r(void *base, size_t nmemb, size_t size,
+                                uint64_t (*key)(const void *, void *),
+                                driftsort_compar_fn_t compar, void *arg);
+
+/// Like driftsort_sort_by_u64_key_r for double keys, ordered by IEEE
+/// totalOrder: -NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN.
+int driftsort_sort_by_double_key_r(void *base, size_t nmemb, size_t size,
+                                   double (*key)(const void *, void *),
+                                   driftsort_compar_fn_t compar, void *arg);
+
+/// Like driftsort_sort_by_u64_key_r for keys of `key_size` bytes compared
+/// like memcmp, which `key(element, dest, arg)` writes to `dest`.
+int driftsort_sort_by_bytes_key_r(void *base, size_t nmemb, size_t size,
+                                  size_t key_size,
+                                  void (*key)(const void *, void *, void *),
+                                  driftsort_compar_fn_t compar, void *arg);
+
+/// Like qsort_r for comparators so expensive that nothing else counts:
+/// sorts stably with as few calls to `compar` as possible, about
+/// log2(nmemb!) on random input, see driftsort::FewestCompares. Returns the
+/// number of calls.
+size_t driftsort_qsort_fewest_compares_r(void *base, size_t nmemb, size_t size,
+                                         driftsort_compar_fn_t compar,
+                                         void *arg);
+
+/// What a sample of about sqrt(nmemb) places says about the order of an
+/// array, see driftsort::presort::Estimate.
+struct driftsort_order_estimate {
+  size_t pairs;
+  size_t descents;
+  size_t spread_pairs;
+  size_t spread_descents;
+};
+
+/// Samples `base` like qsort_r does before sorting arrays of 4096 elements
+/// or more, stores the counts to `estimate`, and returns the name of the
+/// strategy the sort would take: "presorted", "runs" or "shuffled".
+const char *
+driftsort_estimate_order_r(void *base, size_t nmemb, size_t size,
+                           struct driftsort_order_estimate *estimate,
+                           driftsort_compar_fn_t compar, void *arg);
+
+/// A sort running on a thread of its own, see driftsort::sort_async.
+struct driftsort_task;
+
+/// Starts sorting `base` like qsort_r on a new thread, and cancels the sort
+/// once `timeout_ns` nanoseconds have passed unless it is 0. `base` must not
+/// be accessed until the task has ended. Returns NULL if the task cannot be
+/// allocated or its thread cannot be started.
+struct driftsort_task *driftsort_sort_async_r(void *base, size_t nmemb,
+                                              size_t size, uint64_t timeout_ns,
+                                              driftsort_compar_fn_t compar,
+                                              void *arg);
+
+/// Asks the sort to stop at its next run, merge or partition. May be called
+/// from any thread.
+void driftsort_task_cancel(struct driftsort_task *task);
+
+/// Returns 1 while the sort runs, 0 once it has sorted `base` and -1 once it
+/// has stopped because it was cancelled or timed out, with `base` a
+/// permutation of its elements. Stores an estimate of the fraction done to
+/// `progress` unless it is NULL, see driftsort::SortControl::progress.
+int driftsort_task_poll(struct driftsort_task *task, double *progress);
+
+/// Waits for the sort to end and returns what driftsort_task_poll returns
+/// then, 0 or -1.
+int driftsort_task_wait(struct driftsort_task *task);
+
+/// Waits for the sort to end and frees the task. Call driftsort_task_cancel
+/// first not to wait for a sort that is no longer needed.
+void driftsort_task_free(struct driftsort_task *task);
+
+/// What is known about the order of an array, see driftsort::SortHints.
+struct driftsort_hints {
+  size_t sorted_prefix;
+  const size_t *run_ends;
+  size_t run_count;
+  const size_t *dirty;
+  size_t dirty_count;
+};
+
+/// Sorts `base` like qsort_r, relying on `hints` for what is already sorted:
+/// a sorted prefix, after which come either unsorted elements or sorted runs
+/// ending at `run_ends`, and the indices of `dirty` elements that may be
+/// anywhere. Costs O(k log(nmemb)) comparisons for k unsorted and dirty
+/// elements, plus those to merge the runs. Equal elements keep their order,
+/// except that unsorted and dirty ones go after sorted ones. Returns 0 on
+/// success and -1 without sorting if `hints` are invalid.
+int driftsort_sort_hinted_r(void *base, size_t nmemb, size_t size,
+                            const struct driftsort_hints *hints,
+                            driftsort_compar_fn_t compar, void *arg);
+
+/// A column of `nmemb` elements of `size` bytes, see driftsort::Column.
+struct driftsort_column {
+  void *data;
+  size_t size;
+};
+
+/// Sorts the rows of a table stored by columns by its `keys` column, stably,
+/// and reorders the `columns[..ncolumns]` of the other fields of the rows
+/// along with it. Each column is reordered once at the end. Returns 0 on
+/// success and -1 without sorting if memory runs out.
+int driftsort_sort_columns_r(void *keys, size_t nmemb, size_t size,
+                             const struct driftsort_column *columns,
+                             size_t ncolumns, driftsort_compar_fn_t compar,
+                             void *arg);
+
+/// Like driftsort_sort_columns_r, but orders the rows by `key` inside each
+/// element of `keys`. Returns -1 without sorting if `key` is invalid as well.
+int driftsort_sort_columns_key(void *keys, size_t nmemb, size_t size,
+                               const struct driftsort_key *key,
+                               const struct driftsort_column *columns,
+                               size_t ncolumns);
+
+/// Writes the union of the sorted `a[..na]` and `b[..nb]` to `dest`, which
+/// must hold `na + nb` elements and not overlap them, and returns its length.
+/// An element found m times in `a` and n times in `b` is written m times from
+/// `a` and then max(n - m, 0) times from `b`, as by std::set_union.
+size_t driftsort_set_union_r(const void *a, size_t na, const void *b,
+                             size_t nb, size_t size, void *dest,
+                             driftsort_compar_fn_t compar, void *arg);
+
+/// Like driftsort_set_union_r, but writes min(m, n) elements from `a`.
+/// `dest` must hold `min(na, nb)` elements.
+size_t driftsort_set_intersection_r(const void *a, size_t na, const void *b,
+                                    size_t nb, size_t size, void *dest,
+                                    driftsort_compar_fn_t compar, void *arg);
+
+/// Like driftsort_set_union_r, but writes the last max(m - n, 0) elements
+/// from `a`. `dest` must hold `na` elements.
+size_t driftsort_set_difference_r(const void *a, size_t na, const void *b,
+                                  size_t nb, size_t size, void *dest,
+                                  driftsort_compar_fn_t compar, void *arg);
+
+/// Like driftsort_set_union_r, but writes the last |m - n| elements from the
+/// array that has more of them. `dest` must hold `na + nb` elements.
+size_t driftsort_set_symmetric_difference_r(const void *a, size_t na,
+                                            const void *b, size_t nb,
+                                            size_t size, void *dest,
+                                            driftsort_compar_fn_t compar,
+                                            void *arg);
+
+/// A group of equal elements `a[a_start..a_end]` and `b[b_start..b_end]`,
+/// see driftsort::JoinRange.
+struct driftsort_join_range {
+  size_t a_start;
+  size_t a_end;
+  size_t b_start;
+  size_t b_end;
+};
+
+/// Writes a driftsort_join_range to `dest` for each group of equal elements
+/// the sorted `a[..na]` and `b[..nb]` have in common, in sorted order, and
+/// returns their number. `dest` must hold `min(na, nb)` ranges.
+size_t driftsort_merge_join_r(const void *a, size_t na, const void *b,
+                              size_t nb, size_t size,
+                              struct driftsort_join_range *dest,
+                              driftsort_compar_fn_t compar, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
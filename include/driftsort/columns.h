@@ -0,0 +1,218 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/argsort.h"
+#include "driftsort/common.h"
+#include "driftsort/key.h"
+#include "driftsort/permute.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+/// A column of elements of `element_size` bytes, as many as its table has
+/// rows.
+struct Column {
+  void *data;
+  size_t element_size;
+};
+
+namespace columns {
+/// Copies `src[perm[i]]` to `dest[i]` for all `length` rows, with copies
+/// of a fixed size if `SIZE` is not zero.
+template <size_t SIZE, typename Perm>
+inline void gather_fixed(std::byte *dest, const std::byte *src, size_t length,
+                         size_t element_size, const Perm &perm) {
+  size_t size = SIZE == 0 ? element_size : SIZE;
+  for (size_t i = 0; i < length; i++)
+    std::memcpy(dest + i * size, src + static_cast<size_t>(perm[i]) * size,
+                size);
+}
+
+template <typename Perm>
+inline void gather(std::byte *dest, const std::byte *src, size_t length,
+                   size_t element_size, const Perm &perm) {
+  switch (element_size) {
+  case 1:
+    return gather_fixed<1>(dest, src, length, element_size, perm);
+  case 2:
+    return gather_fixed<2>(dest, src, length, element_size, perm);
+  case 4:
+    return gather_fixed<4>(dest, src, length, element_size, perm);
+  case 8:
+    return gather_fixed<8>(dest, src, length, element_size, perm);
+  case 16:
+    return gather_fixed<16>(dest, src, length, element_size, perm);
+  default:
+    return gather_fixed<0>(dest, src, length, element_size, perm);
+  }
+}
+
+/// Reorders every column of `columns[..count]` so that row `i` becomes the
+/// one that was at `perm[i]`, like `permute::apply` does for one array.
+/// `perm` is anything that can be indexed, such as a pointer to indices.
+///
+/// Gathers one column at a time into a buffer for the widest column, and
+/// copies it back. If the buffer cannot be allocated, follows the cycles of
+/// `perm` once and swaps the rows of all columns along them instead, which
+/// leaves `perm` as the identity.
+template <typename Perm>
+inline void apply(const Column *columns, size_t count, size_t length,
+                  Perm &&perm) {
+  if (length < 2)
+    return;
+  size_t widest = 0;
+  for (size_t c = 0; c < count; c++)
+    widest = std::max(widest, columns[c].element_size);
+  void *buffer = ::operator new(length * widest, std::nothrow);
+  if (DRIFTSORT_LIKELY(buffer != nullptr)) {
+    auto gathered = static_cast<std::byte *>(buffer);
+    for (size_t c = 0; c < count; c++) {
+      auto data = static_cast<std::byte *>(columns[c].data);
+      size_t size = columns[c].element_size;
+      gather(gathered, data, length, size, perm);
+      std::memcpy(data, gathered, length * size);
+    }
+    ::operator delete(buffer);
+    return;
+  }
+  permute::apply_cycles(length, perm, [&](size_t i, size_t j) {
+    for (size_t c = 0; c < count; c++) {
+      auto data = static_cast<std::byte *>(columns[c].data);
+      size_t size = columns[c].element_size;
+      permute::swap_bytes(data + i * size, data + j * size, size);
+    }
+  });
+}
+
+/// Keys up to this size are sorted in records with their row index, so
+/// that comparisons read consecutive memory instead of following indices.
+inline constexpr size_t MAX_INLINE_KEY_BYTES = 32;
+
+/// Indexes the row indices stored at `offset` in each record, for `apply`.
+template <typename Index> struct RecordIndices {
+  std::byte *records;
+  size_t stride;
+  size_t offset;
+  Index &operator[](size_t i) const {
+    return *reinterpret_cast<Index *>(records + i * stride + offset);
+  }
+};
+
+/// Sorts records of each key followed by its row index, copies the sorted
+/// keys back and gathers the `payloads[..count]` by the indices. Returns
+/// false without doing anything if the records cannot be allocated with
+/// the alignment of the keys.
+template <typename Index, typename Comp>
+inline bool sort_records(void *keys, size_t length, size_t key_size,
+                         const Column *payloads, size_t count, Comp compare) {
+  size_t alignment = guess_alignment(key_size, keys);
+  if (alignment > alignof(std::max_align_t))
+    return false;
+  size_t offset = key_size + ((-key_size) & (sizeof(Index) - 1));
+  size_t stride = offset + sizeof(Index);
+  stride += (-stride) & (alignment - 1);
+  void *raw = ::operator new(length * stride, std::nothrow);
+  if (DRIFTSORT_UNLIKELY(raw == nullptr))
+    return false;
+  auto records = static_cast<std::byte *>(raw);
+  auto key_bytes = static_cast<std::byte *>(keys);
+  RecordIndices<Index> indices{records, stride, offset};
+  for (size_t i = 0; i < length; i++) {
+    std::memcpy(records + i * stride, key_bytes + i * key_size, key_size);
+    indices[i] = static_cast<Index>(i);
+  }
+  qsort_r(records, length, stride, compare);
+  for (size_t i = 0; i < length; i++)
+    std::memcpy(key_bytes + i * key_size, records + i * stride, key_size);
+  apply(payloads, count, length, indices);
+  ::operator delete(raw);
+  return true;
+}
+
+/// Sorts the rows of the table whose first column is `keys` and whose
+/// others are `payloads[..count]` by the permutation `argsort_into` writes.
+template <typename Index, typename ArgsortInto>
+inline bool sort_by_permutation(const Column &keys, const Column *payloads,
+                                size_t count, size_t length,
+                                ArgsortInto argsort_into) {
+  // The key column goes first, after the permutation.
+  size_t perm_bytes = length * sizeof(Index);
+  perm_bytes += (-perm_bytes) & (alignof(Column) - 1);
+  void *raw = ::operator new(perm_bytes + (count + 1) * sizeof(Column),
+                             std::nothrow);
+  if (DRIFTSORT_UNLIKELY(raw == nullptr))
+    return false;
+  auto perm = static_cast<Index *>(raw);
+  auto all = reinterpret_cast<Column *>(static_cast<std::byte *>(raw) +
+                                        perm_bytes);
+  all[0] = keys;
+  std::copy(payloads, payloads + count, all + 1);
+  bool sorted = argsort_into(perm);
+  if (sorted)
+    apply(all, count + 1, length, perm);
+  ::operator delete(raw);
+  return sorted;
+}
+} // namespace columns
+
+/// Sorts the rows of a table stored by columns: `keys[..length]`, with
+/// elements of `key_size` bytes, and the `payloads[..count]` columns of as
+/// many rows. Rows are ordered by their keys with `compare`, stably, and
+/// each payload column is then reordered with one gather, so the rows are
+/// never put together. Keys of up to `columns::MAX_INLINE_KEY_BYTES` are
+/// sorted along with their row indices, longer ones through the indices.
+///
+/// Returns false without sorting if memory for the permutation runs out.
+template <typename Comp>
+inline bool sort_columns(void *keys, size_t length, size_t key_size,
+                         const Column *payloads, size_t count, Comp compare) {
+  if (length < 2 || key_size == 0)
+    return true;
+  bool narrow_indices = argsort_index_size(length) == sizeof(uint32_t);
+  if (key_size <= columns::MAX_INLINE_KEY_BYTES &&
+      (narrow_indices ? columns::sort_records<uint32_t>(
+                            keys, length, key_size, payloads, count, compare)
+                      : columns::sort_records<uint64_t>(
+                            keys, length, key_size, payloads, count, compare)))
+    return true;
+  Column key_column{keys, key_size};
+  auto sort = [&](auto *perm) {
+    argsort(keys, length, key_size, perm, decltype(perm){}, compare);
+    return true;
+  };
+  if (narrow_indices)
+    return columns::sort_by_permutation<uint32_t>(key_column, payloads, count,
+                                                  length, sort);
+  return columns::sort_by_permutation<uint64_t>(key_column, payloads, count,
+                                                length, sort);
+}
+
+/// Like `sort_columns`, but orders the rows by the key `spec` describes in
+/// each element of `keys`, see `argsort_key`. Returns false without sorting
+/// if `spec` is invalid as well.
+inline bool sort_columns_key(void *keys, size_t length, size_t key_size,
+                             const KeySpec &spec, const Column *payloads,
+                             size_t count) {
+  if (!key::is_valid(spec, key_size))
+    return false;
+  if (length < 2)
+    return true;
+  Column key_column{keys, key_size};
+  auto sort = [&](auto *perm) {
+    return argsort_key(keys, length, key_size, spec, perm, decltype(perm){});
+  };
+  if (argsort_index_size(length) == sizeof(uint32_t))
+    return columns::sort_by_permutation<uint32_t>(key_column, payloads, count,
+                                                  length, sort);
+  return columns::sort_by_permutation<uint64_t>(key_column, payloads, count,
+                                                length, sort);
+}
+} // namespace DRIFTSORT_HIDDEN driftsort
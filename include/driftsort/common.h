@@ -47,6 +47,14 @@
   static_cast<std::byte *>(_malloca(comp.size() * n + comp.alloca_padding()))
 #endif
 
+#if __has_builtin(__builtin_prefetch)
+#define DRIFTSORT_PREFETCH_READ(addr) __builtin_prefetch((addr), 0, 3)
+#define DRIFTSORT_PREFETCH_WRITE(addr) __builtin_prefetch((addr), 1, 3)
+#else
+#define DRIFTSORT_PREFETCH_READ(addr) (void)(addr)
+#define DRIFTSORT_PREFETCH_WRITE(addr) (void)(addr)
+#endif
+
 #if __has_attribute(visibility)
 #define DRIFTSORT_HIDDEN [[gnu::visibility("hidden")]]
 #define DRIFTSORT_EXPORT [[gnu::visibility("default")]]
@@ -9,7 +9,9 @@
 #include "driftsort/blob.h"
 #include "driftsort/common.h"
 #include "driftsort/merge.h"
+#include "driftsort/policy.h"
 #include "driftsort/quicksort.h"
+#include "driftsort/smallsort.h"
 #include <algorithm>
 #include <bit>
 #include <cstddef>
@@ -17,11 +19,51 @@
 
 namespace DRIFTSORT_HIDDEN driftsort {
 namespace drift {
+/// Sorts `v[..length]` by top-down merge sort, with `small::small_sort_general`
+/// for the leaves, for comparators expensive enough that comparisons are all
+/// that counts. Quicksort compares about 1.39 n log2(n) times, a balanced
+/// merge sort no more than n log2(n). `scratch` must hold `length / 2`
+/// elements and no fewer than the small-sort threshold plus 16.
+template <typename Comp>
+inline void merge_sort(void *raw_v, size_t length, void *raw_scratch,
+                       size_t scratch_length,
+                       const BlobComparator<Comp> &comp) {
+  if (comp.cancelled())
+    return;
+  if (length <= quick::smallsort_threshold(comp.size())) {
+    small::small_sort_general(raw_v, length, raw_scratch, comp);
+    comp.progress(length);
+    return;
+  }
+  BlobPtr v = comp.lift(raw_v);
+  size_t mid = length / 2;
+  merge_sort(v, mid, raw_scratch, scratch_length, comp);
+  merge_sort(v.offset(mid), length - mid, raw_scratch, scratch_length, comp);
+  if (comp.cancelled())
+    return;
+  merge::merge(v, length, raw_scratch, scratch_length, mid, comp);
+  comp.progress(length);
+}
+
 template <typename Comp>
 inline void stable_quicksort(void *raw_v, size_t length, void *raw_scratch,
                              size_t scratch_length,
                              const BlobComparator<Comp> &comp) {
+  if constexpr (BlobComparator<Comp>::FEWEST_COMPARES) {
+    merge_sort(raw_v, length, raw_scratch, scratch_length, comp);
+    return;
+  }
   size_t limit = std::bit_width(2 * (length | 1));
+  if (length <= scratch_length &&
+      length * comp.size() >= quick::PING_PONG_MIN_BYTES) {
+    size_t small_scratch_length =
+        quick::ping_pong_small_scratch_length(comp.size());
+    auto small_scratch_space = DRIFTSORT_ALLOCA(comp, small_scratch_length);
+    quick::ping_pong_quicksort(comp.lift(raw_v), comp.lift(raw_scratch),
+                               length, false, false, limit, nullptr,
+                               comp.lift_alloca(small_scratch_space), comp);
+    return;
+  }
   quick::stable_quicksort(raw_v, length, raw_scratch, scratch_length, limit,
                           nullptr, comp);
 }
@@ -56,20 +98,45 @@ inline bool find_existing_run(void *raw_v, size_t length,
 
   BlobPtr v = comp.lift(raw_v);
   size_t run_length = 2;
+  policy::Prefetcher prefetcher(length, v.size(), run_length);
+  auto prefetch = [&] {
+    if (prefetcher.due(run_length))
+      DRIFTSORT_PREFETCH_READ(
+          v.offset(run_length + prefetcher.distance(run_length)).get());
+  };
   bool strictly_descending = comp(v.offset(1), v.offset(0));
   if (strictly_descending) {
     while (run_length < length &&
-           comp(v.offset(run_length), v.offset(run_length - 1)))
+           comp(v.offset(run_length), v.offset(run_length - 1))) {
+      prefetch();
       run_length++;
+    }
   } else {
     while (run_length < length &&
-           !comp(v.offset(run_length), v.offset(run_length - 1)))
+           !comp(v.offset(run_length), v.offset(run_length - 1))) {
+      prefetch();
       run_length++;
+    }
   }
   out = run_length;
   return strictly_descending;
 }
 
+template <typename Comp>
+inline void reverse(void *raw_v, size_t length,
+                    const BlobComparator<Comp> &comp) {
+  BlobPtr v = comp.lift(raw_v);
+  auto alloca_space = DRIFTSORT_ALLOCA(comp, 1);
+  BlobPtr tmp = comp.lift_alloca(alloca_space);
+  for (size_t i = 0; i < length / 2; i++) {
+    BlobPtr a = v.offset(i);
+    BlobPtr b = v.offset(length - 1 - i);
+    a.copy_nonoverlapping(tmp);
+    b.copy_nonoverlapping(a);
+    tmp.copy_nonoverlapping(b);
+  }
+}
+
 /// Creates a new logical run.
 ///
 /// A logical run can either be sorted or unsorted. If there is a pre-existing
@@ -82,30 +149,20 @@ inline RunState create_run(void *raw_v, size_t length, void *raw_scratch,
                            size_t scratch_length, size_t min_good_run_length,
                            const BlobComparator<Comp> &comp) {
   auto v = comp.lift(raw_v);
-  auto alloca_space = DRIFTSORT_ALLOCA(comp, 1);
-  BlobPtr tmp = comp.lift_alloca(alloca_space);
-  auto reverse = [&](BlobPtr array, size_t length) {
-    for (size_t i = 0; i < length / 2; i++) {
-      auto a = array.offset(i);
-      auto b = array.offset(length - 1 - i);
-      a.copy_nonoverlapping(tmp);
-      b.copy_nonoverlapping(a);
-      tmp.copy_nonoverlapping(b);
-    }
-  };
   if (length >= min_good_run_length) {
     size_t run_length;
     bool descending = find_existing_run(raw_v, length, comp, run_length);
     DRIFTSORT_ASSUME(run_length <= length);
     if (run_length >= min_good_run_length) {
       if (descending)
-        reverse(v, run_length);
+        reverse(v, run_length, comp);
       return RunState::sorted(run_length);
     }
   }
 
   if constexpr (eager_sort) {
-    size_t eager_sort_len = std::min(length, quick::SMALLSORT_THRESHOLD);
+    size_t eager_sort_len =
+        std::min(length, quick::smallsort_threshold(comp.size()));
     small::small_sort_general(v, eager_sort_len, raw_scratch, comp);
     return RunState::sorted(eager_sort_len);
   }
@@ -127,7 +184,11 @@ inline RunState logical_merge(void *raw_v, size_t length, void *raw_scratch,
     if (!right.is_sorted())
       stable_quicksort(v.offset(left.length()), length - left.length(),
                        raw_scratch, scratch_length, comp);
+    // The caller stops before it looks at the run again.
+    if (comp.cancelled())
+      return RunState::unsorted(length);
     merge::merge(v, length, raw_scratch, scratch_length, left.length(), comp);
+    comp.progress(length);
     return RunState::sorted(length);
   }
   return RunState::unsorted(length);
@@ -189,20 +250,31 @@ inline uint64_t merge_tree_scale_factor(size_t n) {
 }
 template <bool eager_sort, typename Comp>
 inline void sort(void *raw_v, size_t length, void *raw_scratch,
-                 size_t scratch_length, const BlobComparator<Comp> &comp) {
+                 size_t scratch_length, const BlobComparator<Comp> &comp,
+                 size_t run_threshold) {
   if (length < 2)
     return;
+  // Scanning for runs costs comparisons that only pay off when there are
+  // runs longer than a small sort.
+  if constexpr (BlobComparator<Comp>::FEWEST_COMPARES) {
+    if (length <= quick::smallsort_threshold(comp.size())) {
+      small::small_sort_general(raw_v, length, raw_scratch, comp);
+      return;
+    }
+  }
   size_t scale_factor = merge_tree_scale_factor(length);
 
   // It's important to have a relatively high entry barrier for pre-sorted
   // runs, as the presence of a single such run will force on average several
   // merge operations and shrink the maximum quicksort size a lot. For that
   // reason we use sqrt(len) as our pre-sorted run threshold.
-  constexpr size_t MIN_SQRT_RUN_LEN = 64;
+  size_t min_sqrt_run_len = policy::tuning(comp.size()).min_sqrt_run_len;
   size_t min_good_run_len =
-      (length <= MIN_SQRT_RUN_LEN * MIN_SQRT_RUN_LEN)
-          ? std::min(length - length / 2, MIN_SQRT_RUN_LEN)
+      (length <= min_sqrt_run_len * min_sqrt_run_len)
+          ? std::min(length - length / 2, min_sqrt_run_len)
           : approximate_sqrt(length);
+  // unless the caller knows the runs to be shorter, see `presort::Strategy`
+  min_good_run_len = std::min(min_good_run_len, run_threshold);
 
   size_t stack_length = 0;
   DRIFTSORT_UNINITIALIZED RunState run_storage[66];
@@ -215,12 +287,17 @@ inline void sort(void *raw_v, size_t length, void *raw_scratch,
   BlobPtr scratch = comp.lift(raw_scratch);
 
   for (;;) {
+    // Every run and merge leaves the array a permutation of its elements.
+    if (comp.cancelled())
+      return;
     RunState next_run;
     uint8_t desired_depth;
     if (scan_idx < length) {
       next_run =
           create_run<eager_sort>(v.offset(scan_idx), length - scan_idx, scratch,
                                  scratch_length, min_good_run_len, comp);
+      if (next_run.is_sorted())
+        comp.progress(next_run.length());
       desired_depth =
           merge_tree_depth(scan_idx - prev_run.length(), scan_idx,
                            scan_idx + next_run.length(), scale_factor);
@@ -268,7 +345,7 @@ inline void sort(void *raw_v, size_t length, void *raw_scratch,
     prev_run = next_run;
   }
 
-  if (!prev_run.is_sorted())
+  if (!prev_run.is_sorted() && !comp.cancelled())
     stable_quicksort(v, length, scratch, scratch_length, comp);
 }
 
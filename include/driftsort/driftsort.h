@@ -9,11 +9,16 @@
 #include "driftsort/blob.h"
 #include "driftsort/common.h"
 #include "driftsort/drift.h"
+#include "driftsort/hugepage.h"
+#include "driftsort/policy.h"
+#include "driftsort/presort.h"
 #include "driftsort/quicksort.h"
 #include "driftsort/smallsort.h"
 #include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <new>
 
 namespace DRIFTSORT_HIDDEN driftsort {
 template <typename Comp>
@@ -67,35 +72,134 @@ inline size_t guess_alignment(size_t element_size, void *start_addr) {
   return static_cast<size_t>(masked & -masked);
 }
 
-template <typename Comp>
-DRIFTSORT_NOINLINE inline void driftsort(void *raw_v, size_t length,
-                                         const BlobComparator<Comp> &comp) {
-  BlobPtr v = comp.lift(raw_v);
-  constexpr size_t MAX_FULL_ALLOC_BYTES = 8 * 1024 * 1024;
-  constexpr size_t HEAP_ALLOC_THRESHOLD = 4096;
-  bool eager_sort = length <= quick::SMALLSORT_THRESHOLD * 2;
-  size_t max_full_alloc = MAX_FULL_ALLOC_BYTES / v.size();
+/// Arrays up to this length are insertion sorted. Insertion sort is always
+/// fine because we never call comparison on temporary space.
+inline size_t max_len_always_insertion_sort(size_t element_size) {
+  return policy::tuning(element_size).max_len_always_insertion_sort;
+}
+// Larger alignments take the slow path, see `qsort_r`.
+inline constexpr size_t MAX_ALIGNMENT = 32;
+// Largest alignment accepted by `qsort_aligned`, a small page.
+inline constexpr size_t MAX_EXPLICIT_ALIGNMENT = 4096;
+
+/// Scratch length `driftsort` asks for to sort `length` elements: the whole
+/// length up to `policy::Tuning::max_full_alloc_bytes`, but at least half.
+inline size_t scratch_length_for(size_t length, size_t element_size) {
+  const policy::Tuning &tuning = policy::tuning(element_size);
+  size_t max_full_alloc = tuning.max_full_alloc_bytes / element_size;
   size_t alloc_length = std::max(length / 2, std::min(length, max_full_alloc));
-  alloc_length = std::max(alloc_length, quick::SMALLSORT_THRESHOLD + 16);
-  if (alloc_length > HEAP_ALLOC_THRESHOLD) {
-    auto raw_scratch =
-        ::operator new(alloc_length * v.size(), std::align_val_t{comp.align()});
+  return std::max(alloc_length, tuning.smallsort_threshold + 16);
+}
+
+/// Calls `f` with uninitialized scratch space for `alloc_length` elements,
+/// which lives on the stack if it is small enough and on huge pages if it is
+/// large enough. Over-aligned elements always get heap scratch, so that the
+/// padding of large alignments never adds up on the stack. Returns false
+/// without calling `f` if the allocation fails.
+template <typename Comp, typename F>
+inline bool with_scratch(size_t alloc_length, const BlobComparator<Comp> &comp,
+                         F f) {
+  size_t bytes = alloc_length * comp.size();
+  if (bytes >= policy::HUGE_PAGE_MIN_BYTES) {
+    if (void *raw_scratch = hugepage::allocate(bytes)) {
+      f(BlobPtr{comp.size(), static_cast<std::byte *>(raw_scratch)});
+      hugepage::release(raw_scratch, bytes);
+      return true;
+    }
+  }
+  size_t heap_alloc_threshold =
+      policy::tuning(comp.size()).heap_alloc_threshold;
+  if (alloc_length > heap_alloc_threshold || comp.align() > MAX_ALIGNMENT) {
+    auto raw_scratch = ::operator new(alloc_length * comp.size(),
+                                      std::align_val_t{comp.align()},
+                                      std::nothrow);
     if (DRIFTSORT_UNLIKELY(raw_scratch == nullptr))
-      return trivial_heap_sort(raw_v, length, comp);
-    BlobPtr scratch{v.size(), static_cast<std::byte *>(raw_scratch)};
-    if (eager_sort)
-      drift::sort<true>(v, length, scratch, alloc_length, comp);
-    else
-      drift::sort<false>(v, length, scratch, alloc_length, comp);
+      return false;
+    f(BlobPtr{comp.size(), static_cast<std::byte *>(raw_scratch)});
     ::operator delete(raw_scratch, std::align_val_t{comp.align()});
   } else {
     auto raw_scratch_space = DRIFTSORT_ALLOCA(comp, alloc_length);
-    BlobPtr scratch = comp.lift_alloca(raw_scratch_space);
+    f(comp.lift_alloca(raw_scratch_space));
+  }
+  return true;
+}
+
+/// Sorts `v` if it is one ascending or strictly descending run but for a
+/// tail of at most `length / presort::MAX_TAIL_FRACTION` elements, with
+/// scratch for the tail only. Returns false otherwise, or if the scratch
+/// cannot be allocated, with `v` still a permutation of its elements.
+template <typename Comp>
+inline bool sort_presorted(void *raw_v, size_t length,
+                           const BlobComparator<Comp> &comp) {
+  BlobPtr v = comp.lift(raw_v);
+  size_t run_length;
+  bool descending = drift::find_existing_run(v, length, comp, run_length);
+  size_t tail = length - run_length;
+  if (tail > length / presort::MAX_TAIL_FRACTION)
+    return false;
+  if (descending)
+    drift::reverse(v, run_length, comp);
+  if (tail == 0)
+    return true;
+  // The merge saves the tail, which is the shorter run.
+  size_t alloc_length = std::max(tail, scratch_length_for(tail, v.size()));
+  return with_scratch(alloc_length, comp, [&](BlobPtr scratch) {
+    drift::sort<false>(v.offset(run_length), tail, scratch, alloc_length,
+                       comp);
+    if (comp.cancelled())
+      return;
+    merge::merge(v, length, scratch, alloc_length, run_length, comp);
+    comp.progress(length);
+  });
+}
+
+template <typename Comp>
+DRIFTSORT_NOINLINE inline void driftsort(void *raw_v, size_t length,
+                                         const BlobComparator<Comp> &comp) {
+  BlobPtr v = comp.lift(raw_v);
+  // Minimizing comparisons sorts short runs lazily, by merge sort.
+  bool eager_sort = !BlobComparator<Comp>::FEWEST_COMPARES &&
+                    length <= quick::smallsort_threshold(v.size()) * 2;
+  size_t run_threshold = SIZE_MAX;
+  if (!BlobComparator<Comp>::FEWEST_COMPARES &&
+      length >= presort::MIN_LENGTH) {
+    presort::Estimate estimate = presort::estimate(v, length, comp);
+    switch (presort::choose(estimate)) {
+    case presort::Strategy::presorted:
+      if (sort_presorted(v, length, comp))
+        return;
+      break;
+    case presort::Strategy::runs:
+      run_threshold = presort::run_threshold(estimate);
+      break;
+    case presort::Strategy::shuffled:
+      break;
+    }
+  }
+  size_t alloc_length = scratch_length_for(length, v.size());
+  auto sort = [&](BlobPtr scratch) {
     if (eager_sort)
       drift::sort<true>(v, length, scratch, alloc_length, comp);
     else
-      drift::sort<false>(v, length, scratch, alloc_length, comp);
+      drift::sort<false>(v, length, scratch, alloc_length, comp,
+                         run_threshold);
+  };
+  // Large arrays get full-length scratch if possible, so that quicksort can
+  // partition back and forth between it and the array, see
+  // `quick::ping_pong_quicksort`.
+  bool allocated = false;
+  if (!BlobComparator<Comp>::FEWEST_COMPARES && alloc_length < length &&
+      length * v.size() >= quick::PING_PONG_MIN_BYTES) {
+    size_t reduced_length = alloc_length;
+    alloc_length = length;
+    allocated = with_scratch(alloc_length, comp, sort);
+    if (!allocated)
+      alloc_length = reduced_length;
   }
+  if (!allocated)
+    allocated = with_scratch(alloc_length, comp, sort);
+  if (DRIFTSORT_UNLIKELY(!allocated))
+    trivial_heap_sort(raw_v, length, comp);
 }
 template <typename Comp>
 inline void qsort_r(void *data, size_t length, size_t element_size,
@@ -108,11 +212,10 @@ inline void qsort_r(void *data, size_t length, size_t element_size,
   size_t alignment = guess_alignment(element_size, data);
   BlobComparator<Comp> comp{element_size, alignment, compare};
 
-  // Insertion sort is always fine because we never call comparison on temporary
-  // space
-  constexpr size_t MAX_LEN_ALWAYS_INSERTION_SORT = 20;
-  constexpr size_t MAX_ALIGNMENT = 32;
-  if (DRIFTSORT_LIKELY(length <= MAX_LEN_ALWAYS_INSERTION_SORT)) {
+  // Merge insertion beats insertion sort on comparisons even for a few
+  // elements.
+  if (!BlobComparator<Comp>::FEWEST_COMPARES &&
+      DRIFTSORT_LIKELY(length <= max_len_always_insertion_sort(element_size))) {
     BlobPtr v = comp.lift(data);
     return small::insertion_sort_shift_left(v, length, 1, comp);
   }
@@ -125,4 +228,43 @@ inline void qsort_r(void *data, size_t length, size_t element_size,
 
   driftsort(data, length, comp);
 }
+
+/// Like `qsort_r` for elements of a known `alignment`, which must be a power
+/// of two up to `MAX_EXPLICIT_ALIGNMENT` that divides both `element_size`
+/// and the address of `data`. Returns false without sorting otherwise.
+///
+/// `qsort_r` can only guess the alignment from the size and address and
+/// sorts everything it guesses to be over-aligned with an unstable heap
+/// sort. Here the scratch space is aligned as requested instead, so such
+/// elements get the stable, adaptive driftsort as well.
+template <typename Comp>
+inline bool qsort_aligned(void *data, size_t length, size_t element_size,
+                          size_t alignment, Comp compare) {
+  if (!std::has_single_bit(alignment) || alignment > MAX_EXPLICIT_ALIGNMENT ||
+      element_size % alignment != 0 ||
+      reinterpret_cast<uintptr_t>(data) % alignment != 0)
+    return false;
+  if (element_size == 0 || length < 2)
+    return true;
+
+  BlobComparator<Comp> comp{element_size, alignment, compare};
+  if (length <= max_len_always_insertion_sort(element_size))
+    small::insertion_sort_shift_left(comp.lift(data), length, 1, comp);
+  else
+    driftsort(data, length, comp);
+  return true;
+}
+
+/// Samples the order of `data` like `qsort_r` does before sorting arrays of
+/// `presort::MIN_LENGTH` elements or more, for instrumentation.
+/// `presort::choose` tells the strategy the sort takes on the result.
+template <typename Comp>
+inline presort::Estimate estimate_order(void *data, size_t length,
+                                        size_t element_size, Comp compare) {
+  if (element_size == 0)
+    return {};
+  BlobComparator<Comp> comp{element_size,
+                            guess_alignment(element_size, data), compare};
+  return presort::estimate(data, length, comp);
+}
 } // namespace DRIFTSORT_HIDDEN driftsort
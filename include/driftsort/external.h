@@ -0,0 +1,419 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/common.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/key.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+
+/// Describes how `sort_file` sorts a file of fixed-width records.
+struct ExternalSortOptions {
+  size_t record_size;
+  KeySpec key;
+  // Bytes of memory to use for records and buffers. Sorting a chunk with
+  // driftsort needs up to half of it again as scratch, which is included.
+  size_t memory_budget = size_t{256} << 20;
+  // Where sorted runs are spilled. The files are unlinked right after they
+  // are created, so nothing is left behind even on a crash.
+  const char *temp_dir = "/tmp";
+};
+
+namespace external {
+// Smallest read buffer per run during merges. Below this the merge becomes
+// seek-bound, so more merge passes are used instead.
+inline constexpr size_t MIN_RUN_BUFFER_BYTES = size_t{64} << 10;
+
+class File {
+  int fd = -1;
+
+public:
+  File() = default;
+  explicit File(int fd) : fd(fd) {}
+  File(File &&other) : fd(other.fd) { other.fd = -1; }
+  File &operator=(File &&other) {
+    std::swap(fd, other.fd);
+    return *this;
+  }
+  ~File() {
+    if (fd >= 0)
+      ::close(fd);
+  }
+  int get() const { return fd; }
+};
+
+template <typename T> std::unique_ptr<T[]> allocate(size_t count) {
+  return std::unique_ptr<T[]>(new (std::nothrow) T[count]);
+}
+
+/// Reads exactly `length` bytes at `offset`. Returns 0 or an errno value.
+inline int read_full(int fd, void *buf, size_t length, uint64_t offset) {
+  std::byte *p = static_cast<std::byte *>(buf);
+  while (length != 0) {
+    ssize_t res = ::pread(fd, p, length, static_cast<off_t>(offset));
+    if (res < 0 && errno == EINTR)
+      continue;
+    if (res < 0)
+      return errno;
+    if (res == 0)
+      return EIO;
+    p += res;
+    length -= static_cast<size_t>(res);
+    offset += static_cast<uint64_t>(res);
+  }
+  return 0;
+}
+
+/// Writes exactly `length` bytes at `offset`. Returns 0 or an errno value.
+inline int write_full(int fd, const void *buf, size_t length,
+                      uint64_t offset) {
+  const std::byte *p = static_cast<const std::byte *>(buf);
+  while (length != 0) {
+    ssize_t res = ::pwrite(fd, p, length, static_cast<off_t>(offset));
+    if (res < 0 && errno == EINTR)
+      continue;
+    if (res < 0)
+      return errno;
+    p += res;
+    length -= static_cast<size_t>(res);
+    offset += static_cast<uint64_t>(res);
+  }
+  return 0;
+}
+
+/// Creates an anonymous temporary file in `dir`.
+inline int create_temp(const char *dir, File &file) {
+  char path[4096];
+  int len = std::snprintf(path, sizeof(path), "%s/driftsort-XXXXXX", dir);
+  if (len < 0 || static_cast<size_t>(len) >= sizeof(path))
+    return ENAMETOOLONG;
+  int fd = ::mkostemp(path, O_CLOEXEC);
+  if (fd < 0)
+    return errno;
+  file = File{fd};
+  ::unlink(path);
+  return 0;
+}
+
+inline void sort_records(void *data, size_t count,
+                         const ExternalSortOptions &options) {
+  const KeySpec &spec = options.key;
+  driftsort::qsort_r(data, count, options.record_size,
+                     [&spec](const void *a, const void *b) {
+                       return key::compare(a, b, spec);
+                     });
+}
+
+/// Number of records sorted at once: two thirds of the budget, which leaves
+/// room for driftsort's scratch.
+inline size_t chunk_records(const ExternalSortOptions &options) {
+  return std::max<size_t>(options.memory_budget / 3 * 2 / options.record_size,
+                          1);
+}
+
+/// A sorted run in a temporary file.
+struct Run {
+  File file;
+  uint64_t records;
+};
+
+/// Reads a run sequentially through a buffer of whole records.
+struct RunReader {
+  int fd;
+  uint64_t remaining;
+  uint64_t offset;
+  std::byte *buffer;
+  size_t buffer_records;
+  std::byte *current;
+  std::byte *end;
+
+  int refill(size_t record_size) {
+    size_t count =
+        static_cast<size_t>(std::min<uint64_t>(remaining, buffer_records));
+    if (int err = read_full(fd, buffer, count * record_size, offset))
+      return err;
+    remaining -= count;
+    offset += count * record_size;
+    current = buffer;
+    end = buffer + count * record_size;
+    return 0;
+  }
+};
+
+/// Writes records sequentially through a buffer.
+struct Writer {
+  int fd;
+  uint64_t offset;
+  std::byte *buffer;
+  size_t capacity;
+  size_t used = 0;
+
+  int flush() {
+    if (int err = write_full(fd, buffer, used, offset))
+      return err;
+    offset += used;
+    used = 0;
+    return 0;
+  }
+  int append(const std::byte *record, size_t record_size) {
+    if (used + record_size > capacity)
+      if (int err = flush())
+        return err;
+    std::memcpy(buffer + used, record, record_size);
+    used += record_size;
+    return 0;
+  }
+};
+
+/// Merges `runs[..count]` into `out` starting at byte `offset`.
+///
+/// The runs are consumed through a binary heap of readers that breaks ties
+/// by run index. Runs hold consecutive chunks of the input, so the merge is
+/// stable. The budget is split evenly between the readers and the writer.
+inline int merge_runs(Run *runs, size_t count, int out, uint64_t offset,
+                      const ExternalSortOptions &options) {
+  size_t record_size = options.record_size;
+  size_t buffer_records =
+      std::max<size_t>(options.memory_budget / (count + 1) / record_size, 1);
+  size_t buffer_bytes = buffer_records * record_size;
+  auto buffers = allocate<std::byte>((count + 1) * buffer_bytes);
+  auto readers = allocate<RunReader>(count);
+  auto heap = allocate<size_t>(count);
+  if (!buffers || !readers || !heap)
+    return ENOMEM;
+
+  const KeySpec &spec = options.key;
+  auto before = [&](size_t a, size_t b) {
+    int res = key::compare(readers[a].current, readers[b].current, spec);
+    return res < 0 || (res == 0 && a < b);
+  };
+  auto sift_down = [&](size_t heap_length, size_t i) {
+    for (;;) {
+      size_t child = 2 * i + 1;
+      if (child >= heap_length)
+        return;
+      if (child + 1 < heap_length && before(heap[child + 1], heap[child]))
+        child++;
+      if (!before(heap[child], heap[i]))
+        return;
+      std::swap(heap[i], heap[child]);
+      i = child;
+    }
+  };
+
+  size_t heap_length = 0;
+  for (size_t i = 0; i < count; i++) {
+    readers[i] = {runs[i].file.get(), runs[i].records, 0,
+                  buffers.get() + i * buffer_bytes, buffer_records, nullptr,
+                  nullptr};
+    if (runs[i].records == 0)
+      continue;
+    if (int err = readers[i].refill(record_size))
+      return err;
+    heap[heap_length++] = i;
+  }
+  for (size_t i = heap_length / 2; i-- > 0;)
+    sift_down(heap_length, i);
+
+  Writer writer{out, offset, buffers.get() + count * buffer_bytes,
+                buffer_bytes};
+  while (heap_length != 0) {
+    RunReader &reader = readers[heap[0]];
+    if (int err = writer.append(reader.current, record_size))
+      return err;
+    reader.current += record_size;
+    if (reader.current == reader.end) {
+      if (reader.remaining == 0)
+        heap[0] = heap[--heap_length];
+      else if (int err = reader.refill(record_size))
+        return err;
+    }
+    sift_down(heap_length, 0);
+  }
+  return writer.flush();
+}
+
+/// Sorts the `records` records of `in` and writes them to `out`, spilling
+/// sorted runs to temporary files and merging them in as many passes as the
+/// budget requires.
+inline int sort_external(int in, uint64_t records, int out,
+                         const ExternalSortOptions &options) {
+  size_t record_size = options.record_size;
+  size_t chunk = chunk_records(options);
+  uint64_t run_count = (records + chunk - 1) / chunk;
+  auto runs = allocate<Run>(static_cast<size_t>(run_count));
+  if (!runs)
+    return ENOMEM;
+
+  {
+    auto buffer = allocate<std::byte>(chunk * record_size);
+    if (!buffer)
+      return ENOMEM;
+    for (uint64_t i = 0; i < run_count; i++) {
+      size_t count =
+          static_cast<size_t>(std::min<uint64_t>(records - i * chunk, chunk));
+      if (int err = read_full(in, buffer.get(), count * record_size,
+                              i * chunk * record_size))
+        return err;
+      sort_records(buffer.get(), count, options);
+      Run &run = runs[i];
+      if (int err = create_temp(options.temp_dir, run.file))
+        return err;
+      if (int err =
+              write_full(run.file.get(), buffer.get(), count * record_size, 0))
+        return err;
+      run.records = count;
+    }
+  }
+
+  // Merge groups of adjacent runs until one pass can take them all. Keeping
+  // groups adjacent preserves stability.
+  size_t min_buffer_records =
+      std::max<size_t>(MIN_RUN_BUFFER_BYTES / record_size, 1);
+  size_t fan_in = std::max<size_t>(
+      options.memory_budget / (min_buffer_records * record_size), 3) - 1;
+  size_t length = static_cast<size_t>(run_count);
+  while (length > fan_in) {
+    size_t merged = 0;
+    for (size_t first = 0; first < length; first += fan_in) {
+      size_t count = std::min(fan_in, length - first);
+      Run run{File{}, 0};
+      if (int err = create_temp(options.temp_dir, run.file))
+        return err;
+      if (int err =
+              merge_runs(runs.get() + first, count, run.file.get(), 0, options))
+        return err;
+      for (size_t i = first; i < first + count; i++) {
+        run.records += runs[i].records;
+        runs[i].file = File{};
+      }
+      runs[merged++] = std::move(run);
+    }
+    length = merged;
+  }
+  return merge_runs(runs.get(), length, out, 0, options);
+}
+
+/// Sorts a file that fits into the budget in place through a shared mapping.
+inline int sort_mapped(int fd, uint64_t size,
+                       const ExternalSortOptions &options) {
+  if (size == 0)
+    return 0;
+  void *data = ::mmap(nullptr, static_cast<size_t>(size),
+                      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED)
+    return errno;
+  ::madvise(data, static_cast<size_t>(size), MADV_WILLNEED);
+  sort_records(data, static_cast<size_t>(size / options.record_size),
+               options);
+  int err = ::msync(data, static_cast<size_t>(size), MS_SYNC) != 0 ? errno : 0;
+  ::munmap(data, static_cast<size_t>(size));
+  return err;
+}
+
+/// Copies `size` bytes from `from` to `to` through a budget-sized buffer.
+inline int copy_file(int from, int to, uint64_t size,
+                     const ExternalSortOptions &options) {
+  size_t buffer_bytes = static_cast<size_t>(std::min<uint64_t>(
+      size, std::max(options.memory_budget, MIN_RUN_BUFFER_BYTES)));
+  auto buffer = allocate<std::byte>(std::max<size_t>(buffer_bytes, 1));
+  if (!buffer)
+    return ENOMEM;
+  for (uint64_t offset = 0; offset < size; offset += buffer_bytes) {
+    size_t count =
+        static_cast<size_t>(std::min<uint64_t>(size - offset, buffer_bytes));
+    if (int err = read_full(from, buffer.get(), count, offset))
+      return err;
+    if (int err = write_full(to, buffer.get(), count, offset))
+      return err;
+  }
+  return 0;
+}
+} // namespace external
+
+/// Sorts a file of fixed-width records by the key in `options` and writes the
+/// result to `output`, or back to `input` if `output` is null or names the
+/// same file. The sort is stable.
+///
+/// Files that fit into the memory budget are sorted in memory, in place
+/// through a shared mapping if `output` is null. Larger files are sorted in
+/// chunks that are spilled as runs to `temp_dir` and k-way merged with large
+/// sequential reads and writes.
+///
+/// Returns 0 on success or an errno value: EINVAL if the file size is not a
+/// multiple of the record size or the key does not fit into a record.
+inline int sort_file(const char *input, const char *output,
+                     const ExternalSortOptions &options) {
+  using namespace external;
+  if (options.record_size == 0 ||
+      !key::is_valid(options.key, options.record_size))
+    return EINVAL;
+  bool in_place = output == nullptr;
+  struct stat st;
+  if (!in_place && ::stat(output, &st) == 0) {
+    // Truncating the output must not destroy the input.
+    dev_t dev = st.st_dev;
+    ino_t ino = st.st_ino;
+    in_place = ::stat(input, &st) == 0 && st.st_dev == dev && st.st_ino == ino;
+  }
+  File in{::open(input, (in_place ? O_RDWR : O_RDONLY) | O_CLOEXEC)};
+  if (in.get() < 0)
+    return errno;
+  if (::fstat(in.get(), &st) != 0)
+    return errno;
+  uint64_t size = static_cast<uint64_t>(st.st_size);
+  if (size % options.record_size != 0)
+    return EINVAL;
+  uint64_t records = size / options.record_size;
+  bool fits = records <= chunk_records(options);
+
+  if (in_place && fits)
+    return sort_mapped(in.get(), size, options);
+
+  ::posix_fadvise(in.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+  File out;
+  if (in_place) {
+    if (int err = create_temp(options.temp_dir, out))
+      return err;
+  } else {
+    out = File{::open(output, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+    if (out.get() < 0)
+      return errno;
+  }
+
+  if (fits) {
+    size_t count = static_cast<size_t>(records);
+    auto buffer = allocate<std::byte>(std::max<size_t>(size, 1));
+    if (!buffer)
+      return ENOMEM;
+    if (int err = read_full(in.get(), buffer.get(), size, 0))
+      return err;
+    sort_records(buffer.get(), count, options);
+    return write_full(out.get(), buffer.get(), size, 0);
+  }
+
+  if (int err = sort_external(in.get(), records, out.get(), options))
+    return err;
+  if (in_place)
+    return copy_file(out.get(), in.get(), size, options);
+  return 0;
+}
+
+} // namespace DRIFTSORT_HIDDEN driftsort
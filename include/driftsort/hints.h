@@ -0,0 +1,190 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/merge.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+/// What is known about the order of an array before it is sorted again, see
+/// `sort_hinted`. Without hints nothing is known.
+struct SortHints {
+  /// The first `sorted_prefix` elements are sorted.
+  size_t sorted_prefix = 0;
+  /// If `run_count` is not zero, the elements after the prefix are sorted
+  /// runs that end at the increasing indices `run_ends[..run_count]`, the
+  /// last one at the length of the array. Otherwise they are in no known
+  /// order.
+  const size_t *run_ends = nullptr;
+  size_t run_count = 0;
+  /// Indices of elements that may be out of place wherever they are, say
+  /// because they were modified. They may come in any order and repeat.
+  const size_t *dirty = nullptr;
+  size_t dirty_count = 0;
+};
+
+namespace hints {
+inline bool is_valid(const SortHints &hints, size_t length) {
+  if (hints.sorted_prefix > length)
+    return false;
+  if (hints.run_count != 0) {
+    size_t end = hints.sorted_prefix;
+    for (size_t i = 0; i < hints.run_count; i++) {
+      if (hints.run_ends[i] <= end)
+        return false;
+      end = hints.run_ends[i];
+    }
+    if (end != length)
+      return false;
+  }
+  for (size_t i = 0; i < hints.dirty_count; i++)
+    if (hints.dirty[i] >= length)
+      return false;
+  return true;
+}
+
+/// Calls `f(start, mid, end)` for the merges that combine the sorted runs
+/// ending at `ends[..count]` pairwise, level by level, into one. Each level
+/// takes one pass over the array.
+template <typename F>
+inline void for_each_merge(const size_t *ends, size_t count, F f) {
+  for (size_t width = 1; width < count; width *= 2) {
+    for (size_t first = 0; first + width < count; first += 2 * width) {
+      size_t start = first == 0 ? 0 : ends[first - 1];
+      size_t mid = ends[first + width - 1];
+      size_t end = ends[std::min(first + 2 * width, count) - 1];
+      f(start, mid, end);
+    }
+  }
+}
+
+/// Moves the elements at the increasing indices `dirty[..count]` of `v` to
+/// `out`, in that order, and the others to the front of `v`, in theirs.
+inline void extract(BlobPtr v, size_t length, const size_t *dirty,
+                    size_t count, BlobPtr out) {
+  for (size_t i = 0; i < count; i++) {
+    v.offset(dirty[i]).copy_nonoverlapping(out.offset(i));
+    size_t next = i + 1 < count ? dirty[i + 1] : length;
+    size_t clean = next - dirty[i] - 1;
+    std::memmove(v.offset(dirty[i] - i), v.offset(dirty[i] + 1),
+                 clean * v.size());
+  }
+}
+
+/// Merges the sorted `extracted[..count]` into the sorted `v[..length]`,
+/// which has room for them after its end. They go after the elements of `v`
+/// equal to them.
+///
+/// Goes from the greatest extracted element down and gallops from the
+/// previous insertion point to find the next, so each element costs
+/// O(log(length / count)) comparisons, and each element of `v` moves once.
+template <typename Comp>
+inline void insert_extracted(BlobPtr v, size_t length, BlobPtr extracted,
+                             size_t count, const BlobComparator<Comp> &comp) {
+  size_t end = length;
+  for (size_t j = count; j-- > 0;) {
+    BlobPtr e = extracted.offset(j);
+    size_t pos = end;
+    if (end > 0)
+      pos -= merge::gallop(v.offset(end - 1), -1, end,
+                           [&](BlobPtr x) { return comp(e, x); });
+    std::memmove(v.offset(pos + j + 1), v.offset(pos), (end - pos) * v.size());
+    e.copy_nonoverlapping(v.offset(pos + j));
+    end = pos;
+  }
+}
+} // namespace hints
+
+/// Sorts `data` like `qsort_r`, but relies on `hints` instead of finding out
+/// how the elements are ordered. The elements in no known order and the
+/// dirty ones are taken out and sorted on their own, the sorted runs are
+/// merged, and then the former are merged in by galloping. With k such
+/// elements, that takes O(k log(length)) comparisons, and the moves of a
+/// merge. Known sorted elements are never compared with each other except
+/// to merge runs.
+///
+/// Equal elements keep their order, except that those taken out go after
+/// the sorted ones equal to them. Appending elements to a sorted array and
+/// sorting it again with `sorted_prefix` set is thus the same as a stable
+/// sort.
+///
+/// Returns false without sorting if `hints` are invalid. Hints that are
+/// wrong about the order leave the array a permutation of its elements.
+/// Falls back to `qsort_r` if memory runs out.
+template <typename Comp>
+inline bool sort_hinted(void *data, size_t length, size_t element_size,
+                        const SortHints &hints, Comp compare) {
+  if (!hints::is_valid(hints, length))
+    return false;
+  if (element_size == 0 || length < 2)
+    return true;
+
+  // The unordered tail joins the dirty elements.
+  size_t tail = hints.run_count == 0 ? length - hints.sorted_prefix : 0;
+  size_t index_count = hints.dirty_count + tail;
+  size_t run_count = hints.run_count + 1;
+  // The sorted dirty indices and the run ends.
+  auto indices = static_cast<size_t *>(::operator new(
+      (index_count + run_count) * sizeof(size_t), std::nothrow));
+  if (DRIFTSORT_UNLIKELY(indices == nullptr)) {
+    qsort_r(data, length, element_size, compare);
+    return true;
+  }
+  size_t *dirty = indices;
+  std::copy(hints.dirty, hints.dirty + hints.dirty_count, dirty);
+  std::sort(dirty, dirty + hints.dirty_count);
+  for (size_t i = 0; i < tail; i++)
+    dirty[hints.dirty_count + i] = hints.sorted_prefix + i;
+  std::inplace_merge(dirty, dirty + hints.dirty_count, dirty + index_count);
+  size_t count = std::unique(dirty, dirty + index_count) - dirty;
+
+  // The ends of the sorted runs once the dirty elements are out. Runs left
+  // empty are dropped.
+  size_t *ends = dirty + index_count;
+  size_t clean_runs = 0;
+  for (size_t i = 0; i < run_count; i++) {
+    size_t end = i == 0 ? hints.sorted_prefix : hints.run_ends[i - 1];
+    end -= std::lower_bound(dirty, dirty + count, end) - dirty;
+    if (end > (clean_runs == 0 ? 0 : ends[clean_runs - 1]))
+      ends[clean_runs++] = end;
+  }
+  size_t clean = length - count;
+
+  size_t merge_scratch = 0;
+  hints::for_each_merge(ends, clean_runs,
+                        [&](size_t start, size_t mid, size_t end) {
+                          merge_scratch = std::max(
+                              merge_scratch, std::min(mid - start, end - mid));
+                        });
+  size_t alloc_length = count + merge_scratch;
+  BlobComparator<Comp> comp{element_size, guess_alignment(element_size, data),
+                            compare};
+  BlobPtr v = comp.lift(data);
+  auto sort = [&](BlobPtr scratch) {
+    BlobPtr extracted = scratch.offset(merge_scratch);
+    hints::extract(v, length, dirty, count, extracted);
+    hints::for_each_merge(ends, clean_runs,
+                          [&](size_t start, size_t mid, size_t end) {
+                            merge::merge(v.offset(start), end - start, scratch,
+                                         merge_scratch, mid - start, comp);
+                          });
+    qsort_r(extracted, count, element_size, compare);
+    hints::insert_extracted(v, clean, extracted, count, comp);
+  };
+  bool allocated = alloc_length == 0 || with_scratch(alloc_length, comp, sort);
+  ::operator delete(indices);
+  if (DRIFTSORT_UNLIKELY(!allocated))
+    qsort_r(data, length, element_size, compare);
+  return true;
+}
+} // namespace DRIFTSORT_HIDDEN driftsort
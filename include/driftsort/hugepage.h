@@ -0,0 +1,93 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/common.h"
+#include "driftsort/policy.h"
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__) && __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define DRIFTSORT_HAS_HUGE_PAGES 1
+#else
+#define DRIFTSORT_HAS_HUGE_PAGES 0
+#endif
+
+namespace DRIFTSORT_HIDDEN driftsort {
+namespace hugepage {
+// Size of a transparent huge page, which the kernel can only use for
+// mappings aligned to it.
+inline constexpr size_t HUGE_PAGE_BYTES = size_t{2} << 20;
+
+inline size_t mapped_length(size_t bytes) {
+  return (bytes + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+}
+
+#if DRIFTSORT_HAS_HUGE_PAGES
+/// Faults in `data[..length]` up front, one huge page at a time.
+inline void populate(void *data, size_t length) {
+#ifdef MADV_POPULATE_WRITE
+  if (::madvise(data, length, MADV_POPULATE_WRITE) == 0)
+    return;
+#endif
+  // Kernels before 5.14 lack MADV_POPULATE_WRITE; a write faults in the
+  // whole huge page, or at least its first small page.
+  auto bytes = static_cast<volatile std::byte *>(data);
+  for (size_t offset = 0; offset < length; offset += HUGE_PAGE_BYTES)
+    bytes[offset] = std::byte{0};
+}
+#endif
+
+/// Maps `bytes` of private anonymous memory aligned to a huge page and asks
+/// the kernel to back it with transparent huge pages, which cuts the dTLB
+/// misses of scattered accesses to a large buffer. Returns null if the
+/// mapping fails or the platform has no transparent huge pages. The memory
+/// is released with `release(data, bytes)`.
+inline void *allocate(size_t bytes) {
+#if DRIFTSORT_HAS_HUGE_PAGES
+  size_t length = mapped_length(bytes);
+  if (length < bytes)
+    return nullptr;
+  // `mmap` only aligns to small pages, so map one huge page more than needed
+  // and unmap what lies outside of the aligned range.
+  size_t padded = length + HUGE_PAGE_BYTES;
+  void *raw = ::mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (DRIFTSORT_UNLIKELY(raw == MAP_FAILED))
+    return nullptr;
+  uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+  uintptr_t aligned = (start + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+  if (aligned != start)
+    ::munmap(raw, aligned - start);
+  if (size_t tail = start + padded - (aligned + length); tail != 0)
+    ::munmap(reinterpret_cast<void *>(aligned + length), tail);
+
+  void *data = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+  ::madvise(data, length, MADV_HUGEPAGE);
+#endif
+  if constexpr (policy::HUGE_PAGE_POPULATE)
+    populate(data, length);
+  return data;
+#else
+  (void)bytes;
+  return nullptr;
+#endif
+}
+
+/// Unmaps memory returned by `allocate(bytes)`.
+inline void release(void *data, size_t bytes) {
+#if DRIFTSORT_HAS_HUGE_PAGES
+  ::munmap(data, mapped_length(bytes));
+#else
+  (void)data;
+  (void)bytes;
+#endif
+}
+} // namespace hugepage
+} // namespace DRIFTSORT_HIDDEN driftsort
@@ -0,0 +1,73 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/common.h"
+#include <cstddef>
+#include <cstring>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+namespace isa {
+/// The x86-64 microarchitecture levels the qsort library builds its kernels
+/// for, in increasing order. Elsewhere only `baseline` exists.
+enum class Level { baseline, v2, v3, v4 };
+inline constexpr size_t LEVELS = 4;
+
+// Values of the DRIFTSORT_ISA environment variable, which overrides the
+// level the qsort library picks, e.g. to test every level on one machine.
+inline constexpr const char *NAMES[LEVELS] = {"baseline", "x86-64-v2",
+                                              "x86-64-v3", "x86-64-v4"};
+
+inline const char *name(Level level) {
+  return NAMES[static_cast<size_t>(level)];
+}
+
+/// Parses a level from its name, leaving `level` alone if it is not one.
+inline bool parse(const char *text, Level &level) {
+  for (size_t i = 0; i < LEVELS; i++) {
+    if (std::strcmp(text, NAMES[i]) == 0) {
+      level = static_cast<Level>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+/// The highest level this CPU supports. Only the features that tell the
+/// levels apart are checked; every CPU that has them has the rest of their
+/// level as well.
+inline Level detect() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("popcnt") || !__builtin_cpu_supports("sse4.2"))
+    return Level::baseline;
+  if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("bmi2") ||
+      !__builtin_cpu_supports("fma"))
+    return Level::v2;
+  if (!__builtin_cpu_supports("avx512f") ||
+      !__builtin_cpu_supports("avx512bw") ||
+      !__builtin_cpu_supports("avx512cd") ||
+      !__builtin_cpu_supports("avx512dq") ||
+      !__builtin_cpu_supports("avx512vl"))
+    return Level::v3;
+  return Level::v4;
+#else
+  return Level::baseline;
+#endif
+}
+
+/// The level to run at: the one named by `override`, if any, but never above
+/// what the CPU supports, so that forcing a level cannot crash.
+inline Level select(const char *override) {
+  Level level = detect();
+  Level forced;
+  if (override != nullptr && parse(override, forced) && forced < level)
+    level = forced;
+  return level;
+}
+} // namespace isa
+} // namespace DRIFTSORT_HIDDEN driftsort
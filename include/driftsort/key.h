@@ -0,0 +1,144 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/common.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+
+enum class KeyType : int {
+  // Native-endian unsigned integer of 1, 2, 4 or 8 bytes.
+  unsigned_int = 0,
+  // Native-endian two's complement integer of 1, 2, 4 or 8 bytes.
+  signed_int = 1,
+  // IEEE-754 binary32 or binary64, ordered by IEEE totalOrder:
+  // -NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN.
+  floating = 2,
+  // Any number of bytes compared as unsigned char, like memcmp.
+  bytes = 3,
+};
+
+/// Describes a key stored inside each element at a fixed offset.
+struct KeySpec {
+  size_t offset;
+  size_t width;
+  KeyType type;
+  bool descending;
+};
+
+namespace key {
+inline bool is_valid(const KeySpec &spec, size_t element_size) {
+  if (spec.width == 0 || spec.offset > element_size ||
+      spec.width > element_size - spec.offset)
+    return false;
+  switch (spec.type) {
+  case KeyType::unsigned_int:
+  case KeyType::signed_int:
+    return spec.width == 1 || spec.width == 2 || spec.width == 4 ||
+           spec.width == 8;
+  case KeyType::floating:
+    return spec.width == 4 || spec.width == 8;
+  case KeyType::bytes:
+    return true;
+  }
+  return false;
+}
+
+/// Whether `prefix` captures the whole key, so equal prefixes mean equal keys.
+inline bool prefix_is_exact(const KeySpec &spec) {
+  return spec.type != KeyType::bytes || spec.width <= sizeof(uint64_t);
+}
+
+inline uint64_t load_unsigned(const std::byte *p, size_t width) {
+  switch (width) {
+  case 1: {
+    uint8_t x;
+    std::memcpy(&x, p, 1);
+    return x;
+  }
+  case 2: {
+    uint16_t x;
+    std::memcpy(&x, p, 2);
+    return x;
+  }
+  case 4: {
+    uint32_t x;
+    std::memcpy(&x, p, 4);
+    return x;
+  }
+  default: {
+    uint64_t x;
+    std::memcpy(&x, p, 8);
+    return x;
+  }
+  }
+}
+
+/// Maps the key of `element` to an integer whose unsigned order is the key
+/// order. For byte keys longer than eight bytes only the first eight bytes are
+/// encoded and ties must be broken by `compare_tail`.
+inline uint64_t prefix(const void *element, const KeySpec &spec) {
+  const std::byte *p = static_cast<const std::byte *>(element) + spec.offset;
+  uint64_t res;
+  switch (spec.type) {
+  case KeyType::unsigned_int:
+    res = load_unsigned(p, spec.width);
+    break;
+  case KeyType::signed_int: {
+    // Sign-extend, then flip the sign bit so negative values come first.
+    size_t shift = 64 - 8 * spec.width;
+    uint64_t x = load_unsigned(p, spec.width) << shift;
+    res = static_cast<uint64_t>(static_cast<int64_t>(x) >> shift) ^
+          (uint64_t{1} << 63);
+    break;
+  }
+  case KeyType::floating: {
+    // Move the sign to the top of 64 bits, then flip all bits of negative
+    // values and only the sign bit of positive ones.
+    uint64_t x = load_unsigned(p, spec.width) << (64 - 8 * spec.width);
+    uint64_t mask = static_cast<uint64_t>(static_cast<int64_t>(x) >> 63);
+    res = x ^ (mask | (uint64_t{1} << 63));
+    break;
+  }
+  case KeyType::bytes: {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(p);
+    size_t count = spec.width < 8 ? spec.width : 8;
+    res = 0;
+    for (size_t i = 0; i < count; i++)
+      res |= uint64_t{bytes[i]} << (56 - 8 * i);
+    break;
+  }
+  default:
+    DRIFTSORT_ASSUME(false);
+    res = 0;
+  }
+  return spec.descending ? ~res : res;
+}
+
+/// Compares the part of two keys that `prefix` does not cover.
+inline int compare_tail(const void *a, const void *b, const KeySpec &spec) {
+  if (prefix_is_exact(spec))
+    return 0;
+  const std::byte *x = static_cast<const std::byte *>(a) + spec.offset + 8;
+  const std::byte *y = static_cast<const std::byte *>(b) + spec.offset + 8;
+  int res = std::memcmp(x, y, spec.width - 8);
+  return spec.descending ? -res : res;
+}
+
+/// Compares the keys of two elements.
+inline int compare(const void *a, const void *b, const KeySpec &spec) {
+  uint64_t x = prefix(a, spec);
+  uint64_t y = prefix(b, spec);
+  if (x != y)
+    return x < y ? -1 : 1;
+  return compare_tail(a, b, spec);
+}
+} // namespace key
+} // namespace DRIFTSORT_HIDDEN driftsort
@@ -0,0 +1,232 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/driftsort.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+
+/// A sorted array of `length` elements.
+struct SortedRun {
+  const void *data;
+  size_t length;
+};
+
+namespace kmerge {
+// Trees for up to this many runs live on the stack.
+inline constexpr size_t MAX_STACK_RUNS = 1024;
+// Size of the batches handed to a sink.
+inline constexpr size_t SINK_BATCH_BYTES = 16384;
+
+/// The head of a run. Exhausted runs have a null `end` and point `current`
+/// at a greatest element of all runs.
+struct Cursor {
+  const std::byte *current;
+  const std::byte *end;
+};
+
+/// A tournament tree over the heads of `k` runs, which keeps the loser of
+/// every match in the inner nodes `tree[1..k]` and the overall winner in
+/// `tree[0]`. Run `i` is the leaf at node `k + i`.
+///
+/// After the winner is taken only the matches on its path to the root are
+/// replayed, always against the stored loser, so each element costs
+/// log2(k) comparisons and touches a single root path. The replay selects
+/// with conditional moves rather than branches.
+///
+/// On equal heads the run with the lower index wins, which makes the merge
+/// stable. An exhausted run takes a greatest element as its head instead of
+/// being checked for in every match, so it can only win once every remaining
+/// element equals that greatest one. At that point the remaining elements
+/// are already in order run by run.
+template <typename Comp> class LoserTree {
+  Cursor *cursors;
+  uint32_t *tree;
+  size_t leaves;
+  const std::byte *greatest;
+  const BlobComparator<Comp> &comp;
+
+  /// Whether run `a` goes before run `b`.
+  bool beats(uint32_t a, uint32_t b) const {
+    // `a` goes first iff it is less, or equal and from an earlier run. With
+    // the later run as the left operand either case is one comparison.
+    bool a_first = a < b;
+    const std::byte *earlier = cursors[a_first ? a : b].current;
+    const std::byte *later = cursors[a_first ? b : a].current;
+    return comp(later, earlier) != a_first;
+  }
+
+  /// Plays the subtree rooted at `node`, filling in its losers, and returns
+  /// its winner.
+  uint32_t build(size_t node) {
+    if (node >= leaves)
+      return static_cast<uint32_t>(node - leaves);
+    uint32_t left = build(2 * node);
+    uint32_t right = build(2 * node + 1);
+    bool left_wins = beats(left, right);
+    tree[node] = left_wins ? right : left;
+    return left_wins ? left : right;
+  }
+
+public:
+  /// `cursors` and `tree` hold `leaves` entries each and `greatest` is a
+  /// greatest element of all runs.
+  LoserTree(Cursor *cursors, uint32_t *tree, size_t leaves,
+            const std::byte *greatest, const BlobComparator<Comp> &comp)
+      : cursors(cursors), tree(tree), leaves(leaves), greatest(greatest),
+        comp(comp) {
+    for (size_t i = 0; i < leaves; i++)
+      if (cursors[i].current == cursors[i].end)
+        cursors[i] = {greatest, nullptr};
+    tree[0] = build(1);
+  }
+
+  /// Whether the winner is an exhausted run, so that the remaining elements
+  /// all equal the greatest one.
+  bool only_greatest_left() const { return cursors[tree[0]].end == nullptr; }
+
+  /// Returns the smallest head element and advances its run.
+  const std::byte *pop() {
+    uint32_t winner = tree[0];
+    Cursor &cursor = cursors[winner];
+    const std::byte *res = cursor.current;
+    cursor.current += comp.size();
+    if (DRIFTSORT_UNLIKELY(cursor.current == cursor.end))
+      cursor = {greatest, nullptr};
+    for (size_t node = (winner + leaves) / 2; node != 0; node /= 2) {
+      uint32_t loser = tree[node];
+      bool swap = beats(loser, winner);
+      tree[node] = swap ? winner : loser;
+      winner = swap ? loser : winner;
+    }
+    tree[0] = winner;
+    return res;
+  }
+};
+
+/// Calls `emit` with every element of `runs[..count]` in stable sorted order.
+/// Returns false if the tree could not be allocated.
+template <typename Comp, typename Emit>
+inline bool merge(const SortedRun *runs, size_t count,
+                  const BlobComparator<Comp> &comp, Emit emit) {
+  const std::byte *greatest = nullptr;
+  for (size_t i = 0; i < count; i++) {
+    if (runs[i].length == 0)
+      continue;
+    auto last = static_cast<const std::byte *>(runs[i].data) +
+                (runs[i].length - 1) * comp.size();
+    if (greatest == nullptr || !comp(last, greatest))
+      greatest = last;
+  }
+  if (greatest == nullptr)
+    return true;
+
+  Cursor stack_cursors[MAX_STACK_RUNS];
+  uint32_t stack_tree[MAX_STACK_RUNS];
+  Cursor *cursors = stack_cursors;
+  uint32_t *tree = stack_tree;
+  void *heap = nullptr;
+  if (count > MAX_STACK_RUNS) {
+    if (count > UINT32_MAX)
+      return false;
+    heap = ::operator new(count * (sizeof(Cursor) + sizeof(uint32_t)),
+                          std::nothrow);
+    if (DRIFTSORT_UNLIKELY(heap == nullptr))
+      return false;
+    cursors = static_cast<Cursor *>(heap);
+    tree = reinterpret_cast<uint32_t *>(cursors + count);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    auto data = static_cast<const std::byte *>(runs[i].data);
+    cursors[i] = {data, data + runs[i].length * comp.size()};
+  }
+  LoserTree<Comp> tree_of_losers(cursors, tree, count, greatest, comp);
+  while (!tree_of_losers.only_greatest_left())
+    emit(tree_of_losers.pop());
+  for (size_t i = 0; i < count; i++) {
+    if (cursors[i].end == nullptr)
+      continue;
+    for (auto p = cursors[i].current; p != cursors[i].end; p += comp.size())
+      emit(p);
+  }
+
+  ::operator delete(heap);
+  return true;
+}
+
+template <typename Comp>
+inline BlobComparator<Comp> comparator_for(const SortedRun *runs,
+                                           size_t count, size_t element_size,
+                                           uintptr_t extra_address,
+                                           Comp compare) {
+  uintptr_t addresses = extra_address;
+  for (size_t i = 0; i < count; i++)
+    addresses |= reinterpret_cast<uintptr_t>(runs[i].data);
+  size_t alignment =
+      guess_alignment(element_size, reinterpret_cast<void *>(addresses));
+  return BlobComparator<Comp>{element_size, alignment, compare};
+}
+} // namespace kmerge
+
+/// Merges the sorted `runs[..count]` into `dest`, which must hold the sum of
+/// their lengths and not overlap them. The merge is stable: equal elements
+/// keep the order of their runs. Returns false without writing anything if
+/// memory for more than `kmerge::MAX_STACK_RUNS` runs cannot be allocated.
+template <typename Comp>
+inline bool merge_runs(const SortedRun *runs, size_t count,
+                       size_t element_size, void *dest, Comp compare) {
+  if (element_size == 0)
+    return true;
+  auto comp = kmerge::comparator_for(
+      runs, count, element_size, reinterpret_cast<uintptr_t>(dest), compare);
+  BlobPtr out = comp.lift(dest);
+  return kmerge::merge(runs, count, comp, [&](const std::byte *element) {
+    comp.lift(const_cast<std::byte *>(element)).copy_nonoverlapping(out);
+    out = out.offset(1);
+  });
+}
+
+/// Like `merge_runs`, but hands the merged elements to
+/// `sink(const void *elements, size_t count)` in small batches instead of
+/// storing them. The batches are only valid during the call.
+template <typename Comp, typename Sink>
+inline bool merge_runs_into(const SortedRun *runs, size_t count,
+                            size_t element_size, Sink sink, Comp compare) {
+  if (element_size == 0)
+    return true;
+  auto comp = kmerge::comparator_for(runs, count, element_size, 0, compare);
+  size_t batch_length =
+      std::max<size_t>(kmerge::SINK_BATCH_BYTES / element_size, 1);
+  auto batch_space = DRIFTSORT_ALLOCA(comp, batch_length);
+  auto batch = static_cast<std::byte *>(comp.lift_alloca(batch_space).get());
+  std::byte *out = batch;
+  std::byte *batch_end = batch + batch_length * element_size;
+  bool merged =
+      kmerge::merge(runs, count, comp, [&](const std::byte *element) {
+        std::memcpy(out, element, element_size);
+        out += element_size;
+        if (out == batch_end) {
+          sink(static_cast<const void *>(batch), batch_length);
+          out = batch;
+        }
+      });
+  if (out != batch)
+    sink(static_cast<const void *>(batch),
+         static_cast<size_t>(out - batch) / element_size);
+  return merged;
+}
+
+} // namespace DRIFTSORT_HIDDEN driftsort
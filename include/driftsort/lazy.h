@@ -0,0 +1,183 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/drift.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/pivot.h"
+#include "driftsort/quicksort.h"
+#include "driftsort/smallsort.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <new>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+
+/// Sorts an array lazily, producing its elements in stable sorted order on
+/// demand.
+///
+/// This is an incremental quicksort. The array is split into the sorted
+/// prefix that has been produced, the range that follows it and a stack of
+/// ranges after that, each of which only holds elements not less than those
+/// before it. To produce the next element only the first pending range is
+/// partitioned, with the pivot selection and stable partitions of
+/// `stable_quicksort`, until it is small enough to be sorted outright.
+///
+/// Taking the first k elements costs O(n + k log k) comparisons and draining
+/// the sorter costs about as much as a full quicksort. Like in
+/// `stable_quicksort`, every range carries a limit on the partitions that
+/// may still lead to it, and a range that reaches it is sorted with
+/// `drift::sort`, so draining never takes more than O(n log n). Elements that
+/// have not been produced yet are in unspecified order.
+template <typename Comp> class LazySorter {
+  // The pending ranges are nested, so each one ends where the next begins.
+  // Every range has a lower limit than the one it was split from, so there
+  // are at most as many as the initial limit.
+  static constexpr size_t MAX_DEPTH = 128;
+
+  BlobComparator<Comp> comp;
+  BlobPtr v;
+  size_t length;
+  void *raw_scratch = nullptr;
+  size_t scratch_length = 0;
+  size_t position = 0;
+  size_t sorted_end = 0;
+  size_t depth = 0;
+  size_t limit;
+  size_t range_ends[MAX_DEPTH];
+  size_t range_limits[MAX_DEPTH];
+
+  size_t range_end() const {
+    return depth != 0 ? range_ends[depth - 1] : length;
+  }
+
+  /// The partitions left for the first pending range before it is sorted
+  /// outright.
+  size_t &range_limit() { return depth != 0 ? range_limits[depth - 1] : limit; }
+
+  /// Extends the sorted prefix beyond `position`.
+  void advance() {
+    BlobPtr scratch{comp.size(), static_cast<std::byte *>(raw_scratch)};
+    for (;;) {
+      size_t end = range_end();
+      size_t range_length = end - position;
+      BlobPtr range = v.offset(position);
+      size_t small_length = quick::smallsort_threshold(comp.size());
+      size_t &partitions_left = range_limit();
+      if (range_length <= small_length || partitions_left == 0) {
+        if (range_length <= small_length)
+          small::small_sort_general(range, range_length, scratch, comp);
+        else
+          drift::sort<true>(range, range_length, scratch, scratch_length,
+                            comp);
+        sorted_end = end;
+        depth -= depth != 0;
+        return;
+      }
+
+      // Both sides of this partition, or what follows the elements equal
+      // to the pivot, get one partition less.
+      partitions_left--;
+      size_t pivot_pos = pivot::choose_pivot(range, range_length, comp);
+      DRIFTSORT_ASSUME(pivot_pos < range_length);
+      size_t left_partition_len = quick::stable_partition<false>(
+          range, range_length, scratch, pivot_pos, comp);
+      if (left_partition_len != 0) {
+        range_ends[depth] = position + left_partition_len;
+        range_limits[depth] = partitions_left;
+        depth++;
+        continue;
+      }
+
+      // The pivot is the minimum. Nothing moved, so it is still at
+      // `pivot_pos`, and the elements equal to it are in sorted order.
+      size_t mid_eq = quick::stable_partition<true>(range, range_length,
+                                                    scratch, pivot_pos, comp);
+      sorted_end = position + mid_eq;
+      if (sorted_end == end)
+        depth -= depth != 0;
+      return;
+    }
+  }
+
+public:
+  class Iterator {
+    LazySorter *sorter = nullptr;
+    void *current = nullptr;
+
+  public:
+    using value_type = void *;
+    using difference_type = ptrdiff_t;
+
+    Iterator() = default;
+    explicit Iterator(LazySorter *sorter)
+        : sorter(sorter), current(sorter->next()) {}
+    void *operator*() const { return current; }
+    Iterator &operator++() {
+      current = sorter->next();
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+    friend bool operator==(const Iterator &it, std::default_sentinel_t) {
+      return it.current == nullptr;
+    }
+  };
+
+  /// Prepares to sort `data` in place. `data` must not be modified by other
+  /// means while elements are taken.
+  LazySorter(void *data, size_t length, size_t element_size, Comp compare)
+      : comp(element_size, guess_alignment(element_size, data), compare),
+        v(comp.lift(data)), length(element_size != 0 ? length : 0),
+        limit(std::min(MAX_DEPTH, size_t{2} * std::bit_width(length | 1))) {
+    if (this->length <= max_len_always_insertion_sort(element_size) ||
+        DRIFTSORT_UNLIKELY(comp.align() > MAX_ALIGNMENT)) {
+      driftsort::qsort_r(data, this->length, element_size, compare);
+      sorted_end = this->length;
+      return;
+    }
+    // Scratch outlives every call, so it always comes from the heap. Without
+    // it the whole array is sorted up front.
+    scratch_length =
+        std::max(length, quick::smallsort_threshold(element_size)) + 16;
+    raw_scratch = ::operator new(scratch_length * comp.size(),
+                                 std::align_val_t{comp.align()}, std::nothrow);
+    if (DRIFTSORT_UNLIKELY(raw_scratch == nullptr)) {
+      driftsort::qsort_r(data, length, element_size, compare);
+      sorted_end = length;
+    }
+  }
+
+  LazySorter(const LazySorter &) = delete;
+  LazySorter &operator=(const LazySorter &) = delete;
+
+  ~LazySorter() {
+    if (raw_scratch != nullptr)
+      ::operator delete(raw_scratch, std::align_val_t{comp.align()});
+  }
+
+  /// Returns the next element in sorted order, or null once all elements
+  /// have been taken.
+  void *next() {
+    if (position == length)
+      return nullptr;
+    if (position == sorted_end)
+      advance();
+    return v.offset(position++);
+  }
+
+  /// Number of elements taken so far. They are `data[..taken()]`.
+  size_t taken() const { return position; }
+
+  Iterator begin() { return Iterator{this}; }
+  std::default_sentinel_t end() const { return {}; }
+};
+
+} // namespace DRIFTSORT_HIDDEN driftsort
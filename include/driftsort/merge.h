@@ -5,10 +5,44 @@
  */
 #pragma once
 #include "driftsort/blob.h"
+#include "driftsort/policy.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 namespace DRIFTSORT_HIDDEN driftsort {
 namespace merge {
+/// How many elements in a row one run must contribute before `merge` gallops
+/// through it when minimizing comparisons.
+inline constexpr size_t MIN_GALLOP = 7;
+
+/// Counts the leading elements of the run `first`, `first + step`, ... of
+/// `length` elements that satisfy `pred`, which holds for a prefix of the
+/// run. Probes 1, 2, 4, ... elements ahead and then binary searches, so that
+/// finding `n` elements takes about 2 log2(n) comparisons.
+template <typename Pred>
+inline size_t gallop(BlobPtr first, ptrdiff_t step, size_t length,
+                     Pred pred) {
+  size_t lo = 0;
+  size_t bound = 1;
+  while (bound <= length &&
+         pred(first.offset(static_cast<ptrdiff_t>(bound - 1) * step))) {
+    lo = bound;
+    bound *= 2;
+  }
+  size_t hi = std::min(bound - 1, length);
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (pred(first.offset(static_cast<ptrdiff_t>(mid) * step)))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
 /// Merges non-decreasing runs `v[..mid]` and `v[mid..]` using `scratch` as
-/// temporary storage, and stores the result into `v[..]`.
+/// temporary storage, and stores the result into `v[..]`. Only the shorter run
+/// is saved, so `scratch` must hold min(mid, length - mid) elements.
 
 template <typename Comp>
 inline void merge(void *raw_v, size_t length, void *raw_scratch,
@@ -21,15 +55,22 @@ inline void merge(void *raw_v, size_t length, void *raw_scratch,
 
     ~MergeState() {
       size_t length = end - start;
-      start.copy_nonoverlapping(dest, length);
+      start.copy_streaming(dest, length);
     }
 
     void merge_up(BlobPtr right, BlobPtr right_end,
+                  policy::Prefetcher prefetcher,
                   const BlobComparator<Comp> &comp) {
       BlobPtr &left = start;
       BlobPtr &out = dest;
 
-      while (left != end && right != right_end) {
+      for (size_t i = 0; left != end && right != right_end; i++) {
+        if (prefetcher.due(i)) {
+          ptrdiff_t ahead = prefetcher.distance(i);
+          DRIFTSORT_PREFETCH_READ(left.offset(ahead).get());
+          DRIFTSORT_PREFETCH_READ(right.offset(ahead).get());
+          DRIFTSORT_PREFETCH_WRITE(out.offset(ahead).get());
+        }
         bool consume_left = !comp(right, left);
         BlobPtr src = consume_left ? left : right;
         src.copy_nonoverlapping(out);
@@ -40,11 +81,20 @@ inline void merge(void *raw_v, size_t length, void *raw_scratch,
     }
 
     void merge_down(BlobPtr left_end, BlobPtr right_end, BlobPtr out,
+                    policy::Prefetcher prefetcher,
                     const BlobComparator<Comp> &comp) {
+      size_t i = 0;
       do {
         BlobPtr left = dest.offset(-1);
         BlobPtr right = end.offset(-1);
         out = out.offset(-1);
+        if (prefetcher.due(i)) {
+          ptrdiff_t ahead = prefetcher.distance(i);
+          DRIFTSORT_PREFETCH_READ(left.offset(-ahead).get());
+          DRIFTSORT_PREFETCH_READ(right.offset(-ahead).get());
+          DRIFTSORT_PREFETCH_WRITE(out.offset(-ahead).get());
+        }
+        i++;
 
         bool consume_left = comp(right, left);
         BlobPtr src = consume_left ? left : right;
@@ -53,12 +103,140 @@ inline void merge(void *raw_v, size_t length, void *raw_scratch,
         end = right.offset(consume_left);
       } while (dest != left_end && end != right_end);
     }
+
+    // Like `merge_up`, but once one run contributes `MIN_GALLOP` elements in
+    // a row, gallops through the runs until that stops paying off.
+    void gallop_up(BlobPtr right, BlobPtr right_end,
+                   const BlobComparator<Comp> &comp) {
+      BlobPtr &left = start;
+      BlobPtr &out = dest;
+      auto take = [&](BlobPtr &src, size_t n) {
+        std::memmove(out, src, n * comp.size());
+        src = src.offset(n);
+        out = out.offset(n);
+      };
+      for (;;) {
+        size_t left_wins = 0;
+        size_t right_wins = 0;
+        do {
+          if (comp(right, left)) {
+            take(right, 1);
+            if (right == right_end)
+              return;
+            right_wins++;
+            left_wins = 0;
+          } else {
+            take(left, 1);
+            if (left == end)
+              return;
+            left_wins++;
+            right_wins = 0;
+          }
+        } while (left_wins < MIN_GALLOP && right_wins < MIN_GALLOP);
+
+        size_t from_left, from_right;
+        do {
+          from_left = gallop(left, 1, end - left,
+                             [&](BlobPtr x) { return !comp(right, x); });
+          take(left, from_left);
+          if (left == end)
+            return;
+          take(right, 1);
+          if (right == right_end)
+            return;
+          from_right = gallop(right, 1, right_end - right,
+                              [&](BlobPtr x) { return comp(x, left); });
+          take(right, from_right);
+          if (right == right_end)
+            return;
+          take(left, 1);
+          if (left == end)
+            return;
+        } while (from_left >= MIN_GALLOP || from_right >= MIN_GALLOP);
+      }
+    }
+
+    // `gallop_up` from the back, for when the right run was saved.
+    void gallop_down(BlobPtr left_begin, BlobPtr out,
+                     const BlobComparator<Comp> &comp) {
+      BlobPtr &left_end = dest;
+      BlobPtr &right_end = end;
+      auto take_left = [&](size_t n) {
+        left_end = left_end.offset(-static_cast<ptrdiff_t>(n));
+        out = out.offset(-static_cast<ptrdiff_t>(n));
+        std::memmove(out, left_end, n * comp.size());
+      };
+      auto take_right = [&](size_t n) {
+        right_end = right_end.offset(-static_cast<ptrdiff_t>(n));
+        out = out.offset(-static_cast<ptrdiff_t>(n));
+        right_end.copy_nonoverlapping(out, n);
+      };
+      for (;;) {
+        size_t left_wins = 0;
+        size_t right_wins = 0;
+        do {
+          if (comp(right_end.offset(-1), left_end.offset(-1))) {
+            take_left(1);
+            if (left_end == left_begin)
+              return;
+            left_wins++;
+            right_wins = 0;
+          } else {
+            take_right(1);
+            if (right_end == start)
+              return;
+            right_wins++;
+            left_wins = 0;
+          }
+        } while (left_wins < MIN_GALLOP && right_wins < MIN_GALLOP);
+
+        size_t from_left, from_right;
+        do {
+          BlobPtr left_last = left_end.offset(-1);
+          from_right =
+              gallop(right_end.offset(-1), -1, right_end - start,
+                     [&](BlobPtr x) { return !comp(x, left_last); });
+          take_right(from_right);
+          if (right_end == start)
+            return;
+          take_left(1);
+          if (left_end == left_begin)
+            return;
+          BlobPtr right_last = right_end.offset(-1);
+          from_left = gallop(left_end.offset(-1), -1, left_end - left_begin,
+                             [&](BlobPtr x) { return comp(right_last, x); });
+          take_left(from_left);
+          if (left_end == left_begin)
+            return;
+          take_right(1);
+          if (right_end == start)
+            return;
+        } while (from_left >= MIN_GALLOP || from_right >= MIN_GALLOP);
+      }
+    }
   };
-  if (mid == 0 || mid >= length || scratch_length < mid ||
-      scratch_length < length - mid)
+  if (mid == 0 || mid >= length || scratch_length < std::min(mid, length - mid))
     return;
 
   BlobPtr v = comp.lift(raw_v);
+  if constexpr (BlobComparator<Comp>::FEWEST_COMPARES) {
+    // Leaves out the elements already in place: those of the left run not
+    // greater than the first of the right run, and those of the right run
+    // not less than the last of the left run.
+    BlobPtr right_first = v.offset(mid);
+    size_t in_place = gallop(v, 1, mid, [&](BlobPtr x) {
+      return !comp(right_first, x);
+    });
+    if (in_place == mid)
+      return;
+    BlobPtr left_last = right_first.offset(-1);
+    size_t in_place_back =
+        gallop(v.offset(length - 1), -1, length - mid,
+               [&](BlobPtr x) { return !comp(x, left_last); });
+    v = v.offset(in_place);
+    mid -= in_place;
+    length -= in_place + in_place_back;
+  }
   BlobPtr scratch = comp.lift(raw_scratch);
   BlobPtr v_mid = v.offset(mid);
   BlobPtr v_end = v.offset(length);
@@ -68,14 +246,20 @@ inline void merge(void *raw_v, size_t length, void *raw_scratch,
   bool left_is_shorter = left_len <= right_len;
   BlobPtr save_base = left_is_shorter ? v : v_mid;
   size_t save_len = left_is_shorter ? left_len : right_len;
-  save_base.copy_nonoverlapping(scratch, save_len);
+  save_base.copy_streaming(scratch, save_len);
 
   MergeState state{scratch, scratch.offset(save_len), save_base};
+  policy::Prefetcher prefetcher(length, v.size());
 
-  if (left_is_shorter) {
-    state.merge_up(v_mid, v_end, comp);
+  if constexpr (BlobComparator<Comp>::FEWEST_COMPARES) {
+    if (left_is_shorter)
+      state.gallop_up(v_mid, v_end, comp);
+    else
+      state.gallop_down(v, v_end, comp);
+  } else if (left_is_shorter) {
+    state.merge_up(v_mid, v_end, prefetcher, comp);
   } else {
-    state.merge_down(v, scratch, v_end, comp);
+    state.merge_down(v, scratch, v_end, prefetcher, comp);
   }
 }
 } // namespace merge
@@ -0,0 +1,87 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/common.h"
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+namespace permute {
+inline void swap_bytes(std::byte *a, std::byte *b, size_t length) {
+  std::byte tmp[64];
+  for (size_t done = 0; done < length; done += sizeof(tmp)) {
+    size_t n = length - done < sizeof(tmp) ? length - done : sizeof(tmp);
+    std::memcpy(tmp, a + done, n);
+    std::memcpy(a + done, b + done, n);
+    std::memcpy(b + done, tmp, n);
+  }
+}
+
+/// Follows the cycles of `perm[..length]` and calls `swap(i, j)` with the
+/// positions whose contents to exchange, so that what was at `perm[i]` ends
+/// up at `i` for every `i` without extra memory. Leaves `perm` as the
+/// identity, which marks the positions already in place.
+template <typename Perm, typename Swap>
+inline void apply_cycles(size_t length, Perm &perm, Swap swap) {
+  using Index = std::remove_cvref_t<decltype(perm[0])>;
+  for (size_t start = 0; start < length; start++) {
+    size_t hole = start;
+    for (;;) {
+      size_t next = static_cast<size_t>(perm[hole]);
+      perm[hole] = static_cast<Index>(hole);
+      if (next == start)
+        break;
+      swap(hole, next);
+      hole = next;
+    }
+  }
+}
+
+/// Moves `data[perm[i]]` to `data[i]` for every `i` without extra memory,
+/// by swapping the element that was at the start of each cycle along it.
+template <typename Perm>
+inline void apply_cycles(std::byte *data, size_t length, size_t element_size,
+                         Perm &perm) {
+  apply_cycles(length, perm, [&](size_t i, size_t j) {
+    swap_bytes(data + i * element_size, data + j * element_size,
+               element_size);
+  });
+}
+
+/// Reorders `data[..length]` so that element `i` becomes the one that was at
+/// `perm[i]`, where `perm[..length]` is a permutation of `0..length`, e.g. one
+/// written by `argsort`. `perm` is anything that can be indexed, such as a
+/// pointer to indices.
+///
+/// Gathers the elements into a copy of the array, then copies that back.
+/// If the copy cannot be allocated, permutes in place instead, which leaves
+/// `perm` as the identity.
+template <typename Perm>
+inline void apply(void *data, size_t length, size_t element_size,
+                  Perm &&perm) {
+  if (length < 2)
+    return;
+  auto base = static_cast<std::byte *>(data);
+  size_t bytes = length * element_size;
+  void *copy = ::operator new(bytes, std::nothrow);
+  if (DRIFTSORT_UNLIKELY(copy == nullptr)) {
+    apply_cycles(base, length, element_size, perm);
+    return;
+  }
+  auto gathered = static_cast<std::byte *>(copy);
+  for (size_t i = 0; i < length; i++)
+    std::memcpy(gathered + i * element_size,
+                base + static_cast<size_t>(perm[i]) * element_size,
+                element_size);
+  std::memcpy(base, gathered, bytes);
+  ::operator delete(copy);
+}
+} // namespace permute
+} // namespace DRIFTSORT_HIDDEN driftsort
@@ -7,13 +7,11 @@
 #pragma once
 
 #include "driftsort/blob.h"
+#include "driftsort/policy.h"
 #include <cstddef>
 
 namespace DRIFTSORT_HIDDEN driftsort {
 namespace pivot {
-// Recursively select a pseudomedian if above this threshold.
-inline constexpr size_t PSEUDO_MEDIAN_REC_THRESHOLD = 64;
-
 /// Calculates the median of 3 elements.
 ///
 /// SAFETY: a, b, c must be valid initialized elements.
@@ -49,7 +47,7 @@ inline void *recursive_median_of_3(void *raw_a, void *raw_b, void *raw_c,
   BlobPtr a = comp.lift(raw_a);
   BlobPtr b = comp.lift(raw_b);
   BlobPtr c = comp.lift(raw_c);
-  if (n * 8 >= PSEUDO_MEDIAN_REC_THRESHOLD) {
+  if (n * 8 >= policy::tuning(comp.size()).pseudo_median_rec_threshold) {
     size_t n8 = n / 8;
     raw_a =
         recursive_median_of_3(a, a.offset(n8 * 4), a.offset(n8 * 7), n8, comp);
@@ -74,7 +72,8 @@ inline size_t choose_pivot(void *raw_v, size_t length,
   BlobPtr b = v.offset(length_div_8 * 4);
   BlobPtr c = v.offset(length_div_8 * 7);
 
-  if (length < PSEUDO_MEDIAN_REC_THRESHOLD)
+  // Recursively select a pseudomedian if above the threshold.
+  if (length < policy::tuning(comp.size()).pseudo_median_rec_threshold)
     return static_cast<size_t>(comp.lift(median_of_3(a, b, c, comp)) - v);
 
   return static_cast<size_t>(
@@ -0,0 +1,226 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/common.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+// A header generated by driftsort-tune, which defines DRIFTSORT_TUNING and
+// DRIFTSORT_PARTITION_UNROLL for the machine it ran on.
+#ifdef DRIFTSORT_POLICY_HEADER
+#include DRIFTSORT_POLICY_HEADER
+#endif
+
+namespace DRIFTSORT_HIDDEN driftsort {
+namespace policy {
+/// The tuning constants of the sort for one class of element sizes.
+struct Tuning {
+  // Ranges up to this length are sorted by `small::small_sort_general`
+  // rather than partitioned.
+  size_t smallsort_threshold;
+  // Arrays up to this length are insertion sorted without any scratch.
+  size_t max_len_always_insertion_sort;
+  // Below the square of this length, runs of at least this length (or half
+  // the array) are kept; above it, runs of sqrt(length).
+  size_t min_sqrt_run_len;
+  // Pivots of longer ranges are recursive pseudomedians.
+  size_t pseudo_median_rec_threshold;
+  // Scratch space of at most this many elements is allocated on the stack.
+  size_t heap_alloc_threshold;
+  // Scratch for the whole array is allocated up to this many bytes, beyond
+  // that for half of it.
+  size_t max_full_alloc_bytes;
+};
+
+// Element sizes up to 4, 8 and 16 bytes, and larger ones.
+inline constexpr size_t SIZE_CLASSES = 4;
+
+inline constexpr size_t size_class(size_t element_size) {
+  return std::min<size_t>(std::bit_width((element_size - 1) | 3) - 2,
+                          SIZE_CLASSES - 1);
+}
+
+// The tuning every size class gets unless DRIFTSORT_TUNING says otherwise.
+inline constexpr Tuning DEFAULT_TUNING = {32, 20, 64, 64, 4096, 8 << 20};
+inline constexpr size_t DEFAULT_PARTITION_UNROLL = 4;
+
+/// Whether the sort works with `tuning`. Larger values than these bounds
+/// would put too much on the stack.
+inline constexpr bool valid(const Tuning &tuning) {
+  return tuning.smallsort_threshold >= 8 &&
+         tuning.smallsort_threshold <= 128 &&
+         tuning.max_len_always_insertion_sort >= 1 &&
+         tuning.max_len_always_insertion_sort <= 64 &&
+         tuning.min_sqrt_run_len >= 1 && tuning.min_sqrt_run_len <= 4096 &&
+         tuning.pseudo_median_rec_threshold >= 8 &&
+         tuning.heap_alloc_threshold <= 16384;
+}
+
+inline constexpr bool valid_unroll(size_t unroll) {
+  return unroll == 1 || unroll == 2 || unroll == 4 || unroll == 8;
+}
+
+#ifdef DRIFTSORT_TUNING
+#define DRIFTSORT_TUNING_INIT DRIFTSORT_TUNING
+#else
+#define DRIFTSORT_TUNING_INIT                                                  \
+  { DEFAULT_TUNING, DEFAULT_TUNING, DEFAULT_TUNING, DEFAULT_TUNING }
+#endif
+#ifdef DRIFTSORT_PARTITION_UNROLL
+#define DRIFTSORT_PARTITION_UNROLL_INIT DRIFTSORT_PARTITION_UNROLL
+#else
+#define DRIFTSORT_PARTITION_UNROLL_INIT DEFAULT_PARTITION_UNROLL
+#endif
+
+#ifdef DRIFTSORT_TUNABLE
+// Built into driftsort-tune, which changes the tuning between runs.
+inline Tuning TUNING[SIZE_CLASSES] = DRIFTSORT_TUNING_INIT;
+inline size_t PARTITION_UNROLL = DRIFTSORT_PARTITION_UNROLL_INIT;
+#else
+inline constexpr Tuning TUNING[SIZE_CLASSES] = DRIFTSORT_TUNING_INIT;
+// Comparisons per iteration of the unrolled partition loop.
+inline constexpr size_t PARTITION_UNROLL = DRIFTSORT_PARTITION_UNROLL_INIT;
+static_assert(std::all_of(std::begin(TUNING), std::end(TUNING), valid),
+              "DRIFTSORT_TUNING is out of bounds");
+static_assert(valid_unroll(PARTITION_UNROLL),
+              "DRIFTSORT_PARTITION_UNROLL must be 1, 2, 4 or 8");
+#endif
+#undef DRIFTSORT_TUNING_INIT
+#undef DRIFTSORT_PARTITION_UNROLL_INIT
+
+/// The tuning for elements of `element_size` bytes.
+inline const Tuning &tuning(size_t element_size) {
+  return TUNING[size_class(element_size)];
+}
+
+// Loops over at least this many bytes prefetch their streams. Smaller arrays
+// mostly fit in the last level cache, where the hints only cost
+// instructions. Defining DRIFTSORT_PREFETCH_MIN_BYTES to SIZE_MAX turns
+// prefetching off.
+#ifdef DRIFTSORT_PREFETCH_MIN_BYTES
+inline constexpr size_t PREFETCH_MIN_BYTES = DRIFTSORT_PREFETCH_MIN_BYTES;
+#else
+inline constexpr size_t PREFETCH_MIN_BYTES = size_t{32} << 20;
+#endif
+// How far ahead of each stream to prefetch. This covers the memory latency
+// at the rate a comparison-bound loop consumes cache lines.
+inline constexpr size_t PREFETCH_DISTANCE_BYTES = 1024;
+inline constexpr size_t CACHE_LINE_BYTES = 64;
+
+/// The size of the last level cache in bytes, or zero if the platform does
+/// not tell.
+inline size_t last_level_cache_bytes() {
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+  // CPUs without a third level report zero for it.
+  long bytes = ::sysconf(_SC_LEVEL3_CACHE_SIZE);
+  if (bytes <= 0)
+    bytes = ::sysconf(_SC_LEVEL2_CACHE_SIZE);
+  return bytes > 0 ? static_cast<size_t>(bytes) : 0;
+#elif defined(__APPLE__)
+  for (const char *name : {"hw.l3cachesize", "hw.l2cachesize"}) {
+    int64_t bytes = 0;
+    size_t length = sizeof(bytes);
+    if (::sysctlbyname(name, &bytes, &length, nullptr, 0) == 0 && bytes > 0)
+      return static_cast<size_t>(bytes);
+  }
+  return 0;
+#else
+  return 0;
+#endif
+}
+
+// Bulk copies of at least `streaming_store_min_bytes()` use non-temporal
+// stores where available, see `BlobPtr::copy_streaming`. A copy pulls both
+// its source and its destination through the cache, so one of more than
+// half of the last level cache has evicted the start of its destination by
+// the time it ends, along with what other threads keep there. Where the
+// size of the cache is unknown, the threshold is this many bytes.
+inline constexpr size_t STREAMING_STORE_FALLBACK_BYTES = size_t{32} << 20;
+
+/// The threshold of `BlobPtr::copy_streaming`, half of the last level cache,
+/// which is looked up once. The memcpy of glibc already switches to faster
+/// non-temporal stores of its own above a similar share of the cache, so
+/// there they stay off. Defining DRIFTSORT_STREAMING_STORE_MIN_BYTES
+/// overrides the threshold, and SIZE_MAX turns them off everywhere.
+inline size_t streaming_store_min_bytes() {
+#ifdef DRIFTSORT_STREAMING_STORE_MIN_BYTES
+  return DRIFTSORT_STREAMING_STORE_MIN_BYTES;
+#elif defined(__GLIBC__)
+  return SIZE_MAX;
+#else
+  static const size_t bytes = [] {
+    size_t cache = last_level_cache_bytes();
+    return cache != 0 ? cache / 2 : STREAMING_STORE_FALLBACK_BYTES;
+  }();
+  return bytes;
+#endif
+}
+
+// Scratch buffers of at least this many bytes are mapped with transparent
+// huge pages where supported, see `hugepage::allocate`. Defining
+// DRIFTSORT_HUGE_PAGE_MIN_BYTES to SIZE_MAX always uses `operator new`.
+#ifdef DRIFTSORT_HUGE_PAGE_MIN_BYTES
+inline constexpr size_t HUGE_PAGE_MIN_BYTES = DRIFTSORT_HUGE_PAGE_MIN_BYTES;
+#else
+inline constexpr size_t HUGE_PAGE_MIN_BYTES = size_t{32} << 20;
+#endif
+// Whether huge page scratch is faulted in before sorting starts.
+#ifdef DRIFTSORT_HUGE_PAGE_POPULATE
+inline constexpr bool HUGE_PAGE_POPULATE = DRIFTSORT_HUGE_PAGE_POPULATE;
+#else
+inline constexpr bool HUGE_PAGE_POPULATE = false;
+#endif
+
+/// Decides whether and how far a loop over `length` elements of
+/// `element_size` bytes prefetches its streams. Each stream advances by at
+/// most one element per iteration, so prefetching once per cache line of
+/// iterations keeps all of them covered. The next line to prefetch for is
+/// tracked as an element position, so that loops may skip positions.
+class Prefetcher {
+  size_t ahead = 0;
+  size_t step = 1;
+  size_t next = 0;
+
+public:
+  /// For a loop whose first iteration is element `start`.
+  Prefetcher(size_t length, size_t element_size, size_t start = 0)
+      : next(start) {
+    if (length * element_size < PREFETCH_MIN_BYTES)
+      return;
+    ahead = std::max<size_t>(PREFETCH_DISTANCE_BYTES / element_size, 2);
+    step = std::max<size_t>(CACHE_LINE_BYTES / element_size, 1);
+  }
+
+  /// Whether the loop, having reached element `i`, should prefetch for one
+  /// more cache line of elements, which this moves past. A loop that does
+  /// not check every element calls this until it returns false.
+  bool due(size_t i) {
+    if (ahead == 0 || i < next)
+      return false;
+    next += step;
+    return true;
+  }
+  /// How many elements ahead of element `i` of each stream to prefetch for
+  /// the cache line `due` last moved past.
+  ptrdiff_t distance(size_t i) const {
+    return static_cast<ptrdiff_t>(ahead + next - step) -
+           static_cast<ptrdiff_t>(i);
+  }
+};
+} // namespace policy
+} // namespace DRIFTSORT_HIDDEN driftsort
@@ -0,0 +1,123 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/drift.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+namespace presort {
+/// What a sample of about sqrt(length) places of an array says about its
+/// order. The counts are of sampled pairs, so their ratios estimate the
+/// whole array.
+struct Estimate {
+  /// Adjacent pairs sampled.
+  size_t pairs;
+  /// Adjacent pairs that descend, about one per run boundary.
+  size_t descents;
+  /// Pairs of consecutive samples, `length / pairs` apart.
+  size_t spread_pairs;
+  /// Those that descend, about the fraction of pairs that are inversions.
+  size_t spread_descents;
+};
+
+/// How `driftsort` sorts an array, by what `estimate` says about it.
+enum class Strategy {
+  /// One ascending or strictly descending run up to a short tail: scan the
+  /// run, reverse it if need be, and sort and merge in only the tail.
+  presorted,
+  /// Runs shorter than the default threshold of sqrt(length): keep runs
+  /// about as long as the sample finds.
+  runs,
+  /// No order to exploit: the default, where lazy unsorted runs combine
+  /// into one quicksort. Many duplicates need no strategy of their own:
+  /// with a three-way comparator every partition already separates the
+  /// elements equal to the pivot in the same scan, and with a plain one
+  /// telling them apart takes a second comparison per element, which costs
+  /// more than the equal partitions it would save.
+  shuffled,
+};
+inline constexpr size_t STRATEGIES = 3;
+
+inline constexpr const char *NAMES[STRATEGIES] = {"presorted", "runs",
+                                                  "shuffled"};
+
+inline const char *name(Strategy strategy) {
+  return NAMES[static_cast<size_t>(strategy)];
+}
+
+/// Arrays this long and longer are sampled before sorting. Shorter ones
+/// get scratch on the stack, and samples too small to go by.
+inline constexpr size_t MIN_LENGTH = 4096;
+/// A sample is presorted if no more than one in this many pairs goes
+/// against the order of the others.
+inline constexpr size_t PRESORTED_NOISE = 32;
+/// `Strategy::presorted` sorts the tail after the leading run separately
+/// only if the tail is at most this fraction of the array.
+inline constexpr size_t MAX_TAIL_FRACTION = 8;
+/// Runs are worth keeping if the sample finds them this long on average.
+inline constexpr size_t MIN_SAMPLED_RUN = 32;
+
+/// Samples about sqrt(length) adjacent pairs, one at a pseudorandom place
+/// in each of as many equal blocks, and the pairs of consecutive samples,
+/// with one comparison each. Sampling at even spacing instead would miss
+/// every run boundary of runs as long as a divisor of the spacing.
+template <typename Comp>
+inline Estimate estimate(void *raw_v, size_t length,
+                         const BlobComparator<Comp> &comp) {
+  Estimate estimate{};
+  if (length < 2)
+    return estimate;
+  BlobPtr v = comp.lift(raw_v);
+  size_t samples = std::min(drift::approximate_sqrt(length), length - 1);
+  size_t stride = (length - 1) / samples;
+  BlobPtr prev;
+  for (size_t i = 0; i < samples; i++) {
+    uint64_t jitter = (i * UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+    BlobPtr at = v.offset(i * stride + jitter % stride);
+    estimate.descents += comp(at.offset(1), at);
+    if (i > 0)
+      estimate.spread_descents += comp(at, prev);
+    prev = at;
+  }
+  estimate.pairs = samples;
+  estimate.spread_pairs = samples - 1;
+  return estimate;
+}
+
+/// Whether the sample goes one way, ascending or descending, with at most
+/// one pair in `PRESORTED_NOISE` going the other.
+inline bool one_way(size_t pairs, size_t descents) {
+  size_t ascents = pairs - descents;
+  return std::min(ascents, descents) * PRESORTED_NOISE <= pairs;
+}
+
+inline Strategy choose(const Estimate &estimate) {
+  bool ascending = estimate.descents * 2 <= estimate.pairs;
+  bool spread_ascending =
+      estimate.spread_descents * 2 <= estimate.spread_pairs;
+  if (ascending == spread_ascending &&
+      one_way(estimate.pairs, estimate.descents) &&
+      one_way(estimate.spread_pairs, estimate.spread_descents))
+    return Strategy::presorted;
+  if (estimate.descents * MIN_SAMPLED_RUN <= estimate.pairs)
+    return Strategy::runs;
+  return Strategy::shuffled;
+}
+
+/// The shortest runs `Strategy::runs` keeps: half the average the sample
+/// finds, and no fewer than `MIN_SAMPLED_RUN`.
+inline size_t run_threshold(const Estimate &estimate) {
+  size_t average = estimate.pairs / std::max<size_t>(estimate.descents, 1);
+  return std::max(average / 2, MIN_SAMPLED_RUN);
+}
+} // namespace presort
+} // namespace DRIFTSORT_HIDDEN driftsort
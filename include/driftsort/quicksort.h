@@ -9,17 +9,41 @@
 #include "driftsort/blob.h"
 #include "driftsort/common.h"
 #include "driftsort/pivot.h"
+#include "driftsort/policy.h"
 #include "driftsort/smallsort.h"
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 namespace DRIFTSORT_HIDDEN driftsort {
 
 namespace drift {
 template <bool eager_sort, typename Comp>
 void sort(void *raw_v, size_t length, void *raw_scratch, size_t scratch_length,
-          const BlobComparator<Comp> &comp);
+          const BlobComparator<Comp> &comp, size_t run_threshold = SIZE_MAX);
 }
 
 namespace quick {
+/// Calls `f` with `policy::PARTITION_UNROLL` as a `std::integral_constant`,
+/// so that loops over it unroll even where the tuning is only known at run
+/// time.
+template <typename F> inline void with_partition_unroll(F f) {
+#ifdef DRIFTSORT_TUNABLE
+  switch (policy::PARTITION_UNROLL) {
+  case 1:
+    return f(std::integral_constant<size_t, 1>{});
+  case 2:
+    return f(std::integral_constant<size_t, 2>{});
+  case 8:
+    return f(std::integral_constant<size_t, 8>{});
+  default:
+    return f(std::integral_constant<size_t, 4>{});
+  }
+#else
+  f(std::integral_constant<size_t, policy::PARTITION_UNROLL>{});
+#endif
+}
+
 /// Partitions `v` using pivot `p = v[pivot_pos]` and returns the number of
 /// elements less than `p`. The relative order of elements that compare < p and
 /// those that compare >= p is preserved - it is a stable partition.
@@ -69,6 +93,15 @@ inline size_t stable_partition(void *raw_v, size_t length, void *raw_scratch,
       scan = scan.offset(1);
       return dst;
     }
+
+    /// Prefetches the scanned elements and both sides of `scratch`
+    /// `distance` elements beyond the current positions.
+    void prefetch(ptrdiff_t distance) const {
+      auto left = static_cast<ptrdiff_t>(num_left);
+      DRIFTSORT_PREFETCH_READ(scan.offset(distance).get());
+      DRIFTSORT_PREFETCH_WRITE(scratch.offset(left + distance).get());
+      DRIFTSORT_PREFETCH_WRITE(scratch_rev.offset(left - distance).get());
+    }
   };
 
   BlobPtr v = comp.lift(raw_v);
@@ -83,13 +116,20 @@ inline size_t stable_partition(void *raw_v, size_t length, void *raw_scratch,
   PartitionState state(v, scratch, length);
   BlobPtr pivot_in_scratch;
   size_t loop_end_pos = pivot_pos;
+  policy::Prefetcher prefetcher(length, v.size());
   for (;;) {
-    constexpr size_t UNROLL = 4;
-    BlobPtr unroll_end = v.offset(saturating_sub(loop_end_pos, UNROLL - 1));
-    while (state.scan < unroll_end) {
-      for (size_t i = 0; i < UNROLL; i++)
-        state.partition_once(compare(state.scan, pivot));
-    }
+    with_partition_unroll([&](auto unroll) {
+      constexpr size_t UNROLL = decltype(unroll)::value;
+      BlobPtr unroll_end = v.offset(saturating_sub(loop_end_pos, UNROLL - 1));
+      while (state.scan < unroll_end) {
+        // The next `UNROLL` elements may reach into several cache lines.
+        size_t scanned = state.scan - v;
+        while (prefetcher.due(scanned + UNROLL - 1))
+          state.prefetch(prefetcher.distance(scanned));
+        for (size_t i = 0; i < UNROLL; i++)
+          state.partition_once(compare(state.scan, pivot));
+      }
+    });
 
     BlobPtr loop_end = v.offset(loop_end_pos);
     while (state.scan < loop_end)
@@ -102,20 +142,116 @@ inline size_t stable_partition(void *raw_v, size_t length, void *raw_scratch,
     loop_end_pos = length;
   }
 
-  scratch.copy_nonoverlapping(v, state.num_left);
-  for (size_t i = 0, end = length - state.num_left; i < end; i++)
-    scratch.offset(length - 1 - i)
-        .copy_nonoverlapping(v.offset(state.num_left + i));
+  scratch.copy_streaming(v, state.num_left);
+  BlobPtr scratch_last = scratch.offset(length - 1);
+  policy::Prefetcher reverse_prefetcher(length, v.size());
+  for (size_t i = 0, end = length - state.num_left; i < end; i++) {
+    BlobPtr src = scratch_last.offset(-static_cast<ptrdiff_t>(i));
+    if (reverse_prefetcher.due(i))
+      DRIFTSORT_PREFETCH_READ(
+          src.offset(-reverse_prefetcher.distance(i)).get());
+    src.copy_nonoverlapping(v.offset(state.num_left + i));
+  }
 
   return state.num_left;
 }
 
+/// The scan of a three-way partition, using the full result of a three-way
+/// comparator. Reads `length` elements from `src` onwards in steps of `step`,
+/// which is 1 or -1. Elements less than `pivot` go to the front of `dst` in
+/// scan order and greater ones to its back in reverse scan order. Equal ones
+/// are compacted behind the scan, so that they are the first elements read
+/// from `src` in the end. Returns the number of less elements and stores the
+/// number of equal ones in `num_equal`.
+///
+/// `pivot` must not point into `src`, and `dst` must hold `length` elements.
+template <typename Comp>
+inline size_t partition_three_way_scan(BlobPtr src, ptrdiff_t step,
+                                       size_t length, BlobPtr dst,
+                                       const void *pivot, size_t &num_equal,
+                                       const BlobComparator<Comp> &comp) {
+  BlobPtr dst_end = dst.offset(length);
+  size_t num_less = 0;
+  size_t num_greater = 0;
+  size_t num_eq = 0;
+  policy::Prefetcher prefetcher(length, src.size());
+  for (size_t i = 0; i < length; i++) {
+    BlobPtr scan = src.offset(step * static_cast<ptrdiff_t>(i));
+    if (prefetcher.due(i)) {
+      ptrdiff_t ahead = prefetcher.distance(i);
+      auto less = static_cast<ptrdiff_t>(num_less);
+      auto greater = static_cast<ptrdiff_t>(num_greater);
+      DRIFTSORT_PREFETCH_READ(scan.offset(step * ahead).get());
+      DRIFTSORT_PREFETCH_WRITE(dst.offset(less + ahead).get());
+      DRIFTSORT_PREFETCH_WRITE(dst_end.offset(-1 - greater - ahead).get());
+    }
+    int ordering = comp.compare_three_way(scan, pivot);
+    bool is_less = ordering < 0;
+    bool is_equal = ordering == 0;
+    // The outcome is unpredictable, so the destination is selected with
+    // masks, which compilers cannot turn back into branches. An equal element
+    // may be copied onto itself, which is harmless.
+    uintptr_t less_mask = -uintptr_t{is_less};
+    uintptr_t equal_mask = -uintptr_t{is_equal};
+    uintptr_t target =
+        (reinterpret_cast<uintptr_t>(dst.offset(num_less).get()) &
+         less_mask) |
+        (reinterpret_cast<uintptr_t>(
+             src.offset(step * static_cast<ptrdiff_t>(num_eq)).get()) &
+         equal_mask) |
+        (reinterpret_cast<uintptr_t>(
+             dst_end.offset(-1 - static_cast<ptrdiff_t>(num_greater)).get()) &
+         ~(less_mask | equal_mask));
+    scan.copy_nonoverlapping(comp.lift(reinterpret_cast<void *>(target)));
+    num_less += is_less;
+    num_eq += is_equal;
+    num_greater = i + 1 - num_less - num_eq;
+  }
+  num_equal = num_eq;
+  return num_less;
+}
+
+/// Partitions `v` into the elements less than, equal to and greater than
+/// `pivot` in a single scan. Each of the three parts keeps its input order.
+/// Returns the number of elements less than `pivot` and stores the number of
+/// elements equal to it in `num_equal`.
+///
+/// Less and greater elements go to the two ends of `scratch` as in
+/// `stable_partition`, while equal ones are compacted to the front of `v`,
+/// behind the scan. `pivot` must therefore not point into `v`, and
+/// `scratch` must hold `length` elements.
+template <typename Comp>
+inline size_t stable_partition_three_way(void *raw_v, size_t length,
+                                         void *raw_scratch, const void *pivot,
+                                         size_t &num_equal,
+                                         const BlobComparator<Comp> &comp) {
+  BlobPtr v = comp.lift(raw_v);
+  BlobPtr scratch = comp.lift(raw_scratch);
+  size_t num_less =
+      partition_three_way_scan(v, 1, length, scratch, pivot, num_equal, comp);
+
+  std::memmove(v.offset(num_less), v, num_equal * v.size());
+  scratch.copy_nonoverlapping(v, num_less);
+  size_t greater_start = num_less + num_equal;
+  for (size_t i = 0, end = length - greater_start; i < end; i++)
+    scratch.offset(length - 1 - i)
+        .copy_nonoverlapping(v.offset(greater_start + i));
+  return num_less;
+}
+
+/// Ranges up to this length are sorted by `small::small_sort_general`.
+inline size_t smallsort_threshold(size_t element_size) {
+  return policy::tuning(element_size).smallsort_threshold;
+}
+
 /// Sorts `v` recursively using quicksort.
 ///
 /// `limit` when initialized with `c*log(v.len())` for some c ensures we do not
 /// overflow the stack or go quadratic.
 ///
-inline constexpr size_t SMALLSORT_THRESHOLD = 32;
+/// With a `ThreeWay` comparator every partition also separates the elements
+/// equal to the pivot, and `left_ancestor_pivot` is not needed.
+///
 template <typename Comp>
 inline void stable_quicksort(void *raw_v, size_t length, void *raw_scratch,
                              size_t scratch_length, size_t limit,
@@ -123,10 +259,15 @@ inline void stable_quicksort(void *raw_v, size_t length, void *raw_scratch,
                              const BlobComparator<Comp> &comp) {
   BlobPtr v = comp.lift(raw_v);
   BlobPtr scratch = comp.lift(raw_scratch);
+  size_t small_length = smallsort_threshold(comp.size());
 
   for (;;) {
-    if (length <= SMALLSORT_THRESHOLD) {
+    if (comp.cancelled())
+      return;
+
+    if (length <= small_length) {
       small::small_sort_general(v, length, scratch, comp);
+      comp.progress(length);
       return;
     }
 
@@ -144,6 +285,20 @@ inline void stable_quicksort(void *raw_v, size_t length, void *raw_scratch,
     BlobPtr pivot_copy = comp.lift_alloca(pivot_copy_space);
     v.offset(pivot_pos).copy_nonoverlapping(pivot_copy);
 
+    if constexpr (BlobComparator<Comp>::THREE_WAY) {
+      // The elements equal to the pivot come out of the same scan and are
+      // already sorted, so neither side ever needs an equal partition.
+      size_t num_equal;
+      size_t num_less = stable_partition_three_way(v, length, scratch,
+                                                   pivot_copy, num_equal, comp);
+      comp.progress(length);
+      size_t right_start = num_less + num_equal;
+      stable_quicksort(v.offset(right_start), length - right_start, scratch,
+                       scratch_length, limit, nullptr, comp);
+      length = num_less;
+      continue;
+    }
+
     // We choose a pivot, and check if this pivot is equal to our left
     // ancestor. If true, we do a partition putting equal elements on the
     // left and do not recurse on it. This gives O(n log k) sorting for k
@@ -164,12 +319,14 @@ inline void stable_quicksort(void *raw_v, size_t length, void *raw_scratch,
     if (perform_equal_partition) {
       size_t mid_eq =
           stable_partition<true>(v, length, scratch, pivot_pos, comp);
+      comp.progress(length);
       v = v.offset(mid_eq);
       length -= mid_eq;
       left_ancestor_pivot = nullptr;
       continue;
     }
 
+    comp.progress(length);
     BlobPtr right = v.offset(left_partition_len);
     size_t right_len = length - left_partition_len;
     stable_quicksort(right, right_len, scratch, scratch_length, limit,
@@ -178,5 +335,187 @@ inline void stable_quicksort(void *raw_v, size_t length, void *raw_scratch,
   }
 }
 
+/// Arrays of at least this many bytes are sorted by `ping_pong_quicksort`
+/// when scratch for all of them is available. Below that size the array
+/// stays in cache and the copy back after each partition is cheap.
+inline constexpr size_t PING_PONG_MIN_BYTES = 1 << 20;
+/// Scratch for the leaves of `ping_pong_quicksort`, in elements.
+inline size_t ping_pong_small_scratch_length(size_t element_size) {
+  return 2 * smallsort_threshold(element_size) + 16;
+}
+
+/// The scan of a two-way partition for `ping_pong_quicksort`. Reads `length`
+/// elements from `src` onwards in steps of `step`, which is 1 or -1. Elements
+/// that go left, as in `stable_partition`, are written to the front of `dst`
+/// in scan order and the others to its back in reverse scan order. Returns
+/// the number of elements that went left.
+template <bool InvertComparison, typename Comp>
+inline size_t partition_scan(BlobPtr src, ptrdiff_t step, size_t length,
+                             BlobPtr dst, const void *pivot,
+                             const BlobComparator<Comp> &comp) {
+  size_t num_left = 0;
+  policy::Prefetcher prefetcher(length, src.size());
+  for (size_t i = 0; i < length; i++) {
+    BlobPtr scan = src.offset(step * static_cast<ptrdiff_t>(i));
+    if (prefetcher.due(i)) {
+      ptrdiff_t ahead = prefetcher.distance(i);
+      auto left = static_cast<ptrdiff_t>(num_left);
+      DRIFTSORT_PREFETCH_READ(scan.offset(step * ahead).get());
+      DRIFTSORT_PREFETCH_WRITE(dst.offset(left + ahead).get());
+      DRIFTSORT_PREFETCH_WRITE(
+          dst.offset(length - 1 - i).offset(left - ahead).get());
+    }
+    bool towards_left;
+    if constexpr (InvertComparison)
+      towards_left = !comp(pivot, scan);
+    else
+      towards_left = comp(scan, pivot);
+    // Offsetting the back by `num_left` as well turns `length - 1 - i` into
+    // the next free slot from the back.
+    BlobPtr base = towards_left ? dst : dst.offset(length - 1 - i);
+    scan.copy_nonoverlapping(base.offset(num_left));
+    num_left += towards_left;
+  }
+  return num_left;
+}
+
+/// Copies `src[..length]` to `dst`, reversing it if `reversed` is set.
+inline void copy_oriented(BlobPtr src, size_t length, bool reversed,
+                          BlobPtr dst) {
+  if (!reversed) {
+    src.copy_nonoverlapping(dst, length);
+    return;
+  }
+  for (size_t i = 0; i < length; i++)
+    src.offset(length - 1 - i).copy_nonoverlapping(dst.offset(i));
+}
+
+/// Reverses `v[..length]`, using `tmp` to hold one element.
+inline void reverse(BlobPtr v, size_t length, BlobPtr tmp) {
+  for (size_t i = 0; i < length / 2; i++) {
+    v.offset(i).copy_nonoverlapping(tmp);
+    v.offset(length - 1 - i).copy_nonoverlapping(v.offset(i));
+    tmp.copy_nonoverlapping(v.offset(length - 1 - i));
+  }
+}
+
+/// Sorts the range at `v` like `stable_quicksort`, but partitions from one
+/// buffer into the other instead of copying each partition back: `v` and
+/// `scratch` are the range's place in the array and in a scratch buffer of
+/// the same size, and `in_scratch` tells which one currently holds its
+/// elements. The right side of a partition is written backwards, so
+/// `reversed` tells whether the elements are stored in reverse order, in
+/// which case the next partition scans them backwards to stay stable.
+///
+/// Elements only return to the array once they are final: at leaves, which
+/// are sorted in place, and as runs of elements equal to a pivot. This saves
+/// a full copy per recursion level. `small_scratch` holds
+/// `ping_pong_small_scratch_length` elements for the leaves.
+template <typename Comp>
+inline void ping_pong_quicksort(BlobPtr v, BlobPtr scratch, size_t length,
+                                bool in_scratch, bool reversed, size_t limit,
+                                void *left_ancestor_pivot,
+                                BlobPtr small_scratch,
+                                const BlobComparator<Comp> &comp) {
+  auto pivot_copy_space = DRIFTSORT_ALLOCA(comp, 1);
+  BlobPtr pivot_copy = comp.lift_alloca(pivot_copy_space);
+  size_t small_length = smallsort_threshold(comp.size());
+
+  for (;;) {
+    BlobPtr src = in_scratch ? scratch : v;
+    BlobPtr dst = in_scratch ? v : scratch;
+
+    // A cancelled sort still puts the range back into the array.
+    bool cancelled = comp.cancelled();
+    if (length <= small_length || limit == 0 || cancelled) {
+      if (in_scratch)
+        copy_oriented(src, length, reversed, v);
+      else if (reversed)
+        reverse(v, length, pivot_copy);
+      if (cancelled)
+        return;
+      // The range is back in the array, so its part of `scratch` is free.
+      if (length <= small_length)
+        small::small_sort_general(v, length, small_scratch, comp);
+      else if (length <= small_length + 16)
+        drift::sort<true>(v, length, small_scratch,
+                          ping_pong_small_scratch_length(comp.size()), comp);
+      else
+        drift::sort<true>(v, length, scratch, length, comp);
+      if (length <= small_length)
+        comp.progress(length);
+      return;
+    }
+
+    limit--;
+
+    size_t pivot_pos = pivot::choose_pivot(src, length, comp);
+    DRIFTSORT_ASSUME(pivot_pos < length);
+    src.offset(pivot_pos).copy_nonoverlapping(pivot_copy);
+    ptrdiff_t step = reversed ? -1 : 1;
+    BlobPtr first = reversed ? src.offset(length - 1) : src;
+
+    if constexpr (BlobComparator<Comp>::THREE_WAY) {
+      // The equal elements are final. They are compacted at the start of the
+      // scan in `src` and pass through the free middle of `dst`.
+      size_t num_equal;
+      size_t num_less = partition_three_way_scan(first, step, length, dst,
+                                                 pivot_copy, num_equal, comp);
+      for (size_t i = 0; i < num_equal; i++)
+        first.offset(step * static_cast<ptrdiff_t>(i))
+            .copy_nonoverlapping(dst.offset(num_less + i));
+      if (!in_scratch)
+        dst.offset(num_less).copy_nonoverlapping(v.offset(num_less),
+                                                 num_equal);
+      comp.progress(length);
+      size_t right_start = num_less + num_equal;
+      ping_pong_quicksort(v.offset(right_start), scratch.offset(right_start),
+                          length - right_start, !in_scratch, true, limit,
+                          nullptr, small_scratch, comp);
+      length = num_less;
+      in_scratch = !in_scratch;
+      reversed = false;
+      continue;
+    }
+
+    // Same equal-element handling as in `stable_quicksort`. The source is
+    // left intact by a scan, so the equal partition simply scans it again.
+    bool perform_equal_partition = false;
+    if (left_ancestor_pivot != nullptr)
+      perform_equal_partition = !comp(left_ancestor_pivot, pivot_copy);
+
+    size_t left_partition_len = 0;
+    if (!perform_equal_partition) {
+      left_partition_len =
+          partition_scan<false>(first, step, length, dst, pivot_copy, comp);
+      perform_equal_partition = left_partition_len == 0;
+    }
+
+    if (perform_equal_partition) {
+      size_t mid_eq =
+          partition_scan<true>(first, step, length, dst, pivot_copy, comp);
+      if (!in_scratch)
+        dst.copy_nonoverlapping(v, mid_eq);
+      comp.progress(length);
+      v = v.offset(mid_eq);
+      scratch = scratch.offset(mid_eq);
+      length -= mid_eq;
+      in_scratch = !in_scratch;
+      reversed = true;
+      left_ancestor_pivot = nullptr;
+      continue;
+    }
+
+    comp.progress(length);
+    ping_pong_quicksort(v.offset(left_partition_len),
+                        scratch.offset(left_partition_len),
+                        length - left_partition_len, !in_scratch, true, limit,
+                        pivot_copy, small_scratch, comp);
+    length = left_partition_len;
+    in_scratch = !in_scratch;
+    reversed = false;
+  }
+}
+
 } // namespace quick
 } // namespace DRIFTSORT_HIDDEN driftsort
@@ -0,0 +1,335 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/drift.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/pivot.h"
+#include "driftsort/quicksort.h"
+#include "driftsort/smallsort.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+namespace partial {
+// Partitioning may touch at most this many times the input length before
+// selection falls back to the O(n log k) streaming algorithm.
+inline constexpr size_t PARTITION_BUDGET_FACTOR = 4;
+
+/// Scratch space needed by `streaming_partial_sort` and `flush` for `k`
+/// elements of `element_size` bytes.
+inline size_t streaming_scratch_length(size_t k, size_t element_size) {
+  return std::max(k, quick::smallsort_threshold(element_size)) + 16;
+}
+
+/// Stably sorts `v[..length]`, with scratch of `length + 16` elements or more.
+template <typename Comp>
+inline void sort_run(void *raw_v, size_t length, void *raw_scratch,
+                     size_t scratch_length, const BlobComparator<Comp> &comp) {
+  if (length <= quick::smallsort_threshold(comp.size()))
+    small::small_sort_general(raw_v, length, raw_scratch, comp);
+  else
+    drift::sort<true>(raw_v, length, raw_scratch, scratch_length, comp);
+}
+
+/// Sorts the candidates `cand[..cand_length]` and merges them into the sorted
+/// `best[..k]`, keeping the `k` smallest in `best` and moving the rest into
+/// `cand`. Ties go to `best`, so all candidates must come after every element
+/// of `best` in the input for the result to be stable.
+///
+/// Requires `0 < cand_length <= k` and `streaming_scratch_length(k)` elements
+/// of scratch.
+template <typename Comp>
+inline void flush(void *raw_best, size_t k, void *raw_cand, size_t cand_length,
+                  void *raw_scratch, size_t scratch_length,
+                  const BlobComparator<Comp> &comp) {
+  BlobPtr best = comp.lift(raw_best);
+  BlobPtr cand = comp.lift(raw_cand);
+  BlobPtr scratch = comp.lift(raw_scratch);
+  sort_run(cand, cand_length, scratch, scratch_length, comp);
+
+  // Merge until `k` elements are out. `best` cannot run dry before that.
+  BlobPtr left = best;
+  BlobPtr right = cand;
+  BlobPtr right_end = cand.offset(cand_length);
+  BlobPtr out = scratch;
+  BlobPtr out_end = scratch.offset(k);
+  while (out != out_end && right != right_end) {
+    bool consume_left = !comp(right, left);
+    BlobPtr src = consume_left ? left : right;
+    src.copy_nonoverlapping(out);
+    left = left.offset(consume_left);
+    right = right.offset(!consume_left);
+    out = out.offset(1);
+  }
+  size_t fill = static_cast<size_t>(out_end - out);
+  left.copy_nonoverlapping(out, fill);
+  left = left.offset(static_cast<ptrdiff_t>(fill));
+
+  // The consumed candidates leave exactly enough room for the rejected part
+  // of `best`.
+  left.copy_nonoverlapping(cand, static_cast<size_t>(best.offset(k) - left));
+  scratch.copy_nonoverlapping(best, k);
+}
+
+/// Reorders `v` so that `v[..k]` holds its `k` smallest elements in stable
+/// sorted order, in O(n log k) time.
+///
+/// `v[..k]` is kept sorted while the rest of `v` is scanned. Elements that
+/// are less than the current k-th smallest are collected behind it and merged
+/// in once `k` of them have gathered, so the threshold only ever tightens and
+/// most elements of random input cost a single comparison.
+///
+/// Requires `0 < k < length` and `streaming_scratch_length(k)` elements of
+/// scratch.
+template <typename Comp>
+inline void streaming_partial_sort(void *raw_v, size_t length, size_t k,
+                                   void *raw_scratch, size_t scratch_length,
+                                   const BlobComparator<Comp> &comp) {
+  BlobPtr v = comp.lift(raw_v);
+  BlobPtr cand = v.offset(k);
+  auto tmp_space = DRIFTSORT_ALLOCA(comp, 1);
+  BlobPtr tmp = comp.lift_alloca(tmp_space);
+  sort_run(v, k, raw_scratch, scratch_length, comp);
+
+  size_t cand_length = 0;
+  for (size_t i = k; i < length; i++) {
+    BlobPtr x = v.offset(i);
+    if (!comp(x, v.offset(k - 1)))
+      continue;
+    // Candidates stay in input order; skipped elements move behind them.
+    BlobPtr slot = cand.offset(cand_length);
+    if (slot != x) {
+      x.copy_nonoverlapping(tmp);
+      slot.copy_nonoverlapping(x);
+      tmp.copy_nonoverlapping(slot);
+    }
+    if (++cand_length == k) {
+      flush(v, k, cand, cand_length, raw_scratch, scratch_length, comp);
+      cand_length = 0;
+    }
+  }
+  if (cand_length != 0)
+    flush(v, k, cand, cand_length, raw_scratch, scratch_length, comp);
+}
+
+/// Makes the first `count` elements of `v` final, by quickselect with the
+/// pivot selection and stable partitions of `stable_quicksort`.
+///
+/// If `sort_prefix` is true `v[..count]` ends up stably sorted, as for a
+/// partial sort. Otherwise only `v[count - 1]` is guaranteed to be the element
+/// a stable sort would put there, with no greater element before and no
+/// smaller one after it.
+///
+/// Only the partition containing position `count - 1` is partitioned further.
+/// Once the partitioning work exceeds `PARTITION_BUDGET_FACTOR * length`
+/// the remaining range is finished by `streaming_partial_sort`, which bounds
+/// the worst case by O(n log k).
+///
+/// Requires `0 < count <= length` and `length + 16` elements of scratch.
+template <bool sort_prefix, typename Comp>
+inline void select_prefix(void *raw_v, size_t length, size_t count,
+                          void *raw_scratch, size_t scratch_length,
+                          const BlobComparator<Comp> &comp) {
+  BlobPtr v = comp.lift(raw_v);
+  BlobPtr scratch = comp.lift(raw_scratch);
+  size_t budget = PARTITION_BUDGET_FACTOR * length;
+
+  // A pivot must outlive the iteration that chose it while it serves as the
+  // left ancestor, so two copies take turns.
+  auto pivot_copy_space = DRIFTSORT_ALLOCA(comp, 2);
+  BlobPtr pivot_copies[2] = {comp.lift_alloca(pivot_copy_space),
+                             comp.lift_alloca(pivot_copy_space).offset(1)};
+  size_t current = 0;
+  void *left_ancestor_pivot = nullptr;
+
+  size_t small_length = quick::smallsort_threshold(comp.size());
+
+  for (;;) {
+    if (length <= small_length) {
+      small::small_sort_general(v, length, scratch, comp);
+      return;
+    }
+
+    if (sort_prefix && count == length) {
+      size_t limit = std::bit_width(2 * (length | 1));
+      quick::stable_quicksort(v, length, scratch, scratch_length, limit,
+                              left_ancestor_pivot, comp);
+      return;
+    }
+
+    if (budget < length) {
+      if (count < length &&
+          scratch_length >= streaming_scratch_length(count, comp.size()))
+        streaming_partial_sort(v, length, count, scratch, scratch_length,
+                               comp);
+      else
+        drift::sort<true>(v, length, scratch, scratch_length, comp);
+      return;
+    }
+    budget -= length;
+
+    size_t pivot_pos = pivot::choose_pivot(v, length, comp);
+    DRIFTSORT_ASSUME(pivot_pos < length);
+    BlobPtr pivot_copy = pivot_copies[current];
+    v.offset(pivot_pos).copy_nonoverlapping(pivot_copy);
+
+    // Same equal-element handling as in `quick::stable_quicksort`.
+    bool perform_equal_partition = false;
+    if (left_ancestor_pivot != nullptr)
+      perform_equal_partition = !comp(left_ancestor_pivot, v.offset(pivot_pos));
+
+    size_t left_partition_len = 0;
+    if (!perform_equal_partition) {
+      left_partition_len =
+          quick::stable_partition<false>(v, length, scratch, pivot_pos, comp);
+      perform_equal_partition = left_partition_len == 0;
+    }
+
+    if (perform_equal_partition) {
+      // The left side holds the elements equal to the pivot in input order,
+      // which is already their sorted order.
+      size_t mid_eq =
+          quick::stable_partition<true>(v, length, scratch, pivot_pos, comp);
+      if (count <= mid_eq)
+        return;
+      v = v.offset(mid_eq);
+      length -= mid_eq;
+      count -= mid_eq;
+      left_ancestor_pivot = nullptr;
+      continue;
+    }
+
+    if (count <= left_partition_len) {
+      length = left_partition_len;
+      continue;
+    }
+
+    if constexpr (sort_prefix) {
+      size_t limit = std::bit_width(2 * (left_partition_len | 1));
+      quick::stable_quicksort(v, left_partition_len, scratch, scratch_length,
+                              limit, left_ancestor_pivot, comp);
+    }
+    v = v.offset(left_partition_len);
+    length -= left_partition_len;
+    count -= left_partition_len;
+    left_ancestor_pivot = pivot_copy;
+    current ^= 1;
+  }
+}
+
+template <bool sort_prefix, typename Comp>
+inline void select(void *data, size_t length, size_t element_size,
+                   size_t count, Comp compare) {
+  if (element_size == 0 || length < 2 || count == 0)
+    return;
+  size_t alignment = guess_alignment(element_size, data);
+  BlobComparator<Comp> comp{element_size, alignment, compare};
+  BlobPtr v = comp.lift(data);
+  if (length <= max_len_always_insertion_sort(element_size))
+    return small::insertion_sort_shift_left(v, length, 1, comp);
+  if (DRIFTSORT_UNLIKELY(alignment > MAX_ALIGNMENT))
+    return trivial_heap_sort(data, length, comp);
+
+  size_t alloc_length =
+      std::max(length, quick::smallsort_threshold(element_size)) + 16;
+  bool allocated = with_scratch(alloc_length, comp, [&](BlobPtr scratch) {
+    select_prefix<sort_prefix>(v, length, count, scratch, alloc_length, comp);
+  });
+  if (DRIFTSORT_UNLIKELY(!allocated))
+    trivial_heap_sort(data, length, comp);
+}
+} // namespace partial
+
+/// Reorders `data` so that `data[k]` is the element a stable sort would put
+/// there, with no greater element before it and no smaller one after it.
+template <typename Comp>
+inline void nth_element(void *data, size_t length, size_t element_size,
+                        size_t k, Comp compare) {
+  if (k < length)
+    partial::select<false>(data, length, element_size, k + 1, compare);
+}
+
+/// Reorders `data` so that `data[..k]` holds its `k` smallest elements in
+/// stable sorted order. The order of the remaining elements is unspecified.
+template <typename Comp>
+inline void partial_sort(void *data, size_t length, size_t element_size,
+                         size_t k, Comp compare) {
+  partial::select<true>(data, length, element_size, std::min(k, length),
+                        compare);
+}
+
+/// Copies the `k` smallest elements of `data` to `dest[..k]` in stable sorted
+/// order, without modifying `data`. If `k >= length` all elements are copied
+/// and sorted.
+///
+/// This streams over `data` once with O(k) extra space; see
+/// `partial::streaming_partial_sort`.
+template <typename Comp>
+inline void top_k(const void *data, size_t length, size_t element_size,
+                  size_t k, void *dest, Comp compare) {
+  if (element_size == 0 || k == 0 || length == 0)
+    return;
+  if (k >= length) {
+    std::memcpy(dest, data, length * element_size);
+    return driftsort::qsort_r(dest, length, element_size, compare);
+  }
+
+  size_t alignment = guess_alignment(
+      element_size, reinterpret_cast<void *>(
+                        reinterpret_cast<uintptr_t>(data) |
+                        reinterpret_cast<uintptr_t>(dest)));
+  BlobComparator<Comp> comp{element_size, alignment, compare};
+  // `data` is only ever read.
+  BlobPtr src = comp.lift(const_cast<void *>(data));
+  BlobPtr best = comp.lift(dest);
+  src.copy_nonoverlapping(best, k);
+  // Without scratch, keep `best` sorted by insertion instead.
+  auto insertion_top_k = [&] {
+    if (k > 1)
+      small::insertion_sort_shift_left(best, k, 1, comp);
+    for (size_t i = k; i < length; i++) {
+      if (!comp(src.offset(i), best.offset(k - 1)))
+        continue;
+      src.offset(i).copy_nonoverlapping(best.offset(k - 1));
+      if (k > 1)
+        small::insert_tail(best, best.offset(k - 1), comp);
+    }
+  };
+  if (DRIFTSORT_UNLIKELY(alignment > MAX_ALIGNMENT))
+    return insertion_top_k();
+
+  // Candidates are gathered in front of the scratch used by `flush`.
+  size_t flush_length = partial::streaming_scratch_length(k, element_size);
+  size_t alloc_length = k + flush_length;
+  bool allocated = with_scratch(alloc_length, comp, [&](BlobPtr scratch) {
+    BlobPtr cand = scratch;
+    BlobPtr flush_scratch = scratch.offset(k);
+    partial::sort_run(best, k, flush_scratch, flush_length, comp);
+    size_t cand_length = 0;
+    for (size_t i = k; i < length; i++) {
+      if (!comp(src.offset(i), best.offset(k - 1)))
+        continue;
+      src.offset(i).copy_nonoverlapping(cand.offset(cand_length));
+      if (++cand_length == k) {
+        partial::flush(best, k, cand, cand_length, flush_scratch, flush_length,
+                       comp);
+        cand_length = 0;
+      }
+    }
+    if (cand_length != 0)
+      partial::flush(best, k, cand, cand_length, flush_scratch, flush_length,
+                     comp);
+  });
+  if (DRIFTSORT_UNLIKELY(!allocated))
+    insertion_top_k();
+}
+} // namespace DRIFTSORT_HIDDEN driftsort
@@ -0,0 +1,238 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/merge.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+/// The elements `a[a_start..a_end]` and `b[b_start..b_end]` of two sorted
+/// arrays, which all equal each other, see `merge_join`.
+struct JoinRange {
+  size_t a_start;
+  size_t a_end;
+  size_t b_start;
+  size_t b_end;
+};
+
+namespace setops {
+/// Steps of the branchless loop between two looks at whether one side has
+/// contributed all of them, after which `combine` gallops through it.
+inline constexpr size_t GALLOP_AFTER = merge::MIN_GALLOP;
+
+/// Returns a negative number, zero or a positive one as `a` is less than,
+/// equal to or greater than `b`. Costs one comparison with a `ThreeWay`
+/// comparator and two otherwise.
+template <typename Comp>
+inline int order(BlobPtr a, BlobPtr b, const BlobComparator<Comp> &comp) {
+  if constexpr (BlobComparator<Comp>::THREE_WAY)
+    return comp.compare_three_way(a, b);
+  else
+    return static_cast<int>(comp(b, a)) - static_cast<int>(comp(a, b));
+}
+
+/// Merges the sorted `a[..a_length]` and `b[..b_length]` like `std::merge`,
+/// but writes to `dest` only the elements that are less than the head of
+/// the other array if `ONLY_A` or `ONLY_B`, for elements of `a` and `b`
+/// respectively, and those of `a` equal to the head of `b` if `BOTH`. Equal
+/// elements are paired up in order, and each pair advances both arrays.
+/// This matches `std::set_union` and its siblings, and returns the number of
+/// elements written.
+///
+/// Each step copies the head it would keep to `dest` and then advances the
+/// output and the inputs by the result of the comparison, without branches.
+/// Every `GALLOP_AFTER` steps, if one array has not moved, the other has
+/// a stretch of elements less than its head, which is found by galloping
+/// and copied or skipped at once. `dest` must not overlap the inputs and
+/// must hold as many elements as the operation could write at most.
+template <bool ONLY_A, bool ONLY_B, bool BOTH, typename Comp>
+inline size_t combine(BlobPtr a, size_t a_length, BlobPtr b, size_t b_length,
+                      BlobPtr dest, const BlobComparator<Comp> &comp) {
+  BlobPtr a_end = a.offset(a_length);
+  BlobPtr b_end = b.offset(b_length);
+  BlobPtr out = dest;
+  while (a != a_end && b != b_end) {
+    size_t steps = std::min<size_t>(
+        {GALLOP_AFTER, static_cast<size_t>(a_end - a),
+         static_cast<size_t>(b_end - b)});
+    BlobPtr a_before = a;
+    BlobPtr b_before = b;
+    for (size_t i = 0; i < steps; i++) {
+      int ordering = order(a, b, comp);
+      bool less = ordering < 0;
+      bool greater = ordering > 0;
+      BlobPtr src = greater ? b : a;
+      src.copy_nonoverlapping(out);
+      bool keep =
+          (less & ONLY_A) | (greater & ONLY_B) | (!less & !greater & BOTH);
+      out = out.offset(keep);
+      a = a.offset(!greater);
+      b = b.offset(!less);
+    }
+    if (b == b_before) {
+      size_t run = merge::gallop(a, 1, a_end - a,
+                                 [&](BlobPtr x) { return comp(x, b); });
+      if constexpr (ONLY_A) {
+        a.copy_nonoverlapping(out, run);
+        out = out.offset(run);
+      }
+      a = a.offset(run);
+    } else if (a == a_before) {
+      size_t run = merge::gallop(b, 1, b_end - b,
+                                 [&](BlobPtr x) { return comp(x, a); });
+      if constexpr (ONLY_B) {
+        b.copy_nonoverlapping(out, run);
+        out = out.offset(run);
+      }
+      b = b.offset(run);
+    }
+  }
+  // Empty inputs may be null, which `memcpy` does not take.
+  if (ONLY_A && a != a_end) {
+    a.copy_nonoverlapping(out, a_end - a);
+    out = out.offset(a_end - a);
+  }
+  if (ONLY_B && b != b_end) {
+    b.copy_nonoverlapping(out, b_end - b);
+    out = out.offset(b_end - b);
+  }
+  return out - dest;
+}
+
+template <bool ONLY_A, bool ONLY_B, bool BOTH, typename Comp>
+inline size_t combine(const void *a, size_t a_length, const void *b,
+                      size_t b_length, size_t element_size, void *dest,
+                      Comp compare) {
+  if (element_size == 0)
+    return 0;
+  uintptr_t addresses = reinterpret_cast<uintptr_t>(a) |
+                        reinterpret_cast<uintptr_t>(b) |
+                        reinterpret_cast<uintptr_t>(dest);
+  BlobComparator<Comp> comp{
+      element_size,
+      guess_alignment(element_size, reinterpret_cast<void *>(addresses)),
+      compare};
+  return combine<ONLY_A, ONLY_B, BOTH>(comp.lift(const_cast<void *>(a)),
+                                       a_length,
+                                       comp.lift(const_cast<void *>(b)),
+                                       b_length, comp.lift(dest), comp);
+}
+} // namespace setops
+
+/// Writes the union of the sorted `a[..a_length]` and `b[..b_length]` to
+/// `dest` in sorted order and returns its length, at most `a_length +
+/// b_length`. Like `std::set_union`, an element found m times in `a` and n
+/// times in `b` is written m times from `a` and then max(n - m, 0) times
+/// from `b`, in their order. `dest` must not overlap the inputs.
+template <typename Comp>
+inline size_t set_union(const void *a, size_t a_length, const void *b,
+                        size_t b_length, size_t element_size, void *dest,
+                        Comp compare) {
+  return setops::combine<true, true, true>(a, a_length, b, b_length,
+                                           element_size, dest, compare);
+}
+
+/// Like `set_union`, but writes min(m, n) elements from `a`, at most
+/// `min(a_length, b_length)` in total.
+template <typename Comp>
+inline size_t set_intersection(const void *a, size_t a_length, const void *b,
+                               size_t b_length, size_t element_size,
+                               void *dest, Comp compare) {
+  return setops::combine<false, false, true>(a, a_length, b, b_length,
+                                             element_size, dest, compare);
+}
+
+/// Like `set_union`, but writes the last max(m - n, 0) elements from `a`, at
+/// most `a_length` in total.
+template <typename Comp>
+inline size_t set_difference(const void *a, size_t a_length, const void *b,
+                             size_t b_length, size_t element_size, void *dest,
+                             Comp compare) {
+  return setops::combine<true, false, false>(a, a_length, b, b_length,
+                                             element_size, dest, compare);
+}
+
+/// Like `set_union`, but writes the last |m - n| elements from the array
+/// that has more of them, at most `a_length + b_length` in total.
+template <typename Comp>
+inline size_t set_symmetric_difference(const void *a, size_t a_length,
+                                       const void *b, size_t b_length,
+                                       size_t element_size, void *dest,
+                                       Comp compare) {
+  return setops::combine<true, true, false>(a, a_length, b, b_length,
+                                            element_size, dest, compare);
+}
+
+/// Finds the elements the sorted `a[..a_length]` and `b[..b_length]` have
+/// in common, and writes one `JoinRange` to `dest` for each group of equal
+/// ones, in sorted order, holding all elements of the group in each array.
+/// Returns the number of ranges, at most `min(a_length, b_length)`.
+///
+/// Unequal elements are skipped by the same steps as in `set_intersection`,
+/// with galloping through long stretches of one array, and the groups are
+/// galloped through as well.
+template <typename Comp>
+inline size_t merge_join(const void *a, size_t a_length, const void *b,
+                         size_t b_length, size_t element_size, JoinRange *dest,
+                         Comp compare) {
+  if (element_size == 0)
+    return 0;
+  uintptr_t addresses =
+      reinterpret_cast<uintptr_t>(a) | reinterpret_cast<uintptr_t>(b);
+  BlobComparator<Comp> comp{
+      element_size,
+      guess_alignment(element_size, reinterpret_cast<void *>(addresses)),
+      compare};
+  BlobPtr x = comp.lift(const_cast<void *>(a));
+  BlobPtr y = comp.lift(const_cast<void *>(b));
+  BlobPtr a_end = x.offset(a_length);
+  BlobPtr b_end = y.offset(b_length);
+  size_t count = 0;
+  while (x != a_end && y != b_end) {
+    // Skips unequal heads like `setops::combine` until two are equal.
+    size_t steps = std::min<size_t>({setops::GALLOP_AFTER,
+                                     static_cast<size_t>(a_end - x),
+                                     static_cast<size_t>(b_end - y)});
+    BlobPtr a_before = x;
+    BlobPtr b_before = y;
+    bool found = false;
+    for (size_t i = 0; i < steps; i++) {
+      int ordering = setops::order(x, y, comp);
+      if (ordering == 0) {
+        found = true;
+        break;
+      }
+      x = x.offset(ordering < 0);
+      y = y.offset(ordering > 0);
+    }
+    if (found) {
+      // Both groups start with a known equal element.
+      auto equal = [&](BlobPtr e) { return !comp(x, e); };
+      size_t a_group = 1 + merge::gallop(x.offset(1), 1, a_end - x - 1, equal);
+      size_t b_group = 1 + merge::gallop(y.offset(1), 1, b_end - y - 1, equal);
+      size_t a_start = x - comp.lift(const_cast<void *>(a));
+      size_t b_start = y - comp.lift(const_cast<void *>(b));
+      dest[count++] = {a_start, a_start + a_group, b_start,
+                       b_start + b_group};
+      x = x.offset(a_group);
+      y = y.offset(b_group);
+    } else if (y == b_before) {
+      x = x.offset(merge::gallop(x, 1, a_end - x,
+                                 [&](BlobPtr e) { return comp(e, y); }));
+    } else if (x == a_before) {
+      y = y.offset(merge::gallop(y, 1, b_end - y,
+                                 [&](BlobPtr e) { return comp(e, x); }));
+    }
+  }
+  return count;
+}
+} // namespace DRIFTSORT_HIDDEN driftsort
@@ -8,6 +8,8 @@
 
 #include "driftsort/blob.h"
 #include "driftsort/common.h"
+#include <cstdint>
+#include <cstring>
 #include <initializer_list>
 
 namespace DRIFTSORT_HIDDEN driftsort {
@@ -125,10 +127,42 @@ inline void sort8_stable(void *raw_base, void *raw_dest, void *raw_scratch,
   bidirectional_merge(scratch, 8, dest, comp);
 }
 
+/// Sorts range [begin, tail] assuming [begin, tail) is already sorted, by
+/// binary searching for the place of `tail`, with about log2(tail - begin)
+/// comparisons instead of up to tail - begin.
+template <typename Comp>
+inline void binary_insert_tail(void *raw_begin, void *raw_tail,
+                               const BlobComparator<Comp> &comp) {
+  BlobPtr begin = comp.lift(raw_begin);
+  BlobPtr tail = comp.lift(raw_tail);
+  // after all elements not greater than `tail`, which keeps it stable
+  size_t lo = 0;
+  size_t hi = static_cast<size_t>(tail - begin);
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (comp(tail, begin.offset(mid)))
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  BlobPtr hole = begin.offset(lo);
+  if (hole == tail)
+    return;
+  auto tmp_space = DRIFTSORT_ALLOCA(comp, 1);
+  BlobPtr tmp = comp.lift_alloca(tmp_space);
+  tail.copy_nonoverlapping(tmp);
+  std::memmove(hole.offset(1), hole, (tail - hole) * comp.size());
+  tmp.copy_nonoverlapping(hole);
+}
+
 /// Sorts range [begin, tail] assuming [begin, tail) is already sorted.
 template <typename Comp>
 inline void insert_tail(void *raw_begin, void *raw_tail,
                         const BlobComparator<Comp> &comp) {
+  if constexpr (BlobComparator<Comp>::FEWEST_COMPARES) {
+    binary_insert_tail(raw_begin, raw_tail, comp);
+    return;
+  }
   class CopyOnDrop {
     BlobPtr src;
     BlobPtr dest;
@@ -181,6 +215,96 @@ inline void insertion_sort_shift_left(void *raw_begin, size_t total,
   }
 }
 
+/// The longest input `merge_insertion_sort` sorts, the largest small-sort
+/// threshold a tuning policy may choose.
+inline constexpr size_t MAX_MERGE_INSERTION = 128;
+
+/// Sorts the element indices `ids[..length]` by merge insertion (Ford and
+/// Johnson), which uses the fewest comparisons known for small inputs:
+/// it sorts the larger elements of pairs recursively and then binary
+/// inserts the smaller ones in an order that keeps every search within a
+/// power of two minus one elements. `before` is a strict total order.
+template <typename Before>
+inline void merge_insertion(uint8_t *ids, size_t length, Before &before) {
+  if (length < 2)
+    return;
+  size_t pairs = length / 2;
+  uint8_t larger[MAX_MERGE_INSERTION / 2];
+  uint8_t partner[MAX_MERGE_INSERTION];
+  for (size_t k = 0; k < pairs; k++) {
+    uint8_t a = ids[2 * k];
+    uint8_t b = ids[2 * k + 1];
+    bool swap = before(b, a);
+    larger[k] = swap ? a : b;
+    partner[larger[k]] = swap ? b : a;
+  }
+  merge_insertion(larger, pairs, before);
+
+  // the chain starts with the smallest element, which goes first unsearched
+  uint8_t chain[MAX_MERGE_INSERTION];
+  size_t chain_length = 0;
+  chain[chain_length++] = partner[larger[0]];
+  for (size_t k = 0; k < pairs; k++)
+    chain[chain_length++] = larger[k];
+
+  // Inserts the pending elements 2..=last (1-based, the odd one out being
+  // last) in groups ending at the Jacobsthal numbers 3, 5, 11, 21, ...,
+  // each group from its end down.
+  size_t last = pairs + length % 2;
+  auto insert = [&](size_t i) {
+    uint8_t id = i <= pairs ? partner[larger[i - 1]] : ids[length - 1];
+    size_t hi = chain_length;
+    if (i <= pairs)
+      for (hi = 0; chain[hi] != larger[i - 1]; hi++)
+        ;
+    size_t lo = 0;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (before(id, chain[mid]))
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    std::memmove(&chain[lo + 1], &chain[lo], chain_length - lo);
+    chain[lo] = id;
+    chain_length++;
+  };
+  for (size_t done = 1, prev = 1, next = 3; done < last;) {
+    size_t end = next < last ? next : last;
+    for (size_t i = end; i > done; i--)
+      insert(i);
+    done = end;
+    size_t following = next + 2 * prev;
+    prev = next;
+    next = following;
+  }
+  std::memcpy(ids, chain, length);
+}
+
+/// Sorts `base[..length]` stably with `merge_insertion`, for comparators
+/// expensive enough that comparisons are all that counts. The scratch pad
+/// is of `length` in size.
+template <typename Comp>
+inline void merge_insertion_sort(void *raw_base, size_t length,
+                                 void *raw_scratch,
+                                 const BlobComparator<Comp> &comp) {
+  DRIFTSORT_ASSUME(length <= MAX_MERGE_INSERTION);
+  BlobPtr base = comp.lift(raw_base);
+  BlobPtr scratch = comp.lift(raw_scratch);
+  uint8_t ids[MAX_MERGE_INSERTION];
+  for (size_t i = 0; i < length; i++)
+    ids[i] = static_cast<uint8_t>(i);
+  // breaking ties by position makes the order total and the sort stable
+  auto before = [&](uint8_t i, uint8_t j) {
+    return i < j ? !comp(base.offset(j), base.offset(i))
+                 : comp(base.offset(i), base.offset(j));
+  };
+  merge_insertion(ids, length, before);
+  for (size_t i = 0; i < length; i++)
+    base.offset(ids[i]).copy_nonoverlapping(scratch.offset(i));
+  scratch.copy_nonoverlapping(base, length);
+}
+
 // scratch pad is of (16 + length) in size
 template <typename Comp>
 inline void small_sort_general(void *raw_base, size_t length, void *raw_scratch,
@@ -190,6 +314,13 @@ inline void small_sort_general(void *raw_base, size_t length, void *raw_scratch,
   if (length < 2)
     return;
 
+  if constexpr (BlobComparator<Comp>::FEWEST_COMPARES) {
+    if (length <= MAX_MERGE_INSERTION) {
+      merge_insertion_sort(base, length, scratch, comp);
+      return;
+    }
+  }
+
   size_t half = length / 2;
 
   size_t presorted_length;
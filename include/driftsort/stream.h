@@ -0,0 +1,176 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/drift.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/merge.h"
+#include "driftsort/smallsort.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+
+/// Sorts elements that arrive in chunks, overlapping the sorting work with
+/// their arrival.
+///
+/// Every pushed chunk is sorted into a run and then merged with earlier runs
+/// by the powersort rule of `drift::sort`. The final length is unknown, so
+/// merge depths are computed on the unscaled number line (a scale factor of
+/// one), which yields the same balanced merge tree up to a constant shift in
+/// depth. At any time the buffer holds a stack of sorted runs whose lengths
+/// shrink geometrically, so no push ever redoes much earlier work and
+/// `finish` only has O(log n) runs left to merge.
+///
+/// The result is stable: equal elements keep the order in which they were
+/// pushed.
+template <typename Comp> class StreamSorter {
+  BlobComparator<Comp> comp;
+  std::byte *buffer = nullptr;
+  std::byte *raw_scratch = nullptr;
+  size_t capacity = 0;
+  size_t scratch_length = 0;
+  size_t length = 0;
+
+  // The run stack of `drift::sort`. Merge depths are strictly increasing
+  // above the initial empty run, so 66 entries always suffice.
+  size_t stack_length = 0;
+  size_t run_storage[66];
+  uint8_t depth_storage[66];
+  size_t prev_run_length = 0;
+
+  BlobPtr at(size_t index) const {
+    return BlobPtr{comp.size(), buffer}.offset(index);
+  }
+  BlobPtr scratch() const { return BlobPtr{comp.size(), raw_scratch}; }
+
+  /// Grows the buffer to hold `needed` elements. Returns false and leaves
+  /// the sorter unchanged if memory runs out.
+  bool reserve(size_t needed) {
+    if (needed <= capacity)
+      return true;
+    size_t new_capacity = std::max({needed, 2 * capacity, size_t{64}});
+    // Merges need scratch for the shorter run and chunks are sorted like
+    // `driftsort` does with half-length scratch.
+    size_t new_scratch_length =
+        new_capacity / 2 + quick::smallsort_threshold(comp.size()) + 16;
+    std::align_val_t align{comp.align()};
+    void *new_buffer =
+        ::operator new(new_capacity * comp.size(), align, std::nothrow);
+    if (DRIFTSORT_UNLIKELY(new_buffer == nullptr))
+      return false;
+    void *new_scratch =
+        ::operator new(new_scratch_length * comp.size(), align, std::nothrow);
+    if (DRIFTSORT_UNLIKELY(new_scratch == nullptr)) {
+      ::operator delete(new_buffer, align);
+      return false;
+    }
+    if (length != 0)
+      std::memcpy(new_buffer, buffer, length * comp.size());
+    release();
+    buffer = static_cast<std::byte *>(new_buffer);
+    raw_scratch = static_cast<std::byte *>(new_scratch);
+    capacity = new_capacity;
+    scratch_length = new_scratch_length;
+    return true;
+  }
+
+  void release() {
+    std::align_val_t align{comp.align()};
+    if (buffer != nullptr)
+      ::operator delete(buffer, align);
+    if (raw_scratch != nullptr)
+      ::operator delete(raw_scratch, align);
+  }
+
+  void sort_run(BlobPtr v, size_t run_length) {
+    if (run_length < 2)
+      return;
+    if (run_length <= max_len_always_insertion_sort(comp.size()))
+      small::insertion_sort_shift_left(v, run_length, 1, comp);
+    else if (run_length <= quick::smallsort_threshold(comp.size()) * 2)
+      drift::sort<true>(v, run_length, scratch(), scratch_length, comp);
+    else
+      drift::sort<false>(v, run_length, scratch(), scratch_length, comp);
+  }
+
+  /// Merges the top of the stack into `prev_run_length`.
+  void merge_top() {
+    size_t left = run_storage[--stack_length];
+    size_t merge_length = left + prev_run_length;
+    merge::merge(at(length - merge_length), merge_length, scratch(),
+                 scratch_length, left, comp);
+    prev_run_length = merge_length;
+  }
+
+public:
+  /// Creates an empty sorter for elements of `element_size` bytes. The
+  /// buffer is aligned to the largest power of two dividing `element_size`,
+  /// up to `MAX_ALIGNMENT`. Like `LazySorter`, a sorter for elements of no
+  /// bytes stays empty.
+  StreamSorter(size_t element_size, Comp compare)
+      : comp(element_size,
+             guess_alignment(element_size,
+                             reinterpret_cast<void *>(MAX_ALIGNMENT)),
+             compare) {}
+
+  StreamSorter(const StreamSorter &) = delete;
+  StreamSorter &operator=(const StreamSorter &) = delete;
+
+  ~StreamSorter() { release(); }
+
+  /// Appends `count` elements and sorts them into the run stack. Returns
+  /// false without appending anything if memory runs out.
+  bool push(const void *chunk, size_t count) {
+    if (count == 0 || comp.size() == 0)
+      return true;
+    if (DRIFTSORT_UNLIKELY(!reserve(length + count)))
+      return false;
+    std::memcpy(at(length), chunk, count * comp.size());
+    sort_run(at(length), count);
+
+    uint8_t desired_depth =
+        drift::merge_tree_depth(length - prev_run_length, length,
+                                length + count, 1);
+    while (stack_length > 1 &&
+           depth_storage[stack_length - 1] >= desired_depth)
+      merge_top();
+    run_storage[stack_length] = prev_run_length;
+    depth_storage[stack_length] = desired_depth;
+    stack_length++;
+    length += count;
+    prev_run_length = count;
+    return true;
+  }
+
+  /// Merges all runs, so that `data()[..size()]` is sorted, and returns
+  /// `data()`. More elements may be pushed afterwards.
+  void *finish() {
+    while (stack_length > 1)
+      merge_top();
+    return buffer;
+  }
+
+  /// Length of the sorted run at the front of `data()`: the earliest pushed
+  /// elements in sorted order. It grows as later runs are merged into it and
+  /// covers everything after `finish`.
+  size_t sorted_prefix() const {
+    return stack_length > 1 ? run_storage[1] : prev_run_length;
+  }
+
+  /// The elements pushed so far. Only `data()[..sorted_prefix()]` is
+  /// guaranteed to be sorted; the pointer is invalidated by `push`.
+  void *data() const { return buffer; }
+  size_t size() const { return length; }
+};
+
+} // namespace DRIFTSORT_HIDDEN driftsort
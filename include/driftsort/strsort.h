@@ -0,0 +1,211 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/common.h"
+#include "driftsort/driftsort.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+
+/// A string given by pointer and length. Unlike NUL-terminated strings it may
+/// contain zero bytes; bytes are compared as unsigned char, like memcmp.
+struct StringRef {
+  const char *data;
+  size_t length;
+};
+
+namespace strsort {
+// Groups at or below this size are finished with a comparison sort that
+// starts at the known common prefix instead of loading more key bytes.
+inline constexpr size_t LCP_SORT_THRESHOLD = 32;
+
+/// A string together with a few of its key bytes, starting at the current
+/// depth, packed big-endian so that integer order is string order.
+template <typename S> struct Entry {
+  uint64_t cache;
+  S str;
+};
+
+/// Key bytes of NUL-terminated strings.
+///
+/// Eight bytes are cached per level. Bytes after the terminator are zero, so
+/// the string ends within the cached block iff the lowest byte is zero.
+struct CStringKey {
+  static constexpr size_t STEP = 8;
+  static uint64_t load(const char *s, size_t depth) {
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(s) + depth;
+    uint64_t key = 0;
+    for (size_t i = 0; i < STEP; i++) {
+      key |= uint64_t{p[i]} << (56 - 8 * i);
+      if (p[i] == 0)
+        break;
+    }
+    return key;
+  }
+  static bool ends_within(uint64_t cache) { return (cache & 0xff) == 0; }
+  static int compare(const char *a, const char *b, size_t depth) {
+    return std::strcmp(a + depth, b + depth);
+  }
+};
+
+/// Key bytes of strings with explicit length.
+///
+/// Seven bytes are cached per level and the lowest byte holds the number of
+/// remaining bytes clamped to seven. Zero padding sorts below any real byte
+/// except a real zero, and in that case the clamped length orders the shorter
+/// string first. The string ends within the block iff fewer than seven bytes
+/// remained.
+struct StringRefKey {
+  static constexpr size_t STEP = 7;
+  static uint64_t load(StringRef s, size_t depth) {
+    const unsigned char *p =
+        reinterpret_cast<const unsigned char *>(s.data) + depth;
+    size_t remaining = s.length - depth;
+    size_t count = remaining < STEP ? remaining : STEP;
+    uint64_t key = count;
+    for (size_t i = 0; i < count; i++)
+      key |= uint64_t{p[i]} << (56 - 8 * i);
+    return key;
+  }
+  static bool ends_within(uint64_t cache) { return (cache & 0xff) < STEP; }
+  static int compare(StringRef a, StringRef b, size_t depth) {
+    size_t a_len = a.length - depth;
+    size_t b_len = b.length - depth;
+    size_t common = a_len < b_len ? a_len : b_len;
+    if (common != 0) {
+      int res = std::memcmp(a.data + depth, b.data + depth, common);
+      if (res != 0)
+        return res;
+    }
+    return a_len < b_len ? -1 : a_len > b_len;
+  }
+};
+
+/// Sorts `e[..length]` by their strings, all of which share their first
+/// `depth` bytes.
+///
+/// This is a stable most-significant-digit radix sort over a super-alphabet of
+/// cached key blocks: every level loads one block per string into `cache` and
+/// sorts the entries by it with driftsort, so the strings themselves are only
+/// dereferenced once per level. Entries with equal blocks share the next
+/// `Key::STEP` bytes of prefix and only those groups descend, so a common
+/// prefix is never compared again. Small groups are finished by comparing
+/// strings from `depth` on.
+///
+/// All groups but the largest recurse, which bounds the recursion depth by
+/// log2(length), and the largest one is handled by the loop.
+template <typename Key, typename S>
+inline void sort_entries(Entry<S> *e, size_t length, size_t depth) {
+  for (;;) {
+    if (length <= LCP_SORT_THRESHOLD) {
+      driftsort::qsort_r(e, length, sizeof(Entry<S>),
+                         [depth](const void *a, const void *b) {
+                           return Key::compare(
+                               static_cast<const Entry<S> *>(a)->str,
+                               static_cast<const Entry<S> *>(b)->str, depth);
+                         });
+      return;
+    }
+
+    // Long shared prefixes make whole levels equal; skip sorting those.
+    bool all_equal = true;
+    e[0].cache = Key::load(e[0].str, depth);
+    for (size_t i = 1; i < length; i++) {
+      e[i].cache = Key::load(e[i].str, depth);
+      all_equal &= e[i].cache == e[0].cache;
+    }
+    if (all_equal) {
+      if (Key::ends_within(e[0].cache))
+        return;
+      depth += Key::STEP;
+      continue;
+    }
+    driftsort::qsort_r(e, length, sizeof(Entry<S>),
+                       [](const void *a, const void *b) {
+                         uint64_t x = static_cast<const Entry<S> *>(a)->cache;
+                         uint64_t y = static_cast<const Entry<S> *>(b)->cache;
+                         return (x > y) - (x < y);
+                       });
+
+    size_t largest_start = 0;
+    size_t largest_length = 0;
+    for (size_t start = 0, end; start < length; start = end) {
+      uint64_t cache = e[start].cache;
+      end = start + 1;
+      while (end < length && e[end].cache == cache)
+        end++;
+      if (end - start < 2 || Key::ends_within(cache))
+        continue;
+      if (end - start > largest_length) {
+        if (largest_length != 0)
+          sort_entries<Key>(e + largest_start, largest_length,
+                            depth + Key::STEP);
+        largest_start = start;
+        largest_length = end - start;
+      } else {
+        sort_entries<Key>(e + start, end - start, depth + Key::STEP);
+      }
+    }
+
+    if (largest_length == 0)
+      return;
+    e += largest_start;
+    length = largest_length;
+    depth += Key::STEP;
+  }
+}
+
+template <typename Key, typename S, typename Fallback>
+inline void sort(S *strings, size_t length, Fallback fallback) {
+  if (length < 2)
+    return;
+  void *raw_entries = ::operator new(length * sizeof(Entry<S>), std::nothrow);
+  if (DRIFTSORT_UNLIKELY(raw_entries == nullptr))
+    return fallback();
+  Entry<S> *entries = static_cast<Entry<S> *>(raw_entries);
+  for (size_t i = 0; i < length; i++)
+    entries[i] = {0, strings[i]};
+  sort_entries<Key>(entries, length, 0);
+  for (size_t i = 0; i < length; i++)
+    strings[i] = entries[i].str;
+  ::operator delete(raw_entries);
+}
+} // namespace strsort
+
+/// Sorts an array of NUL-terminated strings.
+///
+/// The result is identical to a stable sort with `strcmp`: equal strings keep
+/// their relative order.
+inline void sort_strings(const char **strings, size_t length) {
+  strsort::sort<strsort::CStringKey>(strings, length, [&] {
+    driftsort::qsort_r(
+        strings, length, sizeof(const char *),
+        [](const void *a, const void *b) {
+          return std::strcmp(*static_cast<const char *const *>(a),
+                             *static_cast<const char *const *>(b));
+        });
+  });
+}
+
+/// Sorts an array of strings with explicit length, comparing bytes as
+/// unsigned char with shorter prefixes first. The sort is stable.
+inline void sort_strings(StringRef *strings, size_t length) {
+  strsort::sort<strsort::StringRefKey>(strings, length, [&] {
+    driftsort::qsort_r(strings, length, sizeof(StringRef),
+                       [](const void *a, const void *b) {
+                         return strsort::StringRefKey::compare(
+                             *static_cast<const StringRef *>(a),
+                             *static_cast<const StringRef *>(b), 0);
+                       });
+  });
+}
+
+} // namespace DRIFTSORT_HIDDEN driftsort
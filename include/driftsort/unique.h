@@ -0,0 +1,238 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/blob.h"
+#include "driftsort/common.h"
+#include "driftsort/drift.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/pivot.h"
+#include "driftsort/quicksort.h"
+#include "driftsort/smallsort.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+
+namespace DRIFTSORT_HIDDEN driftsort {
+namespace unique {
+/// Receives the sorted pieces of an array from left to right and compacts
+/// every group of equal elements to one element at the front of the array.
+///
+/// Each piece must directly follow the previous one, so the current group
+/// is always contiguous and ends where the next piece begins. A group is
+/// passed to `reduce(void *group, size_t count)` once it is complete, and
+/// then its first element is moved to the output position, which never
+/// passes the start of the group.
+template <typename Comp, typename Reduce> class GroupWriter {
+  const BlobComparator<Comp> &comp;
+  Reduce &reduce;
+  BlobPtr out;
+  BlobPtr group;
+  size_t group_length = 0;
+  size_t groups = 0;
+
+  void close_group() {
+    reduce(group.get(), group_length);
+    if (out != group)
+      group.copy_nonoverlapping(out);
+    out = out.offset(1);
+    groups++;
+  }
+
+public:
+  GroupWriter(BlobPtr v, Reduce &reduce, const BlobComparator<Comp> &comp)
+      : comp(comp), reduce(reduce), out(v), group(v) {}
+
+  /// Appends the sorted `piece[..length]`.
+  void append(BlobPtr piece, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+      BlobPtr element = piece.offset(i);
+      if (group_length != 0 && !comp(element.offset(-1), element)) {
+        group_length++;
+        continue;
+      }
+      if (group_length != 0)
+        close_group();
+      group = element;
+      group_length = 1;
+    }
+  }
+
+  /// Appends `piece[..length]`, whose elements are all equal. This costs a
+  /// single comparison.
+  void append_equal(BlobPtr piece, size_t length) {
+    if (length == 0)
+      return;
+    if (group_length != 0 && !comp(piece.offset(-1), piece)) {
+      group_length += length;
+      return;
+    }
+    if (group_length != 0)
+      close_group();
+    group = piece;
+    group_length = length;
+  }
+
+  /// Closes the last group and returns the number of groups.
+  size_t finish() {
+    if (group_length != 0)
+      close_group();
+    group_length = 0;
+    return groups;
+  }
+};
+
+/// Sorts `v` like `quick::stable_quicksort`, but finishes the left partition
+/// before the right one and hands every sorted piece to `out` right away, so
+/// duplicates are dropped while the piece is still in cache. The elements
+/// equal to a repeated pivot are found by the equal partition and passed on
+/// as a block without being compared with each other again.
+///
+/// Requires `length + 16` elements of scratch.
+template <typename Comp, typename Reduce>
+inline void sort_groups(void *raw_v, size_t length, void *raw_scratch,
+                        size_t scratch_length, size_t limit,
+                        void *left_ancestor_pivot,
+                        GroupWriter<Comp, Reduce> &out,
+                        const BlobComparator<Comp> &comp) {
+  BlobPtr v = comp.lift(raw_v);
+  BlobPtr scratch = comp.lift(raw_scratch);
+
+  // A pivot must outlive the iteration that chose it while it serves as the
+  // left ancestor, so two copies take turns.
+  auto pivot_copy_space = DRIFTSORT_ALLOCA(comp, 2);
+  BlobPtr pivot_copies[2] = {comp.lift_alloca(pivot_copy_space),
+                             comp.lift_alloca(pivot_copy_space).offset(1)};
+  size_t current = 0;
+
+  size_t small_length = quick::smallsort_threshold(comp.size());
+
+  for (;;) {
+    if (length <= small_length) {
+      small::small_sort_general(v, length, scratch, comp);
+      out.append(v, length);
+      return;
+    }
+
+    if (limit == 0) {
+      drift::sort<true>(v, length, scratch, scratch_length, comp);
+      out.append(v, length);
+      return;
+    }
+
+    limit--;
+
+    size_t pivot_pos = pivot::choose_pivot(v, length, comp);
+    DRIFTSORT_ASSUME(pivot_pos < length);
+    BlobPtr pivot_copy = pivot_copies[current];
+    v.offset(pivot_pos).copy_nonoverlapping(pivot_copy);
+
+    // Same equal-element handling as in `quick::stable_quicksort`.
+    bool perform_equal_partition = false;
+    if (left_ancestor_pivot != nullptr)
+      perform_equal_partition = !comp(left_ancestor_pivot, v.offset(pivot_pos));
+
+    size_t left_partition_len = 0;
+    if (!perform_equal_partition) {
+      left_partition_len =
+          quick::stable_partition<false>(v, length, scratch, pivot_pos, comp);
+      perform_equal_partition = left_partition_len == 0;
+    }
+
+    if (perform_equal_partition) {
+      // The left side holds the elements equal to the pivot in input order,
+      // which is already their sorted order.
+      size_t mid_eq =
+          quick::stable_partition<true>(v, length, scratch, pivot_pos, comp);
+      out.append_equal(v, mid_eq);
+      v = v.offset(mid_eq);
+      length -= mid_eq;
+      left_ancestor_pivot = nullptr;
+      continue;
+    }
+
+    sort_groups(v, left_partition_len, scratch, scratch_length, limit,
+                left_ancestor_pivot, out, comp);
+    v = v.offset(left_partition_len);
+    length -= left_partition_len;
+    left_ancestor_pivot = pivot_copy;
+    current ^= 1;
+  }
+}
+
+template <typename Comp, typename Reduce>
+inline size_t sort_and_reduce(void *data, size_t length, size_t element_size,
+                              Reduce &reduce, Comp compare) {
+  if (element_size == 0 || length == 0)
+    return 0;
+  size_t alignment = guess_alignment(element_size, data);
+  BlobComparator<Comp> comp{element_size, alignment, compare};
+  BlobPtr v = comp.lift(data);
+  GroupWriter<Comp, Reduce> out{v, reduce, comp};
+
+  // Already sorted input needs no scratch at all.
+  size_t run_length;
+  bool descending = drift::find_existing_run(v, length, comp, run_length);
+  if (run_length == length && !descending) {
+    out.append(v, length);
+    return out.finish();
+  }
+
+  if (length <= max_len_always_insertion_sort(element_size)) {
+    small::insertion_sort_shift_left(v, length, 1, comp);
+    out.append(v, length);
+    return out.finish();
+  }
+
+  // Over-aligned elements and failed allocations are sorted like `qsort_r`
+  // does, which is not stable, so then any element of a group may be kept.
+  bool allocated = false;
+  if (DRIFTSORT_LIKELY(alignment <= MAX_ALIGNMENT)) {
+    size_t alloc_length =
+        std::max(length, quick::smallsort_threshold(element_size)) + 16;
+    allocated = with_scratch(alloc_length, comp, [&](BlobPtr scratch) {
+      size_t limit = 2 * std::bit_width(length | 1);
+      sort_groups(v, length, scratch, alloc_length, limit, nullptr, out,
+                  comp);
+    });
+  }
+  if (DRIFTSORT_UNLIKELY(!allocated)) {
+    trivial_heap_sort(data, length, comp);
+    out.append(v, length);
+  }
+  return out.finish();
+}
+} // namespace unique
+
+/// Sorts `data` and removes duplicates, keeping the first of every group of
+/// equal elements in input order. Returns the number of distinct elements,
+/// which are then `data[..n]` in sorted order; the rest of `data` is left in
+/// unspecified order.
+///
+/// Duplicates are dropped as soon as a sorted piece of the array is written
+/// out, rather than in a separate pass after sorting, and runs of elements
+/// equal to a repeated pivot collapse without further comparisons.
+template <typename Comp>
+inline size_t sort_unique(void *data, size_t length, size_t element_size,
+                          Comp compare) {
+  auto keep_first = [](void *, size_t) {};
+  return unique::sort_and_reduce(data, length, element_size, keep_first,
+                                 compare);
+}
+
+/// Sorts `data` and calls `reduce(void *group, size_t count)` on every group
+/// of equal elements in sorted order. The group holds its elements in input
+/// order and `reduce` folds them into the first one, which may be modified.
+/// Returns the number of groups, whose reduced elements are then `data[..n]`;
+/// the rest of `data` is left in unspecified order.
+template <typename Comp, typename Reduce>
+inline size_t sort_group(void *data, size_t length, size_t element_size,
+                         Reduce reduce, Comp compare) {
+  return unique::sort_and_reduce(data, length, element_size, reduce, compare);
+}
+
+} // namespace DRIFTSORT_HIDDEN driftsort
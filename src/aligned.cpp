@@ -0,0 +1,20 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/driftsort.h"
+
+extern "C" int driftsort_qsort_aligned_r(void *base, size_t nmemb, size_t size,
+                                         size_t alignment,
+                                         driftsort_compar_fn_t compar,
+                                         void *arg) {
+  bool valid = driftsort::qsort_aligned(
+      base, nmemb, size, alignment,
+      driftsort::three_way([compar, arg](const void *a, const void *b) {
+        return compar(a, b, arg);
+      }));
+  return valid ? 0 : -1;
+}
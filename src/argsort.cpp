@@ -0,0 +1,47 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/argsort.h"
+#include "driftsort/capi.h"
+
+extern "C" size_t driftsort_argsort_index_size(size_t nmemb) {
+  return driftsort::argsort_index_size(nmemb);
+}
+
+extern "C" void driftsort_argsort_r(const void *base, size_t nmemb,
+                                    size_t size, void *perm, void *ranks,
+                                    driftsort_compar_fn_t compar, void *arg) {
+  auto compare = [compar, arg](const void *a, const void *b) {
+    return compar(a, b, arg);
+  };
+  if (driftsort::argsort_index_size(nmemb) == sizeof(uint32_t))
+    driftsort::argsort(base, nmemb, size, static_cast<uint32_t *>(perm),
+                       static_cast<uint32_t *>(ranks), compare);
+  else
+    driftsort::argsort(base, nmemb, size, static_cast<uint64_t *>(perm),
+                       static_cast<uint64_t *>(ranks), compare);
+}
+
+extern "C" int driftsort_argsort_key(const void *base, size_t nmemb,
+                                     size_t size,
+                                     const struct driftsort_key *key,
+                                     void *perm, void *ranks) {
+  if (key->type < DRIFTSORT_KEY_UNSIGNED || key->type > DRIFTSORT_KEY_BYTES)
+    return -1;
+  driftsort::KeySpec spec{key->offset, key->width,
+                          static_cast<driftsort::KeyType>(key->type),
+                          key->descending != 0};
+  bool valid;
+  if (driftsort::argsort_index_size(nmemb) == sizeof(uint32_t))
+    valid = driftsort::argsort_key(base, nmemb, size, spec,
+                                   static_cast<uint32_t *>(perm),
+                                   static_cast<uint32_t *>(ranks));
+  else
+    valid = driftsort::argsort_key(base, nmemb, size, spec,
+                                   static_cast<uint64_t *>(perm),
+                                   static_cast<uint64_t *>(ranks));
+  return valid ? 0 : -1;
+}
@@ -0,0 +1,75 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/async.h"
+#include "driftsort/capi.h"
+#include "ccompare.h"
+#include <chrono>
+#include <future>
+#include <new>
+#include <system_error>
+
+using driftsort::CCompare;
+
+struct DRIFTSORT_HIDDEN driftsort_task {
+  driftsort::SortControl control;
+  std::future<bool> result;
+  int status = 1;
+
+  explicit driftsort_task(std::chrono::steady_clock::time_point deadline)
+      : control(deadline) {}
+};
+
+extern "C" driftsort_task *
+driftsort_sort_async_r(void *base, size_t nmemb, size_t size,
+                       uint64_t timeout_ns, driftsort_compar_fn_t compar,
+                       void *arg) {
+  auto deadline = std::chrono::steady_clock::time_point::max();
+  if (timeout_ns != 0)
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::nanoseconds(timeout_ns);
+  auto task = new (std::nothrow) driftsort_task(deadline);
+  if (task == nullptr)
+    return nullptr;
+  try {
+    task->result =
+        driftsort::sort_async(base, nmemb, size,
+                              driftsort::three_way(CCompare{compar, arg}),
+                              task->control);
+  } catch (const std::system_error &) {
+    delete task;
+    return nullptr;
+  } catch (const std::bad_alloc &) {
+    // `std::async` allocates the shared state of the future.
+    delete task;
+    return nullptr;
+  }
+  return task;
+}
+
+extern "C" void driftsort_task_cancel(driftsort_task *task) {
+  task->control.cancel();
+}
+
+extern "C" int driftsort_task_poll(driftsort_task *task, double *progress) {
+  if (task->status == 1 && task->result.wait_for(std::chrono::seconds(0)) ==
+                               std::future_status::ready)
+    task->status = task->result.get() ? 0 : -1;
+  if (progress != nullptr)
+    *progress = task->control.progress();
+  return task->status;
+}
+
+extern "C" int driftsort_task_wait(driftsort_task *task) {
+  if (task->status == 1)
+    task->status = task->result.get() ? 0 : -1;
+  return task->status;
+}
+
+extern "C" void driftsort_task_free(driftsort_task *task) {
+  driftsort_task_wait(task);
+  delete task;
+}
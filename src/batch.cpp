@@ -0,0 +1,31 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/batch.h"
+#include "driftsort/capi.h"
+#include "ccompare.h"
+
+using driftsort::CCompare;
+
+static_assert(sizeof(driftsort_segment) == sizeof(driftsort::Segment) &&
+              alignof(driftsort_segment) == alignof(driftsort::Segment));
+
+extern "C" void
+driftsort_sort_segments_r(const struct driftsort_segment *segments,
+                          size_t nsegments, size_t size, size_t nthreads,
+                          driftsort_compar_fn_t compar, void *arg) {
+  driftsort::sort_segments(
+      reinterpret_cast<const driftsort::Segment *>(segments), nsegments, size,
+      CCompare{compar, arg}, nthreads);
+}
+
+extern "C" void driftsort_sort_csr_r(void *base, const size_t *offsets,
+                                     size_t nsegments, size_t size,
+                                     size_t nthreads,
+                                     driftsort_compar_fn_t compar, void *arg) {
+  driftsort::sort_csr(base, offsets, nsegments, size, CCompare{compar, arg},
+                      nthreads);
+}
@@ -0,0 +1,61 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/cachedkey.h"
+#include "driftsort/capi.h"
+
+namespace {
+/// Calls `sort(tie_break)` with `compar` as the tie breaker, or with none if
+/// it is null.
+template <typename Sort>
+int with_tie_break(driftsort_compar_fn_t compar, void *arg, Sort sort) {
+  bool sorted =
+      compar == nullptr
+          ? sort(driftsort::cached::NoTieBreak{})
+          : sort([compar, arg](const void *a, const void *b) {
+              return compar(a, b, arg);
+            });
+  return sorted ? 0 : -1;
+}
+} // namespace
+
+extern "C" int driftsort_sort_by_u64_key_r(void *base, size_t nmemb,
+                                           size_t size,
+                                           uint64_t (*key)(const void *,
+                                                           void *),
+                                           driftsort_compar_fn_t compar,
+                                           void *arg) {
+  return with_tie_break(compar, arg, [=](auto tie_break) {
+    return driftsort::sort_by_cached_key(
+        base, nmemb, size, [key, arg](const void *a) { return key(a, arg); },
+        tie_break);
+  });
+}
+
+extern "C" int driftsort_sort_by_double_key_r(void *base, size_t nmemb,
+                                              size_t size,
+                                              double (*key)(const void *,
+                                                            void *),
+                                              driftsort_compar_fn_t compar,
+                                              void *arg) {
+  return with_tie_break(compar, arg, [=](auto tie_break) {
+    return driftsort::sort_by_cached_key(
+        base, nmemb, size, [key, arg](const void *a) { return key(a, arg); },
+        tie_break);
+  });
+}
+
+extern "C" int driftsort_sort_by_bytes_key_r(
+    void *base, size_t nmemb, size_t size, size_t key_size,
+    void (*key)(const void *, void *, void *), driftsort_compar_fn_t compar,
+    void *arg) {
+  return with_tie_break(compar, arg, [=](auto tie_break) {
+    return driftsort::sort_by_cached_key_bytes(
+        base, nmemb, size, key_size,
+        [key, arg](const void *a, void *dest) { key(a, dest, arg); },
+        tie_break);
+  });
+}
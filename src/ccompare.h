@@ -0,0 +1,22 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/capi.h"
+#include "driftsort/common.h"
+
+namespace DRIFTSORT_HIDDEN driftsort {
+/// A C comparator and its argument, for the C API objects that store their
+/// comparator.
+struct CCompare {
+  driftsort_compar_fn_t compar;
+  void *arg;
+  int operator()(const void *a, const void *b) const {
+    return compar(a, b, arg);
+  }
+};
+} // namespace DRIFTSORT_HIDDEN driftsort
@@ -0,0 +1,41 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/columns.h"
+#include "driftsort/capi.h"
+#include "ccompare.h"
+
+using driftsort::CCompare;
+
+static_assert(sizeof(driftsort_column) == sizeof(driftsort::Column) &&
+              alignof(driftsort_column) == alignof(driftsort::Column));
+
+extern "C" int driftsort_sort_columns_r(void *keys, size_t nmemb, size_t size,
+                                        const driftsort_column *columns,
+                                        size_t ncolumns,
+                                        driftsort_compar_fn_t compar,
+                                        void *arg) {
+  bool sorted = driftsort::sort_columns(
+      keys, nmemb, size, reinterpret_cast<const driftsort::Column *>(columns),
+      ncolumns, driftsort::three_way(CCompare{compar, arg}));
+  return sorted ? 0 : -1;
+}
+
+extern "C" int driftsort_sort_columns_key(void *keys, size_t nmemb,
+                                          size_t size,
+                                          const struct driftsort_key *key,
+                                          const driftsort_column *columns,
+                                          size_t ncolumns) {
+  if (key->type < DRIFTSORT_KEY_UNSIGNED || key->type > DRIFTSORT_KEY_BYTES)
+    return -1;
+  driftsort::KeySpec spec{key->offset, key->width,
+                          static_cast<driftsort::KeyType>(key->type),
+                          key->descending != 0};
+  bool sorted = driftsort::sort_columns_key(
+      keys, nmemb, size, spec,
+      reinterpret_cast<const driftsort::Column *>(columns), ncolumns);
+  return sorted ? 0 : -1;
+}
@@ -0,0 +1,24 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/external.h"
+#include "driftsort/capi.h"
+
+extern "C" int driftsort_sort_file(const char *input, const char *output,
+                                   size_t size,
+                                   const struct driftsort_key *key,
+                                   size_t memory_budget,
+                                   const char *temp_dir) {
+  if (key->type < DRIFTSORT_KEY_UNSIGNED || key->type > DRIFTSORT_KEY_BYTES)
+    return EINVAL;
+  driftsort::ExternalSortOptions options{
+      size,
+      {key->offset, key->width, static_cast<driftsort::KeyType>(key->type),
+       key->descending != 0},
+      memory_budget,
+      temp_dir};
+  return driftsort::sort_file(input, output, options);
+}
@@ -0,0 +1,21 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/driftsort.h"
+
+extern "C" size_t driftsort_qsort_fewest_compares_r(
+    void *base, size_t nmemb, size_t size, driftsort_compar_fn_t compar,
+    void *arg) {
+  size_t count = 0;
+  driftsort::qsort_r(base, nmemb, size,
+                     driftsort::fewest_compares(
+                         [compar, arg](const void *a, const void *b) {
+                           return compar(a, b, arg);
+                         },
+                         count));
+  return count;
+}
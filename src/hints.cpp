@@ -0,0 +1,26 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/hints.h"
+#include "driftsort/capi.h"
+
+extern "C" int driftsort_sort_hinted_r(void *base, size_t nmemb, size_t size,
+                                       const driftsort_hints *hints,
+                                       driftsort_compar_fn_t compar,
+                                       void *arg) {
+  driftsort::SortHints sort_hints;
+  sort_hints.sorted_prefix = hints->sorted_prefix;
+  sort_hints.run_ends = hints->run_ends;
+  sort_hints.run_count = hints->run_count;
+  sort_hints.dirty = hints->dirty;
+  sort_hints.dirty_count = hints->dirty_count;
+  bool valid = driftsort::sort_hinted(
+      base, nmemb, size, sort_hints,
+      driftsort::three_way([compar, arg](const void *a, const void *b) {
+        return compar(a, b, arg);
+      }));
+  return valid ? 0 : -1;
+}
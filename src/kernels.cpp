@@ -0,0 +1,45 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// The sort behind qsort and qsort_r, built once for every ISA level in
+// src/CMakeLists.txt with DRIFTSORT_KERNELS naming the level. qsort.cpp
+// picks one of the builds when the library is loaded.
+
+#ifndef DRIFTSORT_KERNELS
+#error "DRIFTSORT_KERNELS must name the ISA level of this build"
+#endif
+
+#define DRIFTSORT_CONCAT_(a, b) a##_##b
+#define DRIFTSORT_CONCAT(a, b) DRIFTSORT_CONCAT_(a, b)
+
+// The builds instantiate the same inline functions with different
+// instructions. Giving every build its own namespace keeps the linker from
+// merging them, which could leave a newer ISA in the baseline build.
+#define driftsort DRIFTSORT_CONCAT(driftsort, DRIFTSORT_KERNELS)
+
+#include "driftsort/driftsort.h"
+#include "kernels.h"
+
+DRIFTSORT_DECLARE_KERNELS(DRIFTSORT_KERNELS)
+
+extern "C" void DRIFTSORT_KERNEL(qsort_r)(void *base, size_t nmemb,
+                                          size_t size, compar_d_fn_t compar,
+                                          void *arg) {
+  driftsort::qsort_r(
+      base, nmemb, size,
+      driftsort::three_way([compar, arg](const void *a, const void *b) {
+#ifdef __APPLE__
+        return compar(arg, a, b);
+#else
+        return compar(a, b, arg);
+#endif
+      }));
+}
+
+extern "C" void DRIFTSORT_KERNEL(qsort)(void *base, size_t nmemb, size_t size,
+                                        compar_fn_t compar) {
+  driftsort::qsort_r(base, nmemb, size, driftsort::three_way(compar));
+}
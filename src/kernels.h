@@ -0,0 +1,35 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "driftsort/common.h"
+#include <cstddef>
+
+#ifdef __APPLE__
+typedef int (*compar_d_fn_t)(void *, const void *, const void *);
+#else
+typedef int (*compar_d_fn_t)(const void *, const void *, void *);
+#endif
+typedef int (*compar_fn_t)(const void *, const void *);
+
+// The entry point `name` of the kernels built for ISA level `level`, e.g.
+// `driftsort_kernel_qsort_r_v3`.
+#define DRIFTSORT_KERNEL_FOR(name, level) DRIFTSORT_KERNEL_FOR_(name, level)
+#define DRIFTSORT_KERNEL_FOR_(name, level) driftsort_kernel_##name##_##level
+
+#ifdef DRIFTSORT_KERNELS
+#define DRIFTSORT_KERNEL(name) DRIFTSORT_KERNEL_FOR(name, DRIFTSORT_KERNELS)
+#endif
+
+// Unlike qsort_r, the kernels take `compar` before `arg` on every platform.
+#define DRIFTSORT_DECLARE_KERNELS(level)                                       \
+  extern "C" {                                                                 \
+  DRIFTSORT_HIDDEN void DRIFTSORT_KERNEL_FOR(qsort_r, level)(                  \
+      void *base, size_t nmemb, size_t size, compar_d_fn_t compar, void *arg); \
+  DRIFTSORT_HIDDEN void DRIFTSORT_KERNEL_FOR(qsort, level)(                    \
+      void *base, size_t nmemb, size_t size, compar_fn_t compar);              \
+  }
@@ -0,0 +1,38 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/kmerge.h"
+#include "driftsort/capi.h"
+
+static_assert(sizeof(driftsort_run) == sizeof(driftsort::SortedRun) &&
+              alignof(driftsort_run) == alignof(driftsort::SortedRun));
+
+extern "C" int driftsort_merge_runs_r(const struct driftsort_run *runs,
+                                      size_t nruns, size_t size, void *dest,
+                                      driftsort_compar_fn_t compar,
+                                      void *arg) {
+  bool merged = driftsort::merge_runs(
+      reinterpret_cast<const driftsort::SortedRun *>(runs), nruns, size, dest,
+      [compar, arg](const void *a, const void *b) {
+        return compar(a, b, arg);
+      });
+  return merged ? 0 : -1;
+}
+
+extern "C" int driftsort_merge_runs_sink_r(
+    const struct driftsort_run *runs, size_t nruns, size_t size,
+    void (*sink)(const void *elements, size_t nmemb, void *sink_arg),
+    void *sink_arg, driftsort_compar_fn_t compar, void *arg) {
+  bool merged = driftsort::merge_runs_into(
+      reinterpret_cast<const driftsort::SortedRun *>(runs), nruns, size,
+      [sink, sink_arg](const void *elements, size_t nmemb) {
+        sink(elements, nmemb, sink_arg);
+      },
+      [compar, arg](const void *a, const void *b) {
+        return compar(a, b, arg);
+      });
+  return merged ? 0 : -1;
+}
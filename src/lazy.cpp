@@ -0,0 +1,31 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/lazy.h"
+#include "driftsort/capi.h"
+#include "ccompare.h"
+#include <new>
+
+using driftsort::CCompare;
+
+struct DRIFTSORT_HIDDEN driftsort_cursor {
+  driftsort::LazySorter<CCompare> sorter;
+};
+
+extern "C" driftsort_cursor *driftsort_cursor_new_r(
+    void *base, size_t nmemb, size_t size, driftsort_compar_fn_t compar,
+    void *arg) {
+  return new (std::nothrow)
+      driftsort_cursor{{base, nmemb, size, CCompare{compar, arg}}};
+}
+
+extern "C" void *driftsort_cursor_next(driftsort_cursor *cursor) {
+  return cursor->sorter.next();
+}
+
+extern "C" void driftsort_cursor_free(driftsort_cursor *cursor) {
+  delete cursor;
+}
@@ -0,0 +1,22 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/driftsort.h"
+
+extern "C" const char *
+driftsort_estimate_order_r(void *base, size_t nmemb, size_t size,
+                           struct driftsort_order_estimate *estimate,
+                           driftsort_compar_fn_t compar, void *arg) {
+  driftsort::presort::Estimate sample = driftsort::estimate_order(
+      base, nmemb, size,
+      driftsort::three_way([compar, arg](const void *a, const void *b) {
+        return compar(a, b, arg);
+      }));
+  *estimate = {sample.pairs, sample.descents, sample.spread_pairs,
+               sample.spread_descents};
+  return driftsort::presort::name(driftsort::presort::choose(sample));
+}
@@ -4,30 +4,102 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
-#include "driftsort/driftsort.h"
+#include "driftsort/capi.h"
+#include "driftsort/isa.h"
+#include "kernels.h"
+#include <atomic>
+#include <cstdlib>
+
+DRIFTSORT_DECLARE_KERNELS(baseline)
+#ifdef DRIFTSORT_ISA_DISPATCH
+DRIFTSORT_DECLARE_KERNELS(v2)
+DRIFTSORT_DECLARE_KERNELS(v3)
+DRIFTSORT_DECLARE_KERNELS(v4)
+#endif
+
+namespace {
+using qsort_r_fn = void (*)(void *, size_t, size_t, compar_d_fn_t, void *);
+using qsort_fn = void (*)(void *, size_t, size_t, compar_fn_t);
+
+struct Kernels {
+  qsort_r_fn qsort_r;
+  qsort_fn qsort;
+};
+
+#define DRIFTSORT_KERNELS_OF(level)                                            \
+  {DRIFTSORT_KERNEL_FOR(qsort_r, level), DRIFTSORT_KERNEL_FOR(qsort, level)}
+#ifdef DRIFTSORT_ISA_DISPATCH
+constexpr Kernels KERNELS[driftsort::isa::LEVELS] = {
+    DRIFTSORT_KERNELS_OF(baseline), DRIFTSORT_KERNELS_OF(v2),
+    DRIFTSORT_KERNELS_OF(v3), DRIFTSORT_KERNELS_OF(v4)};
+#else
+constexpr Kernels KERNELS[1] = {DRIFTSORT_KERNELS_OF(baseline)};
+#endif
+#undef DRIFTSORT_KERNELS_OF
+
+driftsort::isa::Level selected_level() {
+#ifdef DRIFTSORT_ISA_DISPATCH
+  return driftsort::isa::select(std::getenv("DRIFTSORT_ISA"));
+#else
+  return driftsort::isa::Level::baseline;
+#endif
+}
+
+void bind_and_qsort_r(void *base, size_t nmemb, size_t size,
+                      compar_d_fn_t compar, void *arg);
+void bind_and_qsort(void *base, size_t nmemb, size_t size, compar_fn_t compar);
+
+// The kernels qsort and qsort_r call. Until they are bound, which happens
+// when the library is loaded, they point to functions that bind them first.
+// Binding is idempotent, so racing calls at most bind twice.
+std::atomic<qsort_r_fn> qsort_r_kernel{bind_and_qsort_r};
+std::atomic<qsort_fn> qsort_kernel{bind_and_qsort};
+
+void bind() {
+  const Kernels &kernels = KERNELS[static_cast<size_t>(selected_level())];
+  qsort_r_kernel.store(kernels.qsort_r, std::memory_order_relaxed);
+  qsort_kernel.store(kernels.qsort, std::memory_order_relaxed);
+}
+
+void bind_and_qsort_r(void *base, size_t nmemb, size_t size,
+                      compar_d_fn_t compar, void *arg) {
+  bind();
+  qsort_r_kernel.load(std::memory_order_relaxed)(base, nmemb, size, compar,
+                                                 arg);
+}
+
+void bind_and_qsort(void *base, size_t nmemb, size_t size,
+                    compar_fn_t compar) {
+  bind();
+  qsort_kernel.load(std::memory_order_relaxed)(base, nmemb, size, compar);
+}
+
+// Binds the kernels at load time, so that sorting only costs one indirect
+// call more, as much as the PLT of an ifunc would. Resolving in an ifunc
+// instead would run before `getenv` can be called safely.
+[[maybe_unused]] const bool bound_at_load = (bind(), true);
+} // namespace
 
 #ifdef __APPLE__
-typedef int (*compar_d_fn_t)(void *, const void *, const void *);
-typedef int (*compar_fn_t)(const void *, const void *);
-extern "C" void qsort_r(void *base, size_t nmemb, size_t size, void *arg,
-                        compar_d_fn_t compar) {
-  driftsort::qsort_r(base, nmemb, size,
-                     [compar, arg](const void *a, const void *b) {
-                       return compar(arg, a, b);
-                     });
+extern "C" DRIFTSORT_EXPORT void qsort_r(void *base, size_t nmemb,
+                                         size_t size, void *arg,
+                                         compar_d_fn_t compar) {
+  qsort_r_kernel.load(std::memory_order_relaxed)(base, nmemb, size, compar,
+                                                 arg);
 }
 #else
-typedef int (*compar_d_fn_t)(const void *, const void *, void *);
-typedef int (*compar_fn_t)(const void *, const void *);
-extern "C" void qsort_r(void *base, size_t nmemb, size_t size,
-                        compar_d_fn_t compar, void *arg) {
-  driftsort::qsort_r(base, nmemb, size,
-                     [compar, arg](const void *a, const void *b) {
-                       return compar(a, b, arg);
-                     });
+extern "C" DRIFTSORT_EXPORT void qsort_r(void *base, size_t nmemb,
+                                         size_t size, compar_d_fn_t compar,
+                                         void *arg) {
+  qsort_r_kernel.load(std::memory_order_relaxed)(base, nmemb, size, compar,
+                                                 arg);
 }
 #endif
-extern "C" void qsort(void *base, size_t nmemb, size_t size,
-                      compar_fn_t compar) {
-  driftsort::qsort_r(base, nmemb, size, compar);
+extern "C" DRIFTSORT_EXPORT void qsort(void *base, size_t nmemb,
+                                       size_t size, compar_fn_t compar) {
+  qsort_kernel.load(std::memory_order_relaxed)(base, nmemb, size, compar);
+}
+
+extern "C" DRIFTSORT_EXPORT const char *driftsort_isa(void) {
+  return driftsort::isa::name(selected_level());
 }
@@ -0,0 +1,36 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/select.h"
+#include "driftsort/capi.h"
+
+extern "C" void driftsort_nth_element_r(void *base, size_t nmemb, size_t size,
+                                        size_t k, driftsort_compar_fn_t compar,
+                                        void *arg) {
+  driftsort::nth_element(base, nmemb, size, k,
+                         [compar, arg](const void *a, const void *b) {
+                           return compar(a, b, arg);
+                         });
+}
+
+extern "C" void driftsort_partial_sort_r(void *base, size_t nmemb, size_t size,
+                                         size_t k,
+                                         driftsort_compar_fn_t compar,
+                                         void *arg) {
+  driftsort::partial_sort(base, nmemb, size, k,
+                          [compar, arg](const void *a, const void *b) {
+                            return compar(a, b, arg);
+                          });
+}
+
+extern "C" void driftsort_top_k_r(const void *base, size_t nmemb, size_t size,
+                                  size_t k, void *dest,
+                                  driftsort_compar_fn_t compar, void *arg) {
+  driftsort::top_k(base, nmemb, size, k, dest,
+                   [compar, arg](const void *a, const void *b) {
+                     return compar(a, b, arg);
+                   });
+}
@@ -0,0 +1,62 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/setops.h"
+#include "driftsort/capi.h"
+#include "ccompare.h"
+
+static_assert(sizeof(driftsort_join_range) == sizeof(driftsort::JoinRange) &&
+              alignof(driftsort_join_range) == alignof(driftsort::JoinRange));
+
+namespace {
+auto comparator(driftsort_compar_fn_t compar, void *arg) {
+  return driftsort::three_way(driftsort::CCompare{compar, arg});
+}
+} // namespace
+
+extern "C" size_t driftsort_set_union_r(const void *a, size_t na,
+                                        const void *b, size_t nb, size_t size,
+                                        void *dest,
+                                        driftsort_compar_fn_t compar,
+                                        void *arg) {
+  return driftsort::set_union(a, na, b, nb, size, dest,
+                              comparator(compar, arg));
+}
+
+extern "C" size_t driftsort_set_intersection_r(const void *a, size_t na,
+                                               const void *b, size_t nb,
+                                               size_t size, void *dest,
+                                               driftsort_compar_fn_t compar,
+                                               void *arg) {
+  return driftsort::set_intersection(a, na, b, nb, size, dest,
+                                     comparator(compar, arg));
+}
+
+extern "C" size_t driftsort_set_difference_r(const void *a, size_t na,
+                                             const void *b, size_t nb,
+                                             size_t size, void *dest,
+                                             driftsort_compar_fn_t compar,
+                                             void *arg) {
+  return driftsort::set_difference(a, na, b, nb, size, dest,
+                                   comparator(compar, arg));
+}
+
+extern "C" size_t driftsort_set_symmetric_difference_r(
+    const void *a, size_t na, const void *b, size_t nb, size_t size,
+    void *dest, driftsort_compar_fn_t compar, void *arg) {
+  return driftsort::set_symmetric_difference(a, na, b, nb, size, dest,
+                                             comparator(compar, arg));
+}
+
+extern "C" size_t driftsort_merge_join_r(const void *a, size_t na,
+                                         const void *b, size_t nb, size_t size,
+                                         driftsort_join_range *dest,
+                                         driftsort_compar_fn_t compar,
+                                         void *arg) {
+  return driftsort::merge_join(a, na, b, nb, size,
+                               reinterpret_cast<driftsort::JoinRange *>(dest),
+                               comparator(compar, arg));
+}
@@ -0,0 +1,42 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/stream.h"
+#include "driftsort/capi.h"
+#include "ccompare.h"
+#include <new>
+
+using driftsort::CCompare;
+
+struct DRIFTSORT_HIDDEN driftsort_stream {
+  driftsort::StreamSorter<CCompare> sorter;
+};
+
+extern "C" driftsort_stream *
+driftsort_stream_new_r(size_t size, driftsort_compar_fn_t compar, void *arg) {
+  return new (std::nothrow) driftsort_stream{{size, CCompare{compar, arg}}};
+}
+
+extern "C" int driftsort_stream_push(driftsort_stream *stream,
+                                     const void *base, size_t nmemb) {
+  return stream->sorter.push(base, nmemb) ? 0 : -1;
+}
+
+extern "C" const void *
+driftsort_stream_sorted_prefix(driftsort_stream *stream, size_t *nmemb) {
+  *nmemb = stream->sorter.sorted_prefix();
+  return stream->sorter.data();
+}
+
+extern "C" const void *driftsort_stream_finish(driftsort_stream *stream,
+                                               size_t *nmemb) {
+  *nmemb = stream->sorter.size();
+  return stream->sorter.finish();
+}
+
+extern "C" void driftsort_stream_free(driftsort_stream *stream) {
+  delete stream;
+}
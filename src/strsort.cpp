@@ -0,0 +1,21 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/strsort.h"
+#include "driftsort/capi.h"
+
+static_assert(sizeof(driftsort_string) == sizeof(driftsort::StringRef) &&
+              alignof(driftsort_string) == alignof(driftsort::StringRef));
+
+extern "C" void driftsort_sort_cstrings(const char **strings, size_t nmemb) {
+  driftsort::sort_strings(strings, nmemb);
+}
+
+extern "C" void driftsort_sort_strings(driftsort_string *strings,
+                                       size_t nmemb) {
+  driftsort::sort_strings(reinterpret_cast<driftsort::StringRef *>(strings),
+                          nmemb);
+}
@@ -0,0 +1,32 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/unique.h"
+#include "driftsort/capi.h"
+
+extern "C" size_t driftsort_sort_unique_r(void *base, size_t nmemb,
+                                          size_t size,
+                                          driftsort_compar_fn_t compar,
+                                          void *arg) {
+  return driftsort::sort_unique(base, nmemb, size,
+                                [compar, arg](const void *a, const void *b) {
+                                  return compar(a, b, arg);
+                                });
+}
+
+extern "C" size_t driftsort_sort_group_r(
+    void *base, size_t nmemb, size_t size,
+    void (*reduce)(void *group, size_t nmemb, void *reduce_arg),
+    void *reduce_arg, driftsort_compar_fn_t compar, void *arg) {
+  return driftsort::sort_group(
+      base, nmemb, size,
+      [reduce, reduce_arg](void *group, size_t count) {
+        reduce(group, count, reduce_arg);
+      },
+      [compar, arg](const void *a, const void *b) {
+        return compar(a, b, arg);
+      });
+}
@@ -0,0 +1,125 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/argsort.h"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstring>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+using namespace driftsort;
+
+template <typename Index, typename Less>
+std::vector<Index> reference_perm(size_t length, Less less) {
+  std::vector<Index> perm(length);
+  std::iota(perm.begin(), perm.end(), Index{0});
+  std::stable_sort(perm.begin(), perm.end(), less);
+  return perm;
+}
+
+template <typename Index> void argsort_ints(std::vector<int> a) {
+  std::vector<int> copy = a;
+  std::vector<Index> perm(a.size()), ranks(a.size());
+  argsort(a.data(), a.size(), sizeof(int), perm.data(), ranks.data(),
+          [](const void *x, const void *y) {
+            return -(*static_cast<const int *>(x) <
+                     *static_cast<const int *>(y));
+          });
+  ASSERT_EQ(a, copy);
+  ASSERT_EQ(perm, reference_perm<Index>(a.size(), [&](Index x, Index y) {
+              return a[x] < a[y];
+            }));
+  for (size_t i = 0; i < a.size(); i++)
+    ASSERT_EQ(ranks[perm[i]], i);
+}
+
+void argsort_ints_32(std::vector<int> a) { argsort_ints<uint32_t>(a); }
+
+void argsort_ints_64(std::vector<int> a) { argsort_ints<uint64_t>(a); }
+
+using Record = std::array<unsigned char, 24>;
+
+// Decodes the key independently of the prefix encoding.
+std::strong_ordering reference_compare(const Record &a, const Record &b,
+                                       const KeySpec &spec) {
+  auto load = [&](const Record &r, auto value) {
+    std::memcpy(&value, r.data() + spec.offset, sizeof(value));
+    return value;
+  };
+  std::strong_ordering res = std::strong_ordering::equal;
+  switch (spec.type) {
+  case KeyType::unsigned_int:
+    if (spec.width == 1)
+      res = load(a, uint8_t{}) <=> load(b, uint8_t{});
+    else if (spec.width == 2)
+      res = load(a, uint16_t{}) <=> load(b, uint16_t{});
+    else if (spec.width == 4)
+      res = load(a, uint32_t{}) <=> load(b, uint32_t{});
+    else
+      res = load(a, uint64_t{}) <=> load(b, uint64_t{});
+    break;
+  case KeyType::signed_int:
+    if (spec.width == 1)
+      res = load(a, int8_t{}) <=> load(b, int8_t{});
+    else if (spec.width == 2)
+      res = load(a, int16_t{}) <=> load(b, int16_t{});
+    else if (spec.width == 4)
+      res = load(a, int32_t{}) <=> load(b, int32_t{});
+    else
+      res = load(a, int64_t{}) <=> load(b, int64_t{});
+    break;
+  case KeyType::floating:
+    if (spec.width == 4)
+      res = std::strong_order(load(a, float{}), load(b, float{}));
+    else
+      res = std::strong_order(load(a, double{}), load(b, double{}));
+    break;
+  case KeyType::bytes:
+    res = std::memcmp(a.data() + spec.offset, b.data() + spec.offset,
+                      spec.width) <=> 0;
+    break;
+  }
+  return spec.descending ? 0 <=> res : res;
+}
+
+void argsort_by_key(std::vector<Record> a, int type, size_t width_seed,
+                    size_t offset_seed, bool descending) {
+  static constexpr size_t WIDTHS[] = {1, 2, 4, 8};
+  KeySpec spec{0, 0, static_cast<KeyType>(type), descending};
+  if (spec.type == KeyType::floating)
+    spec.width = width_seed % 2 == 0 ? 4 : 8;
+  else if (spec.type == KeyType::bytes)
+    spec.width = 1 + width_seed % 24;
+  else
+    spec.width = WIDTHS[width_seed % 4];
+  spec.offset = offset_seed % (sizeof(Record) - spec.width + 1);
+  // Keep some duplicates around by shrinking the key alphabet.
+  for (auto &r : a)
+    for (auto &c : r)
+      c &= 0x83;
+
+  std::vector<uint32_t> perm(a.size()), ranks(a.size());
+  ASSERT_TRUE(argsort_key(a.data(), a.size(), sizeof(Record), spec,
+                          perm.data(), ranks.data()));
+  ASSERT_EQ(perm,
+            reference_perm<uint32_t>(a.size(), [&](uint32_t x, uint32_t y) {
+              return reference_compare(a[x], a[y], spec) < 0;
+            }));
+  for (size_t i = 0; i < a.size(); i++)
+    ASSERT_EQ(ranks[perm[i]], i);
+}
+
+FUZZ_TEST(DriftSortTest, argsort_ints_32);
+FUZZ_TEST(DriftSortTest, argsort_ints_64);
+FUZZ_TEST(DriftSortTest, argsort_by_key)
+    .WithDomains(fuzztest::Arbitrary<std::vector<Record>>(),
+                 fuzztest::InRange(0, 3), fuzztest::Arbitrary<size_t>(),
+                 fuzztest::Arbitrary<size_t>(), fuzztest::Arbitrary<bool>());
@@ -0,0 +1,77 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/async.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+bool id_less(const Tagged &x, const Tagged &y) { return x.id < y.id; }
+
+// Compares keys, and cancels `control` at the `cancel_at`th comparison.
+struct CancellingCompare {
+  SortControl *control;
+  size_t *count;
+  size_t cancel_at;
+  int operator()(const void *a, const void *b) const {
+    if (++*count == cancel_at)
+      control->cancel();
+    int x = static_cast<const Tagged *>(a)->key;
+    int y = static_cast<const Tagged *>(b)->key;
+    return (x > y) - (x < y);
+  }
+};
+} // namespace
+
+void sort_cancellable_keeps_elements(std::vector<int> a, bool few_keys,
+                                     size_t cancel_at, bool three_way_compare) {
+  std::vector<Tagged> v = tag(a, few_keys ? 16 : 1 << 20);
+  std::vector<Tagged> expected = stable_sorted(v);
+  SortControl control;
+  size_t count = 0;
+  CancellingCompare compare{&control, &count, cancel_at};
+  bool sorted =
+      three_way_compare
+          ? sort_cancellable(v.data(), v.size(), sizeof(Tagged),
+                             three_way(compare), control)
+          : sort_cancellable(v.data(), v.size(), sizeof(Tagged), compare,
+                             control);
+  if (sorted) {
+    ASSERT_EQ(v, expected);
+    ASSERT_EQ(control.progress(), 1.0);
+    return;
+  }
+  ASSERT_TRUE(control.cancelled());
+  ASSERT_LT(control.progress(), 1.0);
+  std::sort(v.begin(), v.end(), id_less);
+  std::sort(expected.begin(), expected.end(), id_less);
+  ASSERT_EQ(v, expected);
+}
+
+void sort_cancellable_to_the_end(std::vector<int> a) {
+  std::vector<Tagged> v = tag(a, 1 << 20);
+  std::vector<Tagged> expected = stable_sorted(v);
+  SortControl control;
+  size_t count = 0;
+  ASSERT_TRUE(sort_cancellable(v.data(), v.size(), sizeof(Tagged),
+                               CancellingCompare{&control, &count, 0},
+                               control));
+  ASSERT_EQ(v, expected);
+  ASSERT_FALSE(control.cancelled());
+}
+
+FUZZ_TEST(DriftSortTest, sort_cancellable_keeps_elements)
+    .WithDomains(fuzztest::Arbitrary<std::vector<int>>(),
+                 fuzztest::Arbitrary<bool>(),
+                 fuzztest::InRange<size_t>(1, 1 << 14),
+                 fuzztest::Arbitrary<bool>());
+FUZZ_TEST(DriftSortTest, sort_cancellable_to_the_end);
@@ -0,0 +1,67 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/batch.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+// Concatenates the inputs into one buffer and returns their CSR offsets.
+std::vector<size_t> flatten(const std::vector<std::vector<int>> &inputs,
+                            std::vector<Tagged> &data) {
+  std::vector<size_t> offsets{0};
+  for (auto &input : inputs) {
+    for (int x : input)
+      data.push_back({x % 16, data.size()});
+    offsets.push_back(data.size());
+  }
+  return offsets;
+}
+
+std::vector<Tagged> sort_each(std::vector<Tagged> data,
+                              const std::vector<size_t> &offsets) {
+  for (size_t i = 0; i + 1 < offsets.size(); i++)
+    std::stable_sort(data.begin() + offsets[i], data.begin() + offsets[i + 1],
+                     key_less);
+  return data;
+}
+} // namespace
+
+void sort_segments_sorts_each(std::vector<std::vector<int>> inputs) {
+  std::vector<Tagged> data;
+  std::vector<size_t> offsets = flatten(inputs, data);
+  std::vector<Tagged> expected = sort_each(data, offsets);
+  std::vector<Segment> segments;
+  for (size_t i = 0; i + 1 < offsets.size(); i++)
+    segments.push_back({data.data() + offsets[i], offsets[i + 1] - offsets[i]});
+  sort_segments(segments.data(), segments.size(), sizeof(Tagged),
+                compare_tagged);
+  bool same = true;
+  for (size_t i = 0; i < data.size(); i++)
+    same &= data[i].id == expected[i].id;
+  ASSERT_TRUE(same);
+}
+
+void sort_csr_sorts_each(std::vector<std::vector<int>> inputs) {
+  std::vector<Tagged> data;
+  std::vector<size_t> offsets = flatten(inputs, data);
+  std::vector<Tagged> expected = sort_each(data, offsets);
+  sort_csr(data.data(), offsets.data(), offsets.size() - 1, sizeof(Tagged),
+           compare_tagged);
+  bool same = true;
+  for (size_t i = 0; i < data.size(); i++)
+    same &= data[i].id == expected[i].id;
+  ASSERT_TRUE(same);
+}
+
+FUZZ_TEST(DriftSortTest, sort_segments_sorts_each);
+FUZZ_TEST(DriftSortTest, sort_csr_sorts_each);
@@ -0,0 +1,126 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/cachedkey.h"
+#include "driftsort/permute.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstring>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+struct TaggedDouble {
+  double key;
+  size_t id;
+};
+
+using Record = std::array<unsigned char, 16>;
+} // namespace
+
+void sort_by_cached_int_key(std::vector<int> a, bool few_keys) {
+  std::vector<Tagged> v = tag(a, few_keys ? 16 : 1 << 20);
+  std::vector<Tagged> expected = stable_sorted(v);
+  size_t calls = 0;
+  ASSERT_TRUE(sort_by_cached_key(v.data(), v.size(), sizeof(Tagged),
+                                 [&calls](const void *x) {
+                                   calls++;
+                                   return static_cast<const Tagged *>(x)->key;
+                                 }));
+  ASSERT_EQ(calls, v.size());
+  ASSERT_EQ(v, expected);
+}
+
+void sort_by_cached_key_breaks_ties(std::vector<int> a) {
+  std::vector<Tagged> v = tag(a, 8);
+  std::vector<Tagged> expected = v;
+  std::sort(expected.begin(), expected.end(),
+            [](const Tagged &x, const Tagged &y) {
+              return x.key != y.key ? x.key < y.key : x.id > y.id;
+            });
+  ASSERT_TRUE(sort_by_cached_key(
+      v.data(), v.size(), sizeof(Tagged),
+      [](const void *x) { return static_cast<const Tagged *>(x)->key; },
+      [](const void *x, const void *y) {
+        size_t i = static_cast<const Tagged *>(x)->id;
+        size_t j = static_cast<const Tagged *>(y)->id;
+        return (i < j) - (i > j);
+      }));
+  ASSERT_EQ(v, expected);
+}
+
+void sort_by_cached_double_key(std::vector<double> a) {
+  std::vector<TaggedDouble> v;
+  for (size_t i = 0; i < a.size(); i++)
+    v.push_back({a[i], i});
+  std::vector<TaggedDouble> expected = v;
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const TaggedDouble &x, const TaggedDouble &y) {
+                     return std::strong_order(x.key, y.key) < 0;
+                   });
+  ASSERT_TRUE(sort_by_cached_key(v.data(), v.size(), sizeof(TaggedDouble),
+                                 [](const void *x) {
+                                   return static_cast<const TaggedDouble *>(x)
+                                       ->key;
+                                 }));
+  for (size_t i = 0; i < v.size(); i++)
+    ASSERT_EQ(v[i].id, expected[i].id);
+}
+
+void sort_by_cached_bytes_key(std::vector<Record> v, size_t key_size) {
+  std::vector<Record> expected = v;
+  std::stable_sort(expected.begin(), expected.end(),
+                   [key_size](const Record &x, const Record &y) {
+                     return std::memcmp(x.data(), y.data(), key_size) < 0;
+                   });
+  size_t calls = 0;
+  ASSERT_TRUE(sort_by_cached_key_bytes(
+      v.data(), v.size(), sizeof(Record), key_size,
+      [&calls, key_size](const void *x, void *key) {
+        calls++;
+        std::memcpy(key, x, key_size);
+      }));
+  ASSERT_EQ(calls, v.size());
+  ASSERT_EQ(v, expected);
+}
+
+void permute_matches_gather(std::vector<int> a) {
+  std::vector<uint32_t> perm(a.size());
+  std::iota(perm.begin(), perm.end(), 0u);
+  std::stable_sort(perm.begin(), perm.end(),
+                   [&](uint32_t x, uint32_t y) { return a[x] < a[y]; });
+  std::vector<int> expected(a.size());
+  for (size_t i = 0; i < a.size(); i++)
+    expected[i] = a[perm[i]];
+
+  std::vector<int> gathered = a;
+  std::vector<uint32_t> p = perm;
+  permute::apply(gathered.data(), gathered.size(), sizeof(int), p.data());
+  ASSERT_EQ(gathered, expected);
+
+  std::vector<int> cycled = a;
+  uint32_t *q = perm.data();
+  permute::apply_cycles(reinterpret_cast<std::byte *>(cycled.data()),
+                        cycled.size(), sizeof(int), q);
+  ASSERT_EQ(cycled, expected);
+  for (size_t i = 0; i < perm.size(); i++)
+    ASSERT_EQ(perm[i], i);
+}
+
+FUZZ_TEST(DriftSortTest, sort_by_cached_int_key);
+FUZZ_TEST(DriftSortTest, sort_by_cached_key_breaks_ties);
+FUZZ_TEST(DriftSortTest, sort_by_cached_double_key);
+FUZZ_TEST(DriftSortTest, sort_by_cached_bytes_key)
+    .WithDomains(fuzztest::Arbitrary<std::vector<Record>>(),
+                 fuzztest::InRange<size_t>(0, 16));
+FUZZ_TEST(DriftSortTest, permute_matches_gather);
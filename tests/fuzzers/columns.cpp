@@ -0,0 +1,141 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/columns.h"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+int compare_keys(const void *a, const void *b) {
+  int x, y;
+  std::memcpy(&x, a, sizeof(int));
+  std::memcpy(&y, b, sizeof(int));
+  return (x > y) - (x < y);
+}
+
+int compare_keys_r(const void *a, const void *b, void *) {
+  return compare_keys(a, b);
+}
+
+// A payload column whose row `i` holds `size` bytes derived from `i`.
+std::vector<uint8_t> payload(size_t length, size_t size) {
+  std::vector<uint8_t> column(length * size);
+  for (size_t i = 0; i < column.size(); i++)
+    column[i] = static_cast<uint8_t>(i / size * 31 + i % size);
+  return column;
+}
+} // namespace
+
+// Sorts a table with keys in the first four of `key_size` bytes, so that
+// both the records and the permutation are used, and payloads of 1, 3 and 8
+// bytes.
+void sort_columns_matches_stable_sort(std::vector<int> a, bool wide_keys,
+                                      bool few_keys) {
+  size_t n = a.size();
+  size_t key_size = wide_keys ? columns::MAX_INLINE_KEY_BYTES + 8 : 4;
+  std::vector<uint8_t> keys(n * key_size);
+  for (size_t i = 0; i < n; i++) {
+    int key = few_keys ? a[i] % 8 : a[i];
+    std::memcpy(&keys[i * key_size], &key, sizeof(int));
+    keys[i * key_size + key_size - 1] = static_cast<uint8_t>(i);
+  }
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+    return compare_keys(&keys[x * key_size], &keys[y * key_size]) < 0;
+  });
+
+  const size_t sizes[] = {1, 3, 8};
+  std::vector<std::vector<uint8_t>> data, c_data;
+  std::vector<Column> payloads;
+  std::vector<driftsort_column> c_payloads;
+  for (size_t size : sizes) {
+    data.push_back(payload(n, size));
+    c_data.push_back(payload(n, size));
+  }
+  for (size_t c = 0; c < 3; c++) {
+    payloads.push_back({data[c].data(), sizes[c]});
+    c_payloads.push_back({c_data[c].data(), sizes[c]});
+  }
+  std::vector<uint8_t> c_keys = keys;
+  ASSERT_TRUE(sort_columns(keys.data(), n, key_size, payloads.data(), 3,
+                           compare_keys));
+  ASSERT_EQ(driftsort_sort_columns_r(c_keys.data(), n, key_size,
+                                     c_payloads.data(), 3, compare_keys_r,
+                                     nullptr),
+            0);
+  ASSERT_EQ(keys, c_keys);
+  ASSERT_EQ(data, c_data);
+
+  std::vector<uint8_t> original_keys(n * key_size);
+  for (size_t i = 0; i < n; i++) {
+    int key = few_keys ? a[order[i]] % 8 : a[order[i]];
+    std::memcpy(&original_keys[i * key_size], &key, sizeof(int));
+    original_keys[i * key_size + key_size - 1] =
+        static_cast<uint8_t>(order[i]);
+  }
+  ASSERT_EQ(keys, original_keys);
+  for (size_t c = 0; c < 3; c++) {
+    std::vector<uint8_t> unsorted = payload(n, sizes[c]);
+    for (size_t i = 0; i < n; i++)
+      ASSERT_EQ(std::memcmp(&data[c][i * sizes[c]],
+                            &unsorted[order[i] * sizes[c]], sizes[c]),
+                0);
+  }
+}
+
+void sort_columns_key_matches_argsort(std::vector<int> a) {
+  size_t n = a.size();
+  std::vector<int> keys = a;
+  std::vector<uint64_t> wide(a.begin(), a.end());
+  std::vector<uint8_t> narrow(a.begin(), a.end());
+  driftsort_column c_columns[] = {{wide.data(), sizeof(uint64_t)},
+                                  {narrow.data(), sizeof(uint8_t)}};
+  driftsort_key key{0, sizeof(int), DRIFTSORT_KEY_SIGNED, 0};
+  ASSERT_EQ(driftsort_sort_columns_key(keys.data(), n, sizeof(int), &key,
+                                       c_columns, 2),
+            0);
+  std::vector<int> expected = a;
+  std::stable_sort(expected.begin(), expected.end());
+  ASSERT_EQ(keys, expected);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(wide[i], static_cast<uint64_t>(keys[i]));
+    ASSERT_EQ(narrow[i], static_cast<uint8_t>(keys[i]));
+  }
+
+  driftsort_key invalid{2, sizeof(int), DRIFTSORT_KEY_SIGNED, 0};
+  ASSERT_EQ(driftsort_sort_columns_key(keys.data(), n, sizeof(int), &invalid,
+                                       c_columns, 2),
+            -1);
+}
+
+void apply_matches_gather(std::vector<uint32_t> perm, size_t size) {
+  size = size % 24 + 1;
+  size_t n = perm.size();
+  std::iota(perm.begin(), perm.end(), 0);
+  for (size_t i = 0; i < n; i++)
+    std::swap(perm[i], perm[(i * 2654435761u + size) % n]);
+  std::vector<uint8_t> data = payload(n, size);
+  std::vector<uint8_t> expected(data.size());
+  for (size_t i = 0; i < n; i++)
+    std::memcpy(&expected[i * size], &data[perm[i] * size], size);
+  Column column{data.data(), size};
+  columns::apply(&column, 1, n, perm.data());
+  ASSERT_EQ(data, expected);
+}
+
+FUZZ_TEST(DriftSortTest, sort_columns_matches_stable_sort);
+FUZZ_TEST(DriftSortTest, sort_columns_key_matches_argsort);
+FUZZ_TEST(DriftSortTest, apply_matches_gather);
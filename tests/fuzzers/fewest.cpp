@@ -0,0 +1,65 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/merge.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <bit>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace driftsort;
+
+void qsort_fewest_compares_is_stable(std::vector<int> a, bool few_keys) {
+  std::vector<Tagged> v = tag(a, few_keys ? 16 : 1 << 20);
+  std::vector<Tagged> expected = stable_sorted(v);
+  size_t count = 0;
+  driftsort::qsort_r(v.data(), v.size(), sizeof(Tagged),
+                     fewest_compares(compare_tagged, count));
+  ASSERT_EQ(v, expected);
+  // no more than a merge sort, plus what galloping may waste
+  size_t n = v.size();
+  ASSERT_LE(count, n * std::bit_width(n) + n);
+}
+
+void merge_fewest_compares(std::vector<int> a, size_t mid, bool few_keys) {
+  std::vector<Tagged> v = tag(a, few_keys ? 4 : 1 << 20);
+  mid = mid % (v.size() + 1);
+  std::stable_sort(v.begin(), v.begin() + mid, key_less);
+  std::stable_sort(v.begin() + mid, v.end(), key_less);
+  std::vector<Tagged> expected = stable_sorted(v);
+  std::vector<Tagged> scratch(std::min(mid, v.size() - mid));
+  size_t count = 0;
+  BlobComparator comp{sizeof(Tagged), alignof(Tagged),
+                      fewest_compares(compare_tagged, count)};
+  merge::merge(v.data(), v.size(), scratch.data(), scratch.size(), mid, comp);
+  ASSERT_EQ(v, expected);
+}
+
+void capi_fewest_compares_sorts(std::vector<int> a) {
+  std::vector<int> expected = a;
+  std::sort(expected.begin(), expected.end());
+  size_t calls = 0;
+  size_t count = driftsort_qsort_fewest_compares_r(
+      a.data(), a.size(), sizeof(int),
+      [](const void *x, const void *y, void *arg) {
+        ++*static_cast<size_t *>(arg);
+        int l = *static_cast<const int *>(x);
+        int r = *static_cast<const int *>(y);
+        return (l > r) - (l < r);
+      },
+      &calls);
+  ASSERT_EQ(a, expected);
+  ASSERT_EQ(count, calls);
+}
+
+FUZZ_TEST(DriftSortTest, qsort_fewest_compares_is_stable);
+FUZZ_TEST(DriftSortTest, merge_fewest_compares);
+FUZZ_TEST(DriftSortTest, capi_fewest_compares_sorts);
@@ -0,0 +1,116 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/hints.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <cstdint>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <tuple>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+int compare_tagged_r(const void *a, const void *b, void *) {
+  return compare_tagged(a, b);
+}
+} // namespace
+
+// Sorts a prefix and runs after it as the hints say, then overwrites the
+// dirty elements.
+void sort_hinted_matches_stable_sort(std::vector<int> a, size_t prefix,
+                                     std::vector<uint8_t> runs,
+                                     std::vector<size_t> dirty, bool few_keys) {
+  size_t n = a.size();
+  int modulus = few_keys ? 8 : 1 << 20;
+  std::vector<Tagged> v;
+  for (size_t i = 0; i < n; i++)
+    v.push_back({a[i] % modulus, i});
+  prefix %= n + 1;
+  std::stable_sort(v.begin(), v.begin() + prefix, key_less);
+  std::vector<size_t> run_ends;
+  if (!runs.empty()) {
+    for (size_t end = prefix, i = 0; end < n; i++) {
+      size_t start = end;
+      end = std::min(n, end + 1 + runs[i % runs.size()]);
+      std::stable_sort(v.begin() + start, v.begin() + end, key_less);
+      run_ends.push_back(end);
+    }
+  }
+  for (size_t i = 0; i < n; i++)
+    v[i].id = i;
+  // Unsorted and dirty elements go after the sorted ones equal to them.
+  std::vector<bool> unsorted(n, run_ends.empty() && n > 0);
+  std::fill(unsorted.begin(), unsorted.begin() + prefix, false);
+  for (size_t &d : dirty) {
+    if (n == 0)
+      break;
+    d %= n;
+    v[d].key = static_cast<int>(d * 2654435761u % modulus);
+    unsorted[d] = true;
+  }
+  if (n == 0)
+    dirty.clear();
+  std::vector<Tagged> expected = v;
+  std::sort(expected.begin(), expected.end(),
+            [&](const Tagged &x, const Tagged &y) {
+              return std::tuple(x.key, unsorted[x.id], x.id) <
+                     std::tuple(y.key, unsorted[y.id], y.id);
+            });
+
+  SortHints hints;
+  hints.sorted_prefix = prefix;
+  hints.run_ends = run_ends.data();
+  hints.run_count = run_ends.size();
+  hints.dirty = dirty.data();
+  hints.dirty_count = dirty.size();
+  std::vector<Tagged> c_sorted = v;
+  ASSERT_TRUE(sort_hinted(v.data(), n, sizeof(Tagged), hints,
+                          three_way(compare_tagged)));
+  ASSERT_EQ(v, expected);
+
+  driftsort_hints c_hints{prefix, run_ends.data(), run_ends.size(),
+                          dirty.data(), dirty.size()};
+  ASSERT_EQ(driftsort_sort_hinted_r(c_sorted.data(), n, sizeof(Tagged),
+                                    &c_hints, compare_tagged_r, nullptr),
+            0);
+  ASSERT_EQ(c_sorted, expected);
+}
+
+void sort_hinted_rejects_invalid(std::vector<int> a, size_t prefix,
+                                 std::vector<size_t> run_ends,
+                                 std::vector<size_t> dirty) {
+  std::vector<int> v = a;
+  SortHints hints;
+  hints.sorted_prefix = prefix;
+  hints.run_ends = run_ends.data();
+  hints.run_count = run_ends.size();
+  hints.dirty = dirty.data();
+  hints.dirty_count = dirty.size();
+  bool valid = hints::is_valid(hints, a.size());
+  ASSERT_EQ(sort_hinted(v.data(), v.size(), sizeof(int), hints,
+                        [](const void *x, const void *y) {
+                          int l = *static_cast<const int *>(x);
+                          int r = *static_cast<const int *>(y);
+                          return (l > r) - (l < r);
+                        }),
+            valid);
+  if (!valid) {
+    ASSERT_EQ(v, a);
+    return;
+  }
+  // Wrong hints still leave a permutation.
+  std::sort(v.begin(), v.end());
+  std::sort(a.begin(), a.end());
+  ASSERT_EQ(v, a);
+}
+
+FUZZ_TEST(DriftSortTest, sort_hinted_matches_stable_sort);
+FUZZ_TEST(DriftSortTest, sort_hinted_rejects_invalid);
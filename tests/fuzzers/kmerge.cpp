@@ -0,0 +1,74 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/kmerge.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+// Sorts every input vector into a run and returns the runs together with
+// the stable sort of their concatenation.
+std::vector<std::vector<Tagged>>
+make_runs(const std::vector<std::vector<int>> &inputs,
+          std::vector<Tagged> &expected) {
+  std::vector<std::vector<Tagged>> runs;
+  for (auto &input : inputs) {
+    std::vector<Tagged> run;
+    for (int x : input)
+      run.push_back({x % 32, expected.size() + run.size()});
+    std::stable_sort(run.begin(), run.end(), key_less);
+    expected.insert(expected.end(), run.begin(), run.end());
+    runs.push_back(std::move(run));
+  }
+  std::stable_sort(expected.begin(), expected.end(), key_less);
+  return runs;
+}
+
+std::vector<SortedRun> refs(const std::vector<std::vector<Tagged>> &runs) {
+  std::vector<SortedRun> res;
+  for (auto &run : runs)
+    res.push_back({run.data(), run.size()});
+  return res;
+}
+} // namespace
+
+void kway_merge_is_stable(std::vector<std::vector<int>> inputs) {
+  std::vector<Tagged> expected;
+  auto runs = make_runs(inputs, expected);
+  auto run_refs = refs(runs);
+  std::vector<Tagged> merged(expected.size());
+  ASSERT_TRUE(merge_runs(run_refs.data(), run_refs.size(), sizeof(Tagged),
+                         merged.data(), compare_tagged));
+  for (size_t i = 0; i < expected.size(); i++)
+    ASSERT_EQ(merged[i].id, expected[i].id);
+}
+
+void kway_merge_into_sink(std::vector<std::vector<int>> inputs) {
+  std::vector<Tagged> expected;
+  auto runs = make_runs(inputs, expected);
+  auto run_refs = refs(runs);
+  std::vector<Tagged> merged;
+  ASSERT_TRUE(merge_runs_into(
+      run_refs.data(), run_refs.size(), sizeof(Tagged),
+      [&](const void *elements, size_t count) {
+        ASSERT_NE(count, 0u);
+        auto batch = static_cast<const Tagged *>(elements);
+        merged.insert(merged.end(), batch, batch + count);
+      },
+      compare_tagged));
+  ASSERT_EQ(merged.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++)
+    ASSERT_EQ(merged[i].id, expected[i].id);
+}
+
+FUZZ_TEST(DriftSortTest, kway_merge_is_stable);
+FUZZ_TEST(DriftSortTest, kway_merge_into_sink);
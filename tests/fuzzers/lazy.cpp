@@ -0,0 +1,52 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/lazy.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <ranges>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+using Sorter = LazySorter<decltype(&compare_tagged)>;
+static_assert(std::ranges::input_range<Sorter>);
+} // namespace
+
+void lazy_prefix_is_stable(std::vector<int> a, size_t count, int modulus) {
+  std::vector<Tagged> v = tag(a, modulus);
+  std::vector<Tagged> expected = stable_sorted(v);
+  count = count % (a.size() + 1);
+  Sorter sorter(v.data(), v.size(), sizeof(Tagged), compare_tagged);
+  for (size_t i = 0; i < count; i++) {
+    auto x = static_cast<Tagged *>(sorter.next());
+    ASSERT_EQ(x, &v[i]);
+    ASSERT_EQ(x->id, expected[i].id);
+  }
+  ASSERT_EQ(sorter.taken(), count);
+}
+
+void lazy_range_drains_everything(std::vector<int> a, int modulus) {
+  std::vector<Tagged> v = tag(a, modulus);
+  std::vector<Tagged> expected = stable_sorted(v);
+  Sorter sorter(v.data(), v.size(), sizeof(Tagged), compare_tagged);
+  size_t i = 0;
+  for (void *x : sorter)
+    ASSERT_EQ(static_cast<Tagged *>(x)->id, expected[i++].id);
+  ASSERT_EQ(i, v.size());
+  ASSERT_EQ(sorter.next(), nullptr);
+}
+
+FUZZ_TEST(DriftSortTest, lazy_prefix_is_stable)
+    .WithDomains(fuzztest::Arbitrary<std::vector<int>>(),
+                 fuzztest::Arbitrary<size_t>(), fuzztest::InRange(1, 1000));
+FUZZ_TEST(DriftSortTest, lazy_range_drains_everything)
+    .WithDomains(fuzztest::Arbitrary<std::vector<int>>(),
+                 fuzztest::InRange(1, 1000));
@@ -63,3 +63,17 @@ void merge_is_stable(std::vector<int> a, size_t mid) {
 FUZZ_TEST(DriftSortTest, merge_test);
 FUZZ_TEST(DriftSortTest, merge_test_greater);
 FUZZ_TEST(DriftSortTest, merge_is_stable);
+
+void merge_with_short_scratch(std::vector<int> a, size_t mid) {
+  std::vector<int> b = a;
+  std::sort(a.begin(), a.end());
+  mid = mid % (a.size() + 1);
+  std::vector<int> scratch(std::min(mid, a.size() - mid));
+  std::sort(b.begin(), b.begin() + mid);
+  std::sort(b.begin() + mid, b.end());
+  merge::merge(b.data(), b.size(), scratch.data(), scratch.size(), mid,
+               compare_blob<int>());
+  ASSERT_EQ(a, b);
+}
+
+FUZZ_TEST(DriftSortTest, merge_with_short_scratch);
@@ -0,0 +1,60 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/driftsort.h"
+#include "driftsort/presort.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+void expect_stably_sorted(std::vector<Tagged> v) {
+  for (size_t i = 0; i < v.size(); i++)
+    v[i].id = i;
+  std::vector<Tagged> expected = stable_sorted(v);
+  driftsort::qsort_r(v.data(), v.size(), sizeof(Tagged),
+                     three_way(compare_tagged));
+  ASSERT_EQ(v, expected);
+}
+} // namespace
+
+void presorted_with_tail(std::vector<int> tail, size_t prefix,
+                         bool descending, bool few_keys) {
+  size_t prefix_length = presort::MIN_LENGTH + prefix % 8192;
+  std::vector<Tagged> v;
+  for (size_t i = 0; i < prefix_length; i++) {
+    int key = static_cast<int>(few_keys && !descending ? i / 16 : i);
+    v.push_back({descending ? -key : key, 0});
+  }
+  for (int key : tail)
+    v.push_back({key % static_cast<int>(prefix_length), 0});
+  expect_stably_sorted(v);
+}
+
+void sort_sampled_runs(uint32_t seed, size_t length, size_t run_length,
+                       bool few_keys) {
+  length = presort::MIN_LENGTH + length % 20000;
+  run_length = 1 + run_length % 1000;
+  std::mt19937 rng(seed);
+  std::vector<Tagged> v(length);
+  for (size_t i = 0; i < length; i += run_length) {
+    size_t end = std::min(length, i + run_length);
+    for (size_t j = i; j < end; j++)
+      v[j].key = static_cast<int>(rng() % (few_keys ? 8 : 1 << 20));
+    std::sort(v.begin() + i, v.begin() + end,
+              [](const Tagged &x, const Tagged &y) { return x.key < y.key; });
+  }
+  expect_stably_sorted(v);
+}
+
+FUZZ_TEST(DriftSortTest, presorted_with_tail);
+FUZZ_TEST(DriftSortTest, sort_sampled_runs);
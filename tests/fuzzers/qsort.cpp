@@ -27,6 +27,18 @@ void qsort_less(std::vector<int> a) { qsort<std::less<int>>(a); }
 
 void qsort_greater(std::vector<int> a) { qsort<std::greater<int>>(a); }
 
+void qsort_three_way(std::vector<int> a) {
+  std::vector<int> b = a;
+  std::sort(a.begin(), a.end());
+  driftsort::qsort_r(b.data(), b.size(), sizeof(int),
+                     three_way([](const void *a, const void *b) {
+                       int x = *static_cast<const int *>(a);
+                       int y = *static_cast<const int *>(b);
+                       return (x > y) - (x < y);
+                     }));
+  ASSERT_EQ(a, b);
+}
+
 template <size_t Factor>
 struct alignas(alignof(long) * Factor) OverAlignedLong {
   std::array<long, Factor> data;
@@ -67,8 +79,44 @@ void qsort_over_aligned_8(std::vector<std::array<long, 8>> a) {
   qsort_over_aligned<8>(std::move(a));
 }
 
+// Orders by the first word only, so that the result also shows stability.
+template <size_t Factor>
+void qsort_aligned_over_aligned(std::vector<std::array<long, Factor>> a) {
+  // std::stable_sort may not align its buffer, so sort indices instead.
+  std::vector<size_t> order(a.size());
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t x, size_t y) { return a[x][0] < a[y][0]; });
+  std::vector<OverAlignedLong<Factor>> b, c;
+  for (size_t i : order)
+    b.push_back(OverAlignedLong<Factor>{a[i]});
+  for (auto &e : a)
+    c.push_back(OverAlignedLong<Factor>{e});
+  bool valid = driftsort::qsort_aligned(
+      c.data(), c.size(), sizeof(OverAlignedLong<Factor>),
+      alignof(OverAlignedLong<Factor>), [](const void *a, const void *b) {
+        long x = static_cast<const OverAlignedLong<Factor> *>(a)->data[0];
+        long y = static_cast<const OverAlignedLong<Factor> *>(b)->data[0];
+        return (x > y) - (x < y);
+      });
+  ASSERT_TRUE(valid);
+  ASSERT_EQ(b, c);
+}
+
+void qsort_aligned_over_aligned_2(std::vector<std::array<long, 2>> a) {
+  qsort_aligned_over_aligned<2>(std::move(a));
+}
+
+void qsort_aligned_over_aligned_8(std::vector<std::array<long, 8>> a) {
+  qsort_aligned_over_aligned<8>(std::move(a));
+}
+
 FUZZ_TEST(DriftSortTest, qsort_less);
 FUZZ_TEST(DriftSortTest, qsort_greater);
+FUZZ_TEST(DriftSortTest, qsort_three_way);
 FUZZ_TEST(DriftSortTest, qsort_over_aligned_2);
 FUZZ_TEST(DriftSortTest, qsort_over_aligned_4);
 FUZZ_TEST(DriftSortTest, qsort_over_aligned_8);
+FUZZ_TEST(DriftSortTest, qsort_aligned_over_aligned_2);
+FUZZ_TEST(DriftSortTest, qsort_aligned_over_aligned_8);
@@ -50,6 +50,73 @@ void quick_sort_is_stable(std::vector<int> a, size_t limit) {
   }
 }
 
+void quick_sort_three_way(std::vector<int> a, size_t limit) {
+  std::vector<int> b = a;
+  std::sort(a.begin(), a.end());
+  std::vector<int> scratch(a.size() + 16);
+  stable_quicksort(b.data(), b.size(), scratch.data(), scratch.size(), limit,
+                   {}, compare_blob_three_way<int>());
+  ASSERT_EQ(a, b);
+}
+
+void quick_sort_three_way_is_stable(std::vector<int> a, size_t limit) {
+  // Keys repeat often, so most partitions have a large equal part.
+  std::vector<std::pair<int, size_t>> v;
+  for (size_t i = 0; i < a.size(); i++)
+    v.push_back({a[i] % 8, i});
+  std::vector<std::pair<int, size_t>> expected = v;
+  std::sort(expected.begin(), expected.end());
+  std::vector<std::pair<int, size_t>> scratch(v.size() + 16);
+  auto by_key = [](const std::pair<int, size_t> &x,
+                   const std::pair<int, size_t> &y) {
+    return x.first < y.first;
+  };
+  stable_quicksort(v.data(), v.size(), scratch.data(), scratch.size(), limit,
+                   {},
+                   compare_blob_three_way<std::pair<int, size_t>,
+                                          decltype(by_key)>());
+  ASSERT_EQ(v, expected);
+}
+
+// Sorts with the ping-pong quicksort, which is otherwise only used for
+// arrays too large for fuzzing.
+template <class T, class BlobComp>
+void ping_pong_sort(std::vector<T> &v, size_t limit, const BlobComp &comp) {
+  std::vector<T> scratch(v.size());
+  size_t small_scratch_length = ping_pong_small_scratch_length(sizeof(T));
+  auto small_scratch_space = DRIFTSORT_ALLOCA(comp, small_scratch_length);
+  ping_pong_quicksort(comp.lift(v.data()), comp.lift(scratch.data()),
+                      v.size(), false, false, limit, nullptr,
+                      comp.lift_alloca(small_scratch_space), comp);
+}
+
+void ping_pong_quick_sort_is_stable(std::vector<int> a, size_t limit,
+                                    bool three_way) {
+  std::vector<std::pair<int, size_t>> v;
+  for (size_t i = 0; i < a.size(); i++)
+    v.push_back({a[i] % 8, i});
+  std::vector<std::pair<int, size_t>> expected = v;
+  std::sort(expected.begin(), expected.end());
+  auto by_key = [](const std::pair<int, size_t> &x,
+                   const std::pair<int, size_t> &y) {
+    return x.first < y.first;
+  };
+  using Element = std::pair<int, size_t>;
+  if (three_way)
+    ping_pong_sort(v, limit,
+                   compare_blob_three_way<Element, decltype(by_key)>());
+  else
+    ping_pong_sort(v, limit, compare_blob<Element, decltype(by_key)>());
+  ASSERT_EQ(v, expected);
+}
+
+void ping_pong_quick_sort_distinct(std::vector<int> a, size_t limit) {
+  std::vector<int> b = a;
+  std::sort(a.begin(), a.end());
+  ping_pong_sort(b, limit, compare_blob<int>());
+  ASSERT_EQ(a, b);
+}
+
 FUZZ_TEST(DriftSortTest, quick_sort_less)
     .WithDomains(fuzztest::Arbitrary<std::vector<int>>(),
                  fuzztest::InRange(0, 64));
@@ -61,3 +128,19 @@ FUZZ_TEST(DriftSortTest, quick_sort_greater)
 FUZZ_TEST(DriftSortTest, quick_sort_is_stable)
     .WithDomains(fuzztest::Arbitrary<std::vector<int>>(),
                  fuzztest::InRange(0, 64));
+
+FUZZ_TEST(DriftSortTest, quick_sort_three_way)
+    .WithDomains(fuzztest::Arbitrary<std::vector<int>>(),
+                 fuzztest::InRange(0, 64));
+
+FUZZ_TEST(DriftSortTest, quick_sort_three_way_is_stable)
+    .WithDomains(fuzztest::Arbitrary<std::vector<int>>(),
+                 fuzztest::InRange(0, 64));
+
+FUZZ_TEST(DriftSortTest, ping_pong_quick_sort_is_stable)
+    .WithDomains(fuzztest::Arbitrary<std::vector<int>>(),
+                 fuzztest::InRange(0, 64), fuzztest::Arbitrary<bool>());
+
+FUZZ_TEST(DriftSortTest, ping_pong_quick_sort_distinct)
+    .WithDomains(fuzztest::Arbitrary<std::vector<int>>(),
+                 fuzztest::InRange(0, 64));
@@ -0,0 +1,91 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/select.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+// Few distinct keys make ties common, so stability is observable.
+constexpr int MODULUS = 64;
+
+void assert_same_prefix(const std::vector<Tagged> &a,
+                        const std::vector<Tagged> &b, size_t k) {
+  for (size_t i = 0; i < k; i++) {
+    ASSERT_EQ(a[i].key, b[i].key);
+    ASSERT_EQ(a[i].id, b[i].id);
+  }
+}
+} // namespace
+
+void partial_sort_is_stable(std::vector<int> a, size_t k) {
+  std::vector<Tagged> v = tag(a, MODULUS);
+  std::vector<Tagged> expected = stable_sorted(v);
+  k = k % (a.size() + 2);
+  partial_sort(v.data(), v.size(), sizeof(Tagged), k, compare_tagged);
+  assert_same_prefix(v, expected, std::min(k, v.size()));
+  // The rest is a permutation of the remaining elements.
+  std::vector<Tagged> rest(v.begin() + std::min(k, v.size()), v.end());
+  std::vector<Tagged> expected_rest(
+      expected.begin() + std::min(k, v.size()), expected.end());
+  auto by_id = [](const Tagged &x, const Tagged &y) { return x.id < y.id; };
+  std::sort(rest.begin(), rest.end(), by_id);
+  std::sort(expected_rest.begin(), expected_rest.end(), by_id);
+  for (size_t i = 0; i < rest.size(); i++)
+    ASSERT_EQ(rest[i].id, expected_rest[i].id);
+}
+
+void nth_element_partitions(std::vector<int> a, size_t k) {
+  if (a.empty())
+    return;
+  std::vector<Tagged> v = tag(a, MODULUS);
+  std::vector<Tagged> expected = stable_sorted(v);
+  k = k % a.size();
+  nth_element(v.data(), v.size(), sizeof(Tagged), k, compare_tagged);
+  ASSERT_EQ(v[k].key, expected[k].key);
+  ASSERT_EQ(v[k].id, expected[k].id);
+  for (size_t i = 0; i < k; i++)
+    ASSERT_LE(v[i].key, v[k].key);
+  for (size_t i = k + 1; i < v.size(); i++)
+    ASSERT_GE(v[i].key, v[k].key);
+}
+
+void top_k_is_stable(std::vector<int> a, size_t k) {
+  std::vector<Tagged> v = tag(a, MODULUS);
+  std::vector<Tagged> copy = v;
+  std::vector<Tagged> expected = stable_sorted(v);
+  k = k % (a.size() + 2);
+  size_t out_length = std::min(k, v.size());
+  std::vector<Tagged> dest(out_length);
+  top_k(v.data(), v.size(), sizeof(Tagged), k, dest.data(), compare_tagged);
+  assert_same_prefix(dest, expected, out_length);
+  assert_same_prefix(v, copy, v.size());
+}
+
+void streaming_partial_sort_is_stable(std::vector<int> a, size_t k) {
+  if (a.size() < 2)
+    return;
+  std::vector<Tagged> v = tag(a, MODULUS);
+  std::vector<Tagged> expected = stable_sorted(v);
+  k = 1 + k % (a.size() - 1);
+  BlobComparator comp{sizeof(Tagged), alignof(Tagged), compare_tagged};
+  std::vector<Tagged> scratch(
+      partial::streaming_scratch_length(k, sizeof(Tagged)));
+  partial::streaming_partial_sort(v.data(), v.size(), k, scratch.data(),
+                                  scratch.size(), comp);
+  assert_same_prefix(v, expected, k);
+}
+
+FUZZ_TEST(DriftSortTest, partial_sort_is_stable);
+FUZZ_TEST(DriftSortTest, nth_element_partitions);
+FUZZ_TEST(DriftSortTest, top_k_is_stable);
+FUZZ_TEST(DriftSortTest, streaming_partial_sort_is_stable);
@@ -0,0 +1,137 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/setops.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <cstdint>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+int compare_tagged_r(const void *a, const void *b, void *) {
+  return compare_tagged(a, b);
+}
+
+std::vector<Tagged> sorted_tagged(const std::vector<int> &keys, int modulus,
+                                  size_t first_id) {
+  std::vector<Tagged> v;
+  for (size_t i = 0; i < keys.size(); i++)
+    v.push_back({keys[i] % modulus, first_id + i});
+  std::stable_sort(v.begin(), v.end(), key_less);
+  return v;
+}
+
+using CFunction = size_t (*)(const void *, size_t, const void *, size_t,
+                             size_t, void *, driftsort_compar_fn_t, void *);
+
+// Runs one operation through the C API, with a `ThreeWay` comparator, and
+// through C++ with a plain one, into buffers of `capacity` elements, and
+// compares both with `expected`.
+template <typename Operation>
+void check(const std::vector<Tagged> &a, const std::vector<Tagged> &b,
+           size_t capacity, const std::vector<Tagged> &expected,
+           Operation operation, CFunction c_function) {
+  std::vector<Tagged> dest(capacity);
+  size_t count = operation(a.data(), a.size(), b.data(), b.size(),
+                           sizeof(Tagged), dest.data(), compare_tagged);
+  dest.resize(count);
+  ASSERT_EQ(dest, expected);
+
+  std::vector<Tagged> c_dest(capacity);
+  count = c_function(a.data(), a.size(), b.data(), b.size(), sizeof(Tagged),
+                     c_dest.data(), compare_tagged_r, nullptr);
+  c_dest.resize(count);
+  ASSERT_EQ(c_dest, expected);
+}
+} // namespace
+
+// The ids tell which array and which of equal elements each output came
+// from, so this checks that equal elements are picked like `std::` does.
+void set_operations_match_std(std::vector<int> a_keys,
+                              std::vector<int> b_keys, uint8_t modulus) {
+  int m = modulus == 0 ? 1 << 20 : modulus;
+  std::vector<Tagged> a = sorted_tagged(a_keys, m, 0);
+  std::vector<Tagged> b = sorted_tagged(b_keys, m, a.size());
+  std::vector<Tagged> expected;
+
+  std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                 std::back_inserter(expected), key_less);
+  check(
+      a, b, a.size() + b.size(), expected,
+      [](auto... args) { return set_union(args...); }, driftsort_set_union_r);
+
+  expected.clear();
+  std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                        std::back_inserter(expected), key_less);
+  check(
+      a, b, std::min(a.size(), b.size()), expected,
+      [](auto... args) { return set_intersection(args...); },
+      driftsort_set_intersection_r);
+
+  expected.clear();
+  std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                      std::back_inserter(expected), key_less);
+  check(
+      a, b, a.size(), expected,
+      [](auto... args) { return set_difference(args...); },
+      driftsort_set_difference_r);
+
+  expected.clear();
+  std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(),
+                                std::back_inserter(expected), key_less);
+  check(
+      a, b, a.size() + b.size(), expected,
+      [](auto... args) { return set_symmetric_difference(args...); },
+      driftsort_set_symmetric_difference_r);
+}
+
+void merge_join_matches_equal_ranges(std::vector<int> a_keys,
+                                     std::vector<int> b_keys,
+                                     uint8_t modulus) {
+  int m = modulus == 0 ? 1 << 20 : modulus;
+  std::vector<Tagged> a = sorted_tagged(a_keys, m, 0);
+  std::vector<Tagged> b = sorted_tagged(b_keys, m, 0);
+  std::vector<JoinRange> expected;
+  for (size_t i = 0; i < a.size();) {
+    auto a_group = std::equal_range(a.begin(), a.end(), a[i], key_less);
+    auto b_group = std::equal_range(b.begin(), b.end(), a[i], key_less);
+    size_t a_end = a_group.second - a.begin();
+    if (b_group.first != b_group.second)
+      expected.push_back({i, a_end, size_t(b_group.first - b.begin()),
+                          size_t(b_group.second - b.begin())});
+    i = a_end;
+  }
+
+  std::vector<JoinRange> ranges(std::min(a.size(), b.size()));
+  ranges.resize(merge_join(a.data(), a.size(), b.data(), b.size(),
+                           sizeof(Tagged), ranges.data(), compare_tagged));
+  std::vector<driftsort_join_range> c_ranges(std::min(a.size(), b.size()));
+  c_ranges.resize(driftsort_merge_join_r(a.data(), a.size(), b.data(),
+                                         b.size(), sizeof(Tagged),
+                                         c_ranges.data(), compare_tagged_r,
+                                         nullptr));
+  ASSERT_EQ(ranges.size(), expected.size());
+  ASSERT_EQ(c_ranges.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(ranges[i].a_start, expected[i].a_start);
+    ASSERT_EQ(ranges[i].a_end, expected[i].a_end);
+    ASSERT_EQ(ranges[i].b_start, expected[i].b_start);
+    ASSERT_EQ(ranges[i].b_end, expected[i].b_end);
+    ASSERT_EQ(c_ranges[i].a_start, expected[i].a_start);
+    ASSERT_EQ(c_ranges[i].a_end, expected[i].a_end);
+    ASSERT_EQ(c_ranges[i].b_start, expected[i].b_start);
+    ASSERT_EQ(c_ranges[i].b_end, expected[i].b_end);
+  }
+}
+
+FUZZ_TEST(DriftSortTest, set_operations_match_std);
+FUZZ_TEST(DriftSortTest, merge_join_matches_equal_ranges);
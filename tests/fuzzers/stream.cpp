@@ -0,0 +1,57 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/stream.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace driftsort;
+
+void stream_sort_is_stable(std::vector<std::vector<int>> chunks,
+                           size_t finish_at) {
+  StreamSorter sorter(sizeof(Tagged), compare_tagged);
+  std::vector<Tagged> pushed;
+  finish_at = finish_at % (chunks.size() + 1);
+  for (size_t c = 0; c < chunks.size(); c++) {
+    std::vector<Tagged> chunk;
+    for (int x : chunks[c])
+      chunk.push_back({x % 16, pushed.size() + chunk.size()});
+    ASSERT_TRUE(sorter.push(chunk.data(), chunk.size()));
+    pushed.insert(pushed.end(), chunk.begin(), chunk.end());
+    ASSERT_EQ(sorter.size(), pushed.size());
+
+    // The sorted prefix holds the elements pushed first, ordered by key and
+    // then by push order.
+    auto data = static_cast<const Tagged *>(sorter.data());
+    size_t prefix = sorter.sorted_prefix();
+    bool prefix_ok = true;
+    for (size_t i = 0; i < prefix; i++) {
+      prefix_ok &= data[i].id < prefix;
+      if (i > 0)
+        prefix_ok &= data[i - 1].key < data[i].key ||
+                     (data[i - 1].key == data[i].key &&
+                      data[i - 1].id < data[i].id);
+    }
+    ASSERT_TRUE(prefix_ok);
+
+    if (c == finish_at) {
+      sorter.finish();
+      ASSERT_EQ(sorter.sorted_prefix(), pushed.size());
+    }
+  }
+
+  std::stable_sort(pushed.begin(), pushed.end(), key_less);
+  auto data = static_cast<const Tagged *>(sorter.finish());
+  ASSERT_EQ(sorter.sorted_prefix(), pushed.size());
+  for (size_t i = 0; i < pushed.size(); i++)
+    ASSERT_EQ(data[i].id, pushed[i].id);
+}
+
+FUZZ_TEST(DriftSortTest, stream_sort_is_stable);
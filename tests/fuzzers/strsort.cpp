@@ -0,0 +1,61 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/strsort.h"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <cstring>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace driftsort;
+
+void sort_cstrings(std::vector<std::string> a) {
+  for (auto &s : a)
+    std::replace(s.begin(), s.end(), '\0', 'a');
+  std::vector<const char *> b;
+  for (auto &s : a)
+    b.push_back(s.c_str());
+  std::vector<const char *> c = b;
+  std::stable_sort(b.begin(), b.end(), [](const char *x, const char *y) {
+    return std::strcmp(x, y) < 0;
+  });
+  sort_strings(c.data(), c.size());
+  ASSERT_EQ(b, c);
+}
+
+void sort_string_refs(std::vector<std::string> a) {
+  std::vector<StringRef> b;
+  for (auto &s : a)
+    b.push_back({s.data(), s.size()});
+  std::vector<StringRef> c = b;
+  std::stable_sort(b.begin(), b.end(), [](StringRef x, StringRef y) {
+    return std::string_view(x.data, x.length) <
+           std::string_view(y.data, y.length);
+  });
+  sort_strings(c.data(), c.size());
+  for (size_t i = 0; i < b.size(); i++) {
+    ASSERT_EQ(b[i].data, c[i].data);
+    ASSERT_EQ(b[i].length, c[i].length);
+  }
+}
+
+void sort_cstrings_shared_prefix(std::vector<std::string> a,
+                                 std::string prefix) {
+  std::replace(prefix.begin(), prefix.end(), '\0', '/');
+  for (auto &s : a) {
+    std::replace(s.begin(), s.end(), '\0', 'a');
+    s.insert(0, prefix);
+  }
+  sort_cstrings(std::move(a));
+}
+
+FUZZ_TEST(DriftSortTest, sort_cstrings);
+FUZZ_TEST(DriftSortTest, sort_string_refs);
+FUZZ_TEST(DriftSortTest, sort_cstrings_shared_prefix);
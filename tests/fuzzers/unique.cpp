@@ -0,0 +1,65 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/unique.h"
+#include "../utils.hpp"
+#include "fuzztest/fuzztest.h"
+#include <algorithm>
+#include <fuzztest/fuzztest.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace driftsort;
+
+void sort_unique_keeps_first(std::vector<int> a, bool few_keys) {
+  std::vector<Tagged> v = tag(a, few_keys ? 16 : 1 << 20);
+  std::vector<Tagged> expected = stable_sorted(v);
+  auto last = std::unique(expected.begin(), expected.end(),
+                          [](const Tagged &x, const Tagged &y) {
+                            return x.key == y.key;
+                          });
+  expected.erase(last, expected.end());
+  size_t n = sort_unique(v.data(), v.size(), sizeof(Tagged), compare_tagged);
+  ASSERT_EQ(n, expected.size());
+  bool same = true;
+  for (size_t i = 0; i < n; i++)
+    same &= v[i].key == expected[i].key && v[i].id == expected[i].id;
+  ASSERT_TRUE(same);
+}
+
+void sort_group_reduces_groups(std::vector<int> a, bool few_keys) {
+  std::vector<Tagged> v = tag(a, few_keys ? 16 : 1 << 20);
+  std::vector<Tagged> sorted = stable_sorted(v);
+  // Every group is reduced to its first element with `id` replaced by the
+  // sum of the ids in the group.
+  std::vector<Tagged> expected;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    if (i == 0 || sorted[i - 1].key != sorted[i].key)
+      expected.push_back({sorted[i].key, 0});
+    expected.back().id += sorted[i].id;
+  }
+  bool in_order = true;
+  size_t n = sort_group(
+      v.data(), v.size(), sizeof(Tagged),
+      [&](void *group, size_t count) {
+        auto elements = static_cast<Tagged *>(group);
+        for (size_t i = 1; i < count; i++) {
+          in_order &= elements[i - 1].id < elements[i].id &&
+                      elements[i].key == elements[0].key;
+          elements[0].id += elements[i].id;
+        }
+      },
+      compare_tagged);
+  ASSERT_TRUE(in_order);
+  ASSERT_EQ(n, expected.size());
+  bool same = true;
+  for (size_t i = 0; i < n; i++)
+    same &= v[i].key == expected[i].key && v[i].id == expected[i].id;
+  ASSERT_TRUE(same);
+}
+
+FUZZ_TEST(DriftSortTest, sort_unique_keeps_first);
+FUZZ_TEST(DriftSortTest, sort_group_reduces_groups);
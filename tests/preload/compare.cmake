@@ -0,0 +1,36 @@
+# Runs PROGRAM on INPUTS with glibc's qsort and with PRELOAD, and checks that
+# the preload replaced qsort or qsort_r and that the outputs are the same.
+# Invoked by ctest with cmake -P.
+
+foreach(mode qsort qsort_r)
+  if (mode STREQUAL "qsort_r")
+    set(flags -r)
+  else()
+    set(flags)
+  endif()
+  execute_process(COMMAND ${PROGRAM} ${flags} ${INPUTS}
+                  OUTPUT_FILE ${OUTPUT_DIR}/${mode}.glibc
+                  RESULT_VARIABLE result)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${PROGRAM} ${flags} failed: ${result}")
+  endif()
+  execute_process(COMMAND ${CMAKE_COMMAND} -E env LD_PRELOAD=${PRELOAD}
+                          LD_DEBUG=bindings ${PROGRAM} ${flags} ${INPUTS}
+                  OUTPUT_FILE ${OUTPUT_DIR}/${mode}.preload
+                  ERROR_VARIABLE bindings
+                  RESULT_VARIABLE result)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${PROGRAM} ${flags} failed under the preload: "
+                        "${result}")
+  endif()
+  if (NOT bindings MATCHES "libdriftsort-preload\\.so[^\n]*`${mode}'")
+    message(FATAL_ERROR "${mode} was not bound to ${PRELOAD}")
+  endif()
+  execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                          ${OUTPUT_DIR}/${mode}.glibc
+                          ${OUTPUT_DIR}/${mode}.preload
+                  RESULT_VARIABLE result)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${mode} output differs from glibc")
+  endif()
+endforeach()
@@ -0,0 +1,101 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+/* Prints the lines of its input files in byte order, like sort(1), sorted
+ * with qsort, or in reverse order with qsort_r given -r. It knows nothing
+ * of driftsort; the preload test compares its output with and without
+ * libdriftsort-preload.so. */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct line {
+  const char *data;
+  size_t length;
+};
+
+static int compare_lines(const void *a, const void *b) {
+  const struct line *x = a;
+  const struct line *y = b;
+  size_t n = x->length < y->length ? x->length : y->length;
+  int c = memcmp(x->data, y->data, n);
+  if (c != 0)
+    return c;
+  return (x->length > y->length) - (x->length < y->length);
+}
+
+static int compare_lines_r(const void *a, const void *b, void *direction) {
+  return *(const int *)direction * compare_lines(a, b);
+}
+
+/* Appends the contents of `path` to `*text`. */
+static int read_file(const char *path, char **text, size_t *length) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+    return -1;
+  size_t capacity = *length;
+  size_t n;
+  do {
+    if (capacity - *length < 65536) {
+      capacity = capacity * 2 + 65536;
+      char *grown = realloc(*text, capacity);
+      if (grown == NULL) {
+        fclose(file);
+        return -1;
+      }
+      *text = grown;
+    }
+    n = fread(*text + *length, 1, capacity - *length, file);
+    *length += n;
+  } while (n != 0);
+  int failed = ferror(file);
+  fclose(file);
+  return failed ? -1 : 0;
+}
+
+int main(int argc, char **argv) {
+  int reverse = argc > 1 && strcmp(argv[1], "-r") == 0;
+  char *text = NULL;
+  size_t length = 0;
+  for (int i = 1 + reverse; i < argc; i++) {
+    if (read_file(argv[i], &text, &length) != 0) {
+      perror(argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < length; i++)
+    count += text[i] == '\n';
+  struct line *lines = malloc((count + 1) * sizeof(struct line));
+  if (lines == NULL)
+    return EXIT_FAILURE;
+  size_t nlines = 0;
+  for (size_t start = 0; start < length;) {
+    const char *end = memchr(text + start, '\n', length - start);
+    size_t stop = end != NULL ? (size_t)(end - text) : length;
+    lines[nlines].data = text + start;
+    lines[nlines].length = stop - start;
+    nlines++;
+    start = stop + 1;
+  }
+
+  if (reverse) {
+    int direction = -1;
+    qsort_r(lines, nlines, sizeof(struct line), compare_lines_r, &direction);
+  } else {
+    qsort(lines, nlines, sizeof(struct line), compare_lines);
+  }
+  for (size_t i = 0; i < nlines; i++) {
+    fwrite(lines[i].data, 1, lines[i].length, stdout);
+    putchar('\n');
+  }
+  free(lines);
+  free(text);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/driftsort.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+struct alignas(4096) Page {
+  unsigned key;
+  unsigned id;
+};
+
+int compare_pages(const void *a, const void *b) {
+  unsigned x = static_cast<const Page *>(a)->key;
+  unsigned y = static_cast<const Page *>(b)->key;
+  return (x > y) - (x < y);
+}
+} // namespace
+
+TEST(DriftSortUnitTests, qsort_aligned_page_aligned) {
+  for (size_t length : {size_t{15}, size_t{100}, size_t{3000}}) {
+    std::vector<Page> v(length);
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < length; i++)
+      v[i] = {static_cast<unsigned>(rng() % 16), static_cast<unsigned>(i)};
+    ASSERT_TRUE(qsort_aligned(v.data(), length, sizeof(Page), alignof(Page),
+                              compare_pages));
+    bool sorted = true;
+    for (size_t i = 1; i < length; i++)
+      sorted &= v[i - 1].key < v[i].key ||
+                (v[i - 1].key == v[i].key && v[i - 1].id < v[i].id);
+    ASSERT_TRUE(sorted);
+  }
+}
+
+TEST(DriftSortUnitTests, qsort_aligned_rejects_invalid_alignment) {
+  std::vector<Page> v(2);
+  ASSERT_FALSE(qsort_aligned(v.data(), 2, sizeof(Page), 3000, compare_pages));
+  ASSERT_FALSE(qsort_aligned(v.data(), 2, sizeof(Page), 8192, compare_pages));
+  ASSERT_FALSE(qsort_aligned(reinterpret_cast<std::byte *>(v.data()) + 64, 1,
+                             sizeof(Page), 4096, compare_pages));
+  ASSERT_FALSE(qsort_aligned(v.data(), 2, 24, 16, compare_pages));
+}
@@ -0,0 +1,135 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/async.h"
+#include "driftsort/capi.h"
+#include <algorithm>
+#include <functional>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+
+int compare_ints_r(const void *a, const void *b, void *) {
+  return compare_ints(a, b);
+}
+
+std::vector<int> shuffled(size_t length) {
+  std::vector<int> v(length);
+  std::iota(v.begin(), v.end(), 0);
+  std::shuffle(v.begin(), v.end(), std::mt19937_64(42));
+  return v;
+}
+
+bool is_permutation_of_iota(std::vector<int> v) {
+  std::sort(v.begin(), v.end());
+  for (size_t i = 0; i < v.size(); i++)
+    if (v[i] != static_cast<int>(i))
+      return false;
+  return true;
+}
+} // namespace
+
+TEST(DriftSortUnitTests, async_sort_reports_progress) {
+  // Large enough for quicksort to partition back and forth with scratch.
+  std::vector<int> v = shuffled(1 << 20);
+  SortControl control;
+  std::vector<double> seen;
+  size_t count = 0;
+  auto compare = [&](const void *a, const void *b) {
+    if (++count % 10000 == 0)
+      seen.push_back(control.progress());
+    return compare_ints(a, b);
+  };
+  std::future<bool> sorted =
+      sort_async(v.data(), v.size(), sizeof(int), three_way(compare), control);
+  ASSERT_TRUE(sorted.get());
+  ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+  EXPECT_EQ(control.progress(), 1.0);
+  ASSERT_FALSE(seen.empty());
+  EXPECT_TRUE(std::is_sorted(seen.begin(), seen.end()));
+  // shuffled elements take about as many passes as the estimate expects
+  EXPECT_GT(seen.back(), 0.8);
+  EXPECT_LT(seen.back(), 1.0);
+}
+
+TEST(DriftSortUnitTests, cancelled_sort_keeps_elements) {
+  for (size_t length : {size_t{1000}, size_t{1} << 20}) {
+    for (size_t cancel_at : {size_t{1}, size_t{5000}, size_t{300000},
+                             size_t{3000000}}) {
+      std::vector<int> v = shuffled(length);
+      SortControl control;
+      size_t count = 0;
+      auto compare = [&](const void *a, const void *b) {
+        if (++count == cancel_at)
+          control.cancel();
+        return compare_ints(a, b);
+      };
+      bool sorted = sort_cancellable(v.data(), v.size(), sizeof(int),
+                                     three_way(compare), control);
+      EXPECT_EQ(sorted, std::is_sorted(v.begin(), v.end()));
+      EXPECT_EQ(sorted, cancel_at > count) << length << " " << cancel_at;
+      EXPECT_TRUE(is_permutation_of_iota(v));
+    }
+  }
+}
+
+TEST(DriftSortUnitTests, async_sort_on_executor) {
+  std::vector<int> v = shuffled(10000);
+  std::vector<std::function<void()>> queue;
+  SortControl control;
+  std::future<bool> sorted = sort_async(
+      [&](std::function<void()> task) { queue.push_back(std::move(task)); },
+      v.data(), v.size(), sizeof(int), three_way(compare_ints), control);
+  ASSERT_EQ(queue.size(), 1u);
+  EXPECT_EQ(control.progress(), 0.0);
+  queue.front()();
+  ASSERT_TRUE(sorted.get());
+  ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+}
+
+TEST(DriftSortUnitTests, async_capi_sort_cancel_and_timeout) {
+  std::vector<int> v = shuffled(1 << 20);
+  driftsort_task *task = driftsort_sort_async_r(
+      v.data(), v.size(), sizeof(int), 0, compare_ints_r, nullptr);
+  ASSERT_NE(task, nullptr);
+  double progress = -1.0;
+  int status = driftsort_task_poll(task, &progress);
+  EXPECT_GE(progress, 0.0);
+  EXPECT_TRUE(status == 1 || status == 0);
+  EXPECT_EQ(driftsort_task_wait(task), 0);
+  EXPECT_EQ(driftsort_task_poll(task, &progress), 0);
+  EXPECT_EQ(progress, 1.0);
+  driftsort_task_free(task);
+  ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+
+  // A nanosecond has passed by the first look at the clock.
+  v = shuffled(1 << 20);
+  task = driftsort_sort_async_r(v.data(), v.size(), sizeof(int), 1,
+                                compare_ints_r, nullptr);
+  ASSERT_NE(task, nullptr);
+  EXPECT_EQ(driftsort_task_wait(task), -1);
+  driftsort_task_free(task);
+  EXPECT_TRUE(is_permutation_of_iota(v));
+
+  v = shuffled(1 << 20);
+  task = driftsort_sort_async_r(v.data(), v.size(), sizeof(int), 0,
+                                compare_ints_r, nullptr);
+  ASSERT_NE(task, nullptr);
+  driftsort_task_cancel(task);
+  int result = driftsort_task_wait(task);
+  EXPECT_EQ(result == 0, std::is_sorted(v.begin(), v.end()));
+  driftsort_task_free(task);
+  EXPECT_TRUE(is_permutation_of_iota(v));
+}
@@ -0,0 +1,63 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/batch.h"
+#include "driftsort/capi.h"
+#include <algorithm>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+struct Tagged {
+  int key;
+  size_t id;
+};
+
+std::atomic<size_t> threads_seen{0};
+
+int compare_counting_threads(const void *a, const void *b, void *) {
+  thread_local bool seen = false;
+  if (!seen) {
+    seen = true;
+    threads_seen++;
+  }
+  int x = static_cast<const Tagged *>(a)->key;
+  int y = static_cast<const Tagged *>(b)->key;
+  return (x > y) - (x < y);
+}
+} // namespace
+
+TEST(DriftSortUnitTests, sort_csr_splits_across_workers) {
+  // Segments of 5 to 64 elements with few distinct keys, so that the ids
+  // show whether each one was sorted stably.
+  std::default_random_engine g(42);
+  std::uniform_int_distribution<size_t> length_dist(5, 64);
+  std::uniform_int_distribution<int> key_dist(0, 15);
+  size_t length = 4 * batch::MIN_WORKER_ELEMENTS;
+  std::vector<Tagged> data(length);
+  for (size_t i = 0; i < length; i++)
+    data[i] = {key_dist(g), i};
+  std::vector<size_t> offsets{0};
+  while (offsets.back() < length)
+    offsets.push_back(std::min(length, offsets.back() + length_dist(g)));
+
+  std::vector<Tagged> expected = data;
+  for (size_t i = 0; i + 1 < offsets.size(); i++)
+    std::stable_sort(expected.begin() + offsets[i],
+                     expected.begin() + offsets[i + 1],
+                     [](const Tagged &x, const Tagged &y) {
+                       return x.key < y.key;
+                     });
+
+  driftsort_sort_csr_r(data.data(), offsets.data(), offsets.size() - 1,
+                       sizeof(Tagged), 4, compare_counting_threads, nullptr);
+  for (size_t i = 0; i < length; i++)
+    ASSERT_EQ(data[i].id, expected[i].id);
+  EXPECT_EQ(threads_seen.load(), 4u);
+}
@@ -0,0 +1,68 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/columns.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+int compare_uints(const void *a, const void *b) {
+  uint32_t x = *static_cast<const uint32_t *>(a);
+  uint32_t y = *static_cast<const uint32_t *>(b);
+  return (x > y) - (x < y);
+}
+} // namespace
+
+TEST(DriftSortUnitTests, sort_columns_moves_rows_together) {
+  constexpr size_t length = 100000;
+  std::mt19937 rng(42);
+  std::vector<uint32_t> keys(length);
+  for (uint32_t &k : keys)
+    k = rng() % 1000;
+  std::vector<size_t> order(length);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t x, size_t y) { return keys[x] < keys[y]; });
+
+  const size_t sizes[] = {1, 3, 8, 24};
+  std::vector<std::vector<uint8_t>> data;
+  std::vector<Column> payloads;
+  for (size_t size : sizes) {
+    std::vector<uint8_t> column(length * size);
+    for (size_t i = 0; i < column.size(); i++)
+      column[i] = static_cast<uint8_t>(rng());
+    data.push_back(column);
+  }
+  std::vector<std::vector<uint8_t>> unsorted = data;
+  for (size_t c = 0; c < data.size(); c++)
+    payloads.push_back({data[c].data(), sizes[c]});
+  std::vector<uint32_t> key_path = keys;
+  std::vector<std::vector<uint8_t>> key_data = unsorted;
+  std::vector<Column> key_payloads;
+  for (size_t c = 0; c < key_data.size(); c++)
+    key_payloads.push_back({key_data[c].data(), sizes[c]});
+
+  ASSERT_TRUE(sort_columns(keys.data(), length, sizeof(uint32_t),
+                           payloads.data(), payloads.size(), compare_uints));
+  KeySpec spec{0, sizeof(uint32_t), KeyType::unsigned_int, false};
+  ASSERT_TRUE(sort_columns_key(key_path.data(), length, sizeof(uint32_t), spec,
+                               key_payloads.data(), key_payloads.size()));
+  ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  ASSERT_EQ(keys, key_path);
+  ASSERT_EQ(data, key_data);
+  for (size_t c = 0; c < data.size(); c++)
+    for (size_t i = 0; i < length; i++)
+      ASSERT_EQ(std::memcmp(&data[c][i * sizes[c]],
+                            &unsorted[c][order[i] * sizes[c]], sizes[c]),
+                0);
+}
@@ -0,0 +1,135 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if __has_include(<unistd.h>)
+#include "driftsort/external.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace driftsort;
+
+namespace {
+// A 4-byte signed key at offset 4 and the original index at offset 8.
+using Record = std::array<unsigned char, 16>;
+
+int32_t key_of(const Record &r) {
+  int32_t key;
+  std::memcpy(&key, r.data() + 4, sizeof(key));
+  return key;
+}
+
+std::vector<Record> make_records(size_t count, int32_t modulus) {
+  std::mt19937 rng(static_cast<unsigned>(count));
+  std::vector<Record> records(count);
+  for (size_t i = 0; i < count; i++) {
+    int32_t key = static_cast<int32_t>(rng() % modulus) - modulus / 2;
+    uint64_t index = i;
+    std::memset(records[i].data(), 0xab, 4);
+    std::memcpy(records[i].data() + 4, &key, sizeof(key));
+    std::memcpy(records[i].data() + 8, &index, sizeof(index));
+  }
+  return records;
+}
+
+class TempFile {
+  std::string path_;
+
+public:
+  TempFile() {
+    char path[] = "/tmp/driftsort-test-XXXXXX";
+    int fd = ::mkstemp(path);
+    EXPECT_GE(fd, 0);
+    ::close(fd);
+    path_ = path;
+  }
+  ~TempFile() { ::unlink(path_.c_str()); }
+  const char *path() const { return path_.c_str(); }
+
+  void write(const std::vector<Record> &records) const {
+    FILE *f = std::fopen(path(), "wb");
+    ASSERT_NE(f, nullptr);
+    std::fwrite(records.data(), sizeof(Record), records.size(), f);
+    std::fclose(f);
+  }
+  std::vector<Record> read() const {
+    std::vector<Record> records;
+    FILE *f = std::fopen(path(), "rb");
+    Record r;
+    while (f != nullptr && std::fread(r.data(), sizeof(Record), 1, f) == 1)
+      records.push_back(r);
+    if (f != nullptr)
+      std::fclose(f);
+    return records;
+  }
+};
+
+ExternalSortOptions options(size_t memory_budget, bool descending = false) {
+  return {sizeof(Record), {4, 4, KeyType::signed_int, descending},
+          memory_budget, "/tmp"};
+}
+
+std::vector<Record> expected(std::vector<Record> records, bool descending) {
+  std::stable_sort(records.begin(), records.end(),
+                   [descending](const Record &a, const Record &b) {
+                     return descending ? key_of(a) > key_of(b)
+                                       : key_of(a) < key_of(b);
+                   });
+  return records;
+}
+
+void check_sort(size_t count, int32_t modulus, size_t memory_budget,
+                bool in_place, bool descending = false) {
+  std::vector<Record> records = make_records(count, modulus);
+  TempFile input, output;
+  input.write(records);
+  int err = sort_file(input.path(), in_place ? nullptr : output.path(),
+                      options(memory_budget, descending));
+  ASSERT_EQ(err, 0) << std::strerror(err);
+  std::vector<Record> sorted = in_place ? input.read() : output.read();
+  EXPECT_TRUE(sorted == expected(records, descending));
+  if (!in_place) {
+    EXPECT_TRUE(input.read() == records);
+  }
+}
+} // namespace
+
+TEST(DriftSortUnitTests, sort_file_in_memory) {
+  check_sort(10000, 1000, size_t{1} << 20, false);
+  check_sort(10000, 1000, size_t{1} << 20, true, true);
+  check_sort(0, 1, size_t{1} << 20, true);
+}
+
+TEST(DriftSortUnitTests, sort_file_external) {
+  // 1536 records per run and many equal keys across runs.
+  check_sort(100000, 50, 36 << 10, false);
+  check_sort(100000, 50, 36 << 10, true, true);
+}
+
+TEST(DriftSortUnitTests, sort_file_multiple_merge_passes) {
+  // Runs of 42 records and a fan-in of two.
+  check_sort(20000, 7, 1 << 10, false);
+}
+
+TEST(DriftSortUnitTests, sort_file_rejects_bad_input) {
+  TempFile input;
+  input.write(make_records(3, 10));
+  ExternalSortOptions bad_key = options(1 << 20);
+  bad_key.key.offset = 14;
+  EXPECT_EQ(sort_file(input.path(), nullptr, bad_key), EINVAL);
+  ExternalSortOptions bad_size = options(1 << 20);
+  bad_size.record_size = 32;
+  EXPECT_EQ(sort_file(input.path(), nullptr, bad_size), EINVAL);
+  EXPECT_EQ(sort_file("/nonexistent/driftsort", nullptr, options(1 << 20)),
+            ENOENT);
+}
+#endif
@@ -0,0 +1,52 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/driftsort.h"
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+} // namespace
+
+TEST(DriftSortUnitTests, fewest_compares_near_lower_bound) {
+  for (size_t length : {size_t{20}, size_t{32}, size_t{1000}, size_t{50000}}) {
+    std::vector<int> v(length);
+    std::iota(v.begin(), v.end(), 0);
+    std::shuffle(v.begin(), v.end(), std::mt19937_64(42));
+    size_t count = 0;
+    qsort_r(v.data(), length, sizeof(int),
+            fewest_compares(compare_ints, count));
+    ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+    // log2(length!), which no comparison sort beats on average
+    double lower_bound = std::lgamma(length + 1.0) / std::log(2.0);
+    EXPECT_LE(count, lower_bound * 1.05) << "length " << length;
+  }
+}
+
+TEST(DriftSortUnitTests, fewest_compares_on_runs) {
+  std::vector<int> v(10000);
+  std::iota(v.begin(), v.end(), 0);
+  size_t count = 0;
+  qsort_r(v.data(), v.size(), sizeof(int),
+          fewest_compares(compare_ints, count));
+  EXPECT_EQ(count, v.size() - 1);
+  std::reverse(v.begin(), v.end());
+  count = 0;
+  qsort_r(v.data(), v.size(), sizeof(int),
+          fewest_compares(compare_ints, count));
+  EXPECT_EQ(count, v.size() - 1);
+  ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+}
@@ -0,0 +1,90 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/hints.h"
+#include <algorithm>
+#include <bit>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+
+int compare_ints_r(const void *a, const void *b, void *) {
+  return compare_ints(a, b);
+}
+} // namespace
+
+TEST(DriftSortUnitTests, sort_hinted_compares_only_new_elements) {
+  constexpr size_t length = 1 << 20;
+  std::mt19937 rng(42);
+  std::vector<int> v(length);
+  for (int &x : v)
+    x = static_cast<int>(rng());
+  for (size_t k : {size_t{1}, size_t{100}, size_t{10000}}) {
+    // k elements appended to a sorted array
+    std::sort(v.begin(), v.end() - k);
+    size_t count = 0;
+    auto compare = [&count](const void *a, const void *b) {
+      count++;
+      return compare_ints(a, b);
+    };
+    SortHints appended;
+    appended.sorted_prefix = length - k;
+    ASSERT_TRUE(
+        sort_hinted(v.data(), length, sizeof(int), appended, compare));
+    ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+    // sorting the k elements, and two galloping searches each
+    size_t bound = k * std::bit_width(k) + 2 * k * std::bit_width(length);
+    EXPECT_LE(count, bound) << "appended " << k;
+
+    // k elements modified in place
+    std::vector<size_t> dirty(k);
+    for (size_t &d : dirty) {
+      d = rng() % length;
+      v[d] = static_cast<int>(rng());
+    }
+    SortHints modified;
+    modified.sorted_prefix = length;
+    modified.dirty = dirty.data();
+    modified.dirty_count = k;
+    count = 0;
+    ASSERT_TRUE(
+        sort_hinted(v.data(), length, sizeof(int), modified, compare));
+    ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+    EXPECT_LE(count, bound) << "modified " << k;
+  }
+}
+
+TEST(DriftSortUnitTests, sort_hinted_merges_known_runs) {
+  std::vector<int> v(100000);
+  std::iota(v.begin(), v.end(), 0);
+  std::shuffle(v.begin(), v.end(), std::mt19937(7));
+  std::vector<size_t> run_ends;
+  for (size_t end = 1000; end <= v.size(); end += 1000) {
+    std::sort(v.begin() + (end - 1000), v.begin() + end);
+    run_ends.push_back(end);
+  }
+  driftsort_hints hints{0, run_ends.data(), run_ends.size(), nullptr, 0};
+  ASSERT_EQ(driftsort_sort_hinted_r(v.data(), v.size(), sizeof(int), &hints,
+                                    compare_ints_r, nullptr),
+            0);
+  ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+
+  // The last run must end at the end of the array.
+  run_ends.back()--;
+  ASSERT_EQ(driftsort_sort_hinted_r(v.data(), v.size(), sizeof(int), &hints,
+                                    compare_ints_r, nullptr),
+            -1);
+}
@@ -0,0 +1,28 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/hugepage.h"
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+using namespace driftsort;
+
+TEST(DriftSortUnitTests, huge_page_allocation) {
+  for (size_t bytes : {size_t{1}, hugepage::HUGE_PAGE_BYTES,
+                       3 * hugepage::HUGE_PAGE_BYTES + 12345}) {
+    void *data = hugepage::allocate(bytes);
+    if (!DRIFTSORT_HAS_HUGE_PAGES) {
+      ASSERT_EQ(data, nullptr);
+      continue;
+    }
+    ASSERT_NE(data, nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(data) % hugepage::HUGE_PAGE_BYTES,
+              0u);
+    std::memset(data, 0xab, bytes);
+    ASSERT_EQ(static_cast<unsigned char *>(data)[bytes - 1], 0xab);
+    hugepage::release(data, bytes);
+  }
+}
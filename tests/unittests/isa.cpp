@@ -0,0 +1,99 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/isa.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+struct Pair {
+  uint32_t key;
+  uint32_t index;
+};
+
+int compare_keys(const void *a, const void *b) {
+  uint32_t x = static_cast<const Pair *>(a)->key;
+  uint32_t y = static_cast<const Pair *>(b)->key;
+  return (x > y) - (x < y);
+}
+
+int compare_keys_r(const void *a, const void *b, void *calls) {
+  ++*static_cast<size_t *>(calls);
+  return compare_keys(a, b);
+}
+
+std::vector<Pair> pairs(size_t length, uint32_t distinct) {
+  std::mt19937 rng(7);
+  std::vector<Pair> v(length);
+  for (size_t i = 0; i < length; i++)
+    v[i] = {static_cast<uint32_t>(rng() % distinct), static_cast<uint32_t>(i)};
+  return v;
+}
+
+void expect_stably_sorted(const std::vector<Pair> &v) {
+  for (size_t i = 1; i < v.size(); i++) {
+    ASSERT_LE(v[i - 1].key, v[i].key);
+    if (v[i - 1].key == v[i].key) {
+      ASSERT_LT(v[i - 1].index, v[i].index);
+    }
+  }
+}
+} // namespace
+
+TEST(DriftSortUnitTests, isa_names) {
+  for (size_t i = 0; i < isa::LEVELS; i++) {
+    isa::Level level = isa::Level::baseline;
+    ASSERT_TRUE(isa::parse(isa::NAMES[i], level));
+    ASSERT_EQ(static_cast<size_t>(level), i);
+    ASSERT_STREQ(isa::name(level), isa::NAMES[i]);
+  }
+  isa::Level level = isa::Level::v3;
+  ASSERT_FALSE(isa::parse("x86-64-v5", level));
+  ASSERT_FALSE(isa::parse("", level));
+  ASSERT_EQ(level, isa::Level::v3);
+}
+
+TEST(DriftSortUnitTests, isa_select_never_exceeds_cpu) {
+  isa::Level detected = isa::detect();
+  ASSERT_EQ(isa::select(nullptr), detected);
+  ASSERT_EQ(isa::select("bogus"), detected);
+  for (const char *name : isa::NAMES) {
+    isa::Level forced = isa::Level::baseline;
+    isa::parse(name, forced);
+    ASSERT_EQ(isa::select(name), std::min(forced, detected));
+  }
+}
+
+// Run by ctest once for every level through DRIFTSORT_ISA, see
+// CMakeLists.txt.
+TEST(DriftSortUnitTests, isa_qsort_uses_selected_kernels) {
+  ASSERT_STREQ(driftsort_isa(),
+               isa::name(isa::select(std::getenv("DRIFTSORT_ISA"))));
+  for (size_t length : {0, 1, 7, 20, 33, 500, 4096, 100000}) {
+    for (uint32_t distinct : {4u, 1u << 30}) {
+      std::vector<Pair> v = pairs(length, distinct);
+      std::qsort(v.data(), v.size(), sizeof(Pair), compare_keys);
+      expect_stably_sorted(v);
+
+#ifdef __GLIBC__
+      v = pairs(length, distinct);
+      size_t calls = 0;
+      qsort_r(v.data(), v.size(), sizeof(Pair), compare_keys_r, &calls);
+      expect_stably_sorted(v);
+      if (length >= 2) {
+        ASSERT_GT(calls, 0u);
+      }
+#endif
+    }
+  }
+}
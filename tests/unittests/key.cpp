@@ -0,0 +1,69 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/key.h"
+#include <cmath>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <limits>
+#include <vector>
+
+using namespace driftsort;
+
+template <typename T>
+void expect_increasing(const std::vector<T> &values, KeyType type) {
+  KeySpec spec{0, sizeof(T), type, false};
+  KeySpec reversed{0, sizeof(T), type, true};
+  for (size_t i = 1; i < values.size(); i++) {
+    EXPECT_LT(key::prefix(&values[i - 1], spec), key::prefix(&values[i], spec))
+        << i;
+    EXPECT_GT(key::prefix(&values[i - 1], reversed),
+              key::prefix(&values[i], reversed))
+        << i;
+  }
+}
+
+TEST(DriftSortUnitTests, key_prefix_signed) {
+  expect_increasing<int8_t>({-128, -1, 0, 1, 127}, KeyType::signed_int);
+  expect_increasing<int32_t>({INT32_MIN, -70000, -1, 0, 3, INT32_MAX},
+                             KeyType::signed_int);
+  expect_increasing<int64_t>({INT64_MIN, -1, 0, INT64_MAX},
+                             KeyType::signed_int);
+}
+
+TEST(DriftSortUnitTests, key_prefix_unsigned) {
+  expect_increasing<uint16_t>({0, 1, 255, 256, 65535}, KeyType::unsigned_int);
+  expect_increasing<uint64_t>({0, 1, UINT64_MAX}, KeyType::unsigned_int);
+}
+
+TEST(DriftSortUnitTests, key_prefix_floating) {
+  float inf = std::numeric_limits<float>::infinity();
+  expect_increasing<float>({-std::nanf(""), -inf, -1.5f, -0.0f, 0.0f, 1e-30f,
+                            2.0f, inf, std::nanf("")},
+                           KeyType::floating);
+  double dinf = std::numeric_limits<double>::infinity();
+  expect_increasing<double>({-dinf, -1e300, -0.0, 0.0, 1e-300, dinf},
+                            KeyType::floating);
+}
+
+TEST(DriftSortUnitTests, key_compare_long_bytes) {
+  const char a[] = "prefix-of-key-1";
+  const char b[] = "prefix-of-key-2";
+  KeySpec spec{0, sizeof(a) - 1, KeyType::bytes, false};
+  EXPECT_FALSE(key::prefix_is_exact(spec));
+  EXPECT_EQ(key::prefix(a, spec), key::prefix(b, spec));
+  EXPECT_LT(key::compare(a, b, spec), 0);
+  spec.descending = true;
+  EXPECT_GT(key::compare(a, b, spec), 0);
+}
+
+TEST(DriftSortUnitTests, key_is_valid) {
+  EXPECT_TRUE(key::is_valid({4, 4, KeyType::floating, false}, 8));
+  EXPECT_FALSE(key::is_valid({4, 8, KeyType::floating, false}, 8));
+  EXPECT_FALSE(key::is_valid({0, 3, KeyType::signed_int, false}, 8));
+  EXPECT_TRUE(key::is_valid({1, 7, KeyType::bytes, false}, 8));
+  EXPECT_FALSE(key::is_valid({9, 1, KeyType::bytes, false}, 8));
+}
@@ -0,0 +1,64 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/lazy.h"
+#include <algorithm>
+#include <bit>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+// McIlroy's adversary for quicksort: every element starts out as "gas",
+// greater than all values fixed so far, and gets a value only once it is
+// compared with another gas element. The element compared last with gas is
+// taken to be the pivot and kept gas, so every partition splits off as
+// little as possible.
+struct Adversary {
+  std::vector<size_t> values;
+  size_t gas;
+  size_t solid = 0;
+  size_t candidate = 0;
+  size_t count = 0;
+
+  explicit Adversary(size_t length) : values(length, length), gas(length) {}
+
+  int compare(size_t x, size_t y) {
+    count++;
+    if (values[x] == gas && values[y] == gas)
+      values[x == candidate ? x : y] = solid++;
+    if (values[x] == gas)
+      candidate = x;
+    else if (values[y] == gas)
+      candidate = y;
+    return (values[x] > values[y]) - (values[x] < values[y]);
+  }
+};
+} // namespace
+
+TEST(DriftSortUnitTests, lazy_drain_bounded_under_adversary) {
+  for (size_t length : {size_t{1} << 12, size_t{1} << 16}) {
+    Adversary adversary(length);
+    std::vector<size_t> v(length);
+    std::iota(v.begin(), v.end(), 0);
+    auto compare = [&adversary](const void *a, const void *b) {
+      return adversary.compare(*static_cast<const size_t *>(a),
+                               *static_cast<const size_t *>(b));
+    };
+    LazySorter<decltype(compare)> sorter(v.data(), length, sizeof(size_t),
+                                         compare);
+    size_t taken = 0;
+    while (sorter.next() != nullptr)
+      taken++;
+    ASSERT_EQ(taken, length);
+    // The values the adversary fixed are what the elements are sorted by.
+    ASSERT_TRUE(std::is_sorted(v.begin(), v.end(), [&](size_t x, size_t y) {
+      return adversary.values[x] < adversary.values[y];
+    }));
+    EXPECT_LE(adversary.count, 4 * length * std::bit_width(length));
+  }
+}
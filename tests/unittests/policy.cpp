@@ -0,0 +1,50 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/policy.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <vector>
+using namespace driftsort;
+
+TEST(DriftSortUnitTests, policy_size_classes) {
+  for (size_t size = 1; size <= 64; size++) {
+    size_t expected = size <= 4 ? 0 : size <= 8 ? 1 : size <= 16 ? 2 : 3;
+    ASSERT_EQ(policy::size_class(size), expected);
+  }
+  ASSERT_EQ(policy::size_class(4096), policy::SIZE_CLASSES - 1);
+  ASSERT_TRUE(policy::valid(policy::DEFAULT_TUNING));
+  for (const policy::Tuning &tuning : policy::TUNING)
+    ASSERT_TRUE(policy::valid(tuning));
+}
+
+TEST(DriftSortUnitTests, policy_prefetcher_covers_every_cache_line) {
+  // A partition loop checks once every 4 elements, from the first one after
+  // the pivot, and must still prefetch for every cache line it scans.
+  for (size_t element_size : {4, 16, 64}) {
+    size_t length = policy::PREFETCH_MIN_BYTES / element_size;
+    size_t per_line =
+        std::max<size_t>(policy::CACHE_LINE_BYTES / element_size, 1);
+    auto ahead = static_cast<ptrdiff_t>(
+        std::max<size_t>(policy::PREFETCH_DISTANCE_BYTES / element_size, 2));
+    for (size_t start : {0, 1, 3, 5}) {
+      policy::Prefetcher prefetcher(length, element_size, start);
+      std::vector<bool> covered(length / per_line);
+      size_t scanned = start;
+      for (; scanned + 4 <= length; scanned += 4) {
+        while (prefetcher.due(scanned + 3)) {
+          // The element whose cache line this prefetch is for.
+          ptrdiff_t line_start = static_cast<ptrdiff_t>(scanned) +
+                                 prefetcher.distance(scanned) - ahead;
+          covered[line_start / per_line] = true;
+        }
+      }
+      for (size_t line = start / per_line + 1; line < scanned / per_line;
+           line++)
+        ASSERT_TRUE(covered[line]);
+    }
+  }
+}
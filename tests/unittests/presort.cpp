@@ -0,0 +1,79 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include "driftsort/driftsort.h"
+#include "driftsort/presort.h"
+#include <algorithm>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+
+presort::Strategy strategy_of(std::vector<int> &v) {
+  return presort::choose(estimate_order(v.data(), v.size(), sizeof(int),
+                                        three_way(compare_ints)));
+}
+
+std::vector<int> runs_of(size_t length, size_t run_length) {
+  std::mt19937 rng(42);
+  std::vector<int> v(length);
+  for (size_t i = 0; i < length; i += run_length) {
+    size_t end = std::min(length, i + run_length);
+    for (size_t j = i; j < end; j++)
+      v[j] = static_cast<int>(rng() % length);
+    std::sort(v.begin() + i, v.begin() + end);
+  }
+  return v;
+}
+} // namespace
+
+TEST(DriftSortUnitTests, presort_strategies) {
+  const size_t length = 100000;
+  std::vector<int> v(length);
+  std::iota(v.begin(), v.end(), 0);
+  EXPECT_EQ(strategy_of(v), presort::Strategy::presorted);
+  std::reverse(v.begin(), v.end());
+  EXPECT_EQ(strategy_of(v), presort::Strategy::presorted);
+
+  std::mt19937 rng(42);
+  std::shuffle(v.begin(), v.end(), rng);
+  EXPECT_EQ(strategy_of(v), presort::Strategy::shuffled);
+  // Few distinct keys are left to the three-way partitions of quicksort.
+  for (int &x : v)
+    x = static_cast<int>(rng() % 4);
+  EXPECT_EQ(strategy_of(v), presort::Strategy::shuffled);
+
+  // run lengths that divide the sampling stride must not go unnoticed
+  for (size_t run_length : {size_t{150}, size_t{300}, size_t{600}}) {
+    v = runs_of(length, run_length);
+    presort::Estimate estimate = estimate_order(
+        v.data(), length, sizeof(int), three_way(compare_ints));
+    EXPECT_EQ(presort::choose(estimate), presort::Strategy::runs);
+    EXPECT_LE(presort::run_threshold(estimate), run_length);
+  }
+}
+
+TEST(DriftSortUnitTests, presort_capi_names_strategy) {
+  std::vector<int> v = runs_of(100000, 500);
+  driftsort_order_estimate estimate;
+  const char *strategy = driftsort_estimate_order_r(
+      v.data(), v.size(), sizeof(int), &estimate,
+      [](const void *a, const void *b, void *) { return compare_ints(a, b); },
+      nullptr);
+  EXPECT_STREQ(strategy, "runs");
+  EXPECT_GT(estimate.pairs, 0u);
+  EXPECT_LT(estimate.descents * presort::MIN_SAMPLED_RUN, estimate.pairs);
+}
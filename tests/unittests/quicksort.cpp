@@ -0,0 +1,56 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/driftsort.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+struct Tagged {
+  unsigned key;
+  unsigned id;
+};
+
+// Large enough to be sorted by `quick::ping_pong_quicksort`.
+std::vector<Tagged> large_input(unsigned distinct) {
+  std::vector<Tagged> v(2 * quick::PING_PONG_MIN_BYTES / sizeof(Tagged));
+  std::mt19937 rng(42);
+  for (size_t i = 0; i < v.size(); i++)
+    v[i] = {static_cast<unsigned>(rng() % distinct),
+            static_cast<unsigned>(i)};
+  return v;
+}
+
+bool sorted_and_stable(const std::vector<Tagged> &v) {
+  for (size_t i = 1; i < v.size(); i++)
+    if (v[i - 1].key > v[i].key ||
+        (v[i - 1].key == v[i].key && v[i - 1].id > v[i].id))
+      return false;
+  return true;
+}
+
+int compare_tagged(const void *a, const void *b) {
+  unsigned x = static_cast<const Tagged *>(a)->key;
+  unsigned y = static_cast<const Tagged *>(b)->key;
+  return (x > y) - (x < y);
+}
+} // namespace
+
+TEST(DriftSortUnitTests, ping_pong_large_arrays) {
+  for (unsigned distinct : {4u, 1000u, 1u << 30}) {
+    std::vector<Tagged> v = large_input(distinct);
+    driftsort::qsort_r(v.data(), v.size(), sizeof(Tagged), compare_tagged);
+    ASSERT_TRUE(sorted_and_stable(v));
+
+    v = large_input(distinct);
+    driftsort::qsort_r(v.data(), v.size(), sizeof(Tagged),
+                       three_way(compare_tagged));
+    ASSERT_TRUE(sorted_and_stable(v));
+  }
+}
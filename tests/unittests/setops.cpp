@@ -0,0 +1,61 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/setops.h"
+#include <algorithm>
+#include <bit>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+using namespace driftsort;
+
+namespace {
+int compare_ints(const void *a, const void *b) {
+  int x = *static_cast<const int *>(a);
+  int y = *static_cast<const int *>(b);
+  return (x > y) - (x < y);
+}
+} // namespace
+
+TEST(DriftSortUnitTests, set_operations_gallop_past_disjoint_stretches) {
+  // `b` overlaps `a` only in a few elements in the middle.
+  constexpr size_t length = 1 << 20;
+  std::vector<int> a(length);
+  std::vector<int> b(length);
+  std::iota(a.begin(), a.end(), 0);
+  std::iota(b.begin(), b.end(), static_cast<int>(length - 4));
+  size_t count = 0;
+  auto compare = three_way([&count](const void *x, const void *y) {
+    count++;
+    return compare_ints(x, y);
+  });
+  // A few steps, then a gallop through each array.
+  size_t bound = 4 * setops::GALLOP_AFTER + 4 * std::bit_width(length);
+
+  std::vector<int> dest(length);
+  ASSERT_EQ(set_intersection(a.data(), length, b.data(), length, sizeof(int),
+                             dest.data(), compare),
+            4u);
+  EXPECT_EQ(dest[0], static_cast<int>(length - 4));
+  EXPECT_LE(count, bound);
+
+  count = 0;
+  std::vector<JoinRange> ranges(length);
+  ASSERT_EQ(merge_join(a.data(), length, b.data(), length, sizeof(int),
+                       ranges.data(), compare),
+            4u);
+  EXPECT_EQ(ranges[0].a_start, length - 4);
+  EXPECT_EQ(ranges[0].b_start, 0u);
+  EXPECT_LE(count, bound + 3 * 4);
+
+  count = 0;
+  dest.resize(2 * length);
+  ASSERT_EQ(set_union(a.data(), length, b.data(), length, sizeof(int),
+                      dest.data(), compare),
+            2 * length - 4);
+  EXPECT_TRUE(std::is_sorted(dest.begin(), dest.end() - 4));
+  EXPECT_LE(count, bound);
+}
@@ -0,0 +1,27 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/capi.h"
+#include <gtest/gtest.h>
+
+namespace {
+int compare_nothing(const void *, const void *, void *) { return 0; }
+} // namespace
+
+TEST(DriftSortUnitTests, stream_of_empty_elements_stays_empty) {
+  driftsort_stream *stream =
+      driftsort_stream_new_r(0, compare_nothing, nullptr);
+  ASSERT_NE(stream, nullptr);
+  char chunk[4] = {};
+  for (int i = 0; i < 3; i++)
+    ASSERT_EQ(driftsort_stream_push(stream, chunk, 4), 0);
+  size_t nmemb = 1;
+  driftsort_stream_sorted_prefix(stream, &nmemb);
+  EXPECT_EQ(nmemb, 0u);
+  driftsort_stream_finish(stream, &nmemb);
+  EXPECT_EQ(nmemb, 0u);
+  driftsort_stream_free(stream);
+}
@@ -0,0 +1,31 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "driftsort/blob.h"
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <vector>
+using namespace driftsort;
+
+#if DRIFTSORT_HAS_STREAMING_STORES
+TEST(DriftSortUnitTests, stream_bytes_any_alignment) {
+  std::vector<std::byte> src(1000);
+  for (size_t i = 0; i < src.size(); i++)
+    src[i] = static_cast<std::byte>(i * 7);
+  for (size_t offset = 0; offset < 16; offset++) {
+    for (size_t bytes : {size_t{0}, size_t{5}, size_t{64}, size_t{333},
+                         size_t{900}}) {
+      std::vector<std::byte> dst(src.size() + 32, std::byte{0xff});
+      stream_bytes(dst.data() + offset, src.data() + 3, bytes);
+      for (size_t i = 0; i < dst.size(); i++) {
+        bool copied = i >= offset && i < offset + bytes;
+        ASSERT_EQ(dst[i], copied ? src[i - offset + 3] : std::byte{0xff})
+            << "offset " << offset << ", bytes " << bytes << ", at " << i;
+      }
+    }
+  }
+}
+#endif
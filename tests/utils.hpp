@@ -3,9 +3,13 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
+#pragma once
 #include "driftsort/blob.h"
+#include <algorithm>
 #include <concepts>
+#include <cstddef>
 #include <functional>
+#include <vector>
 namespace driftsort {
 template <class T> class ElementWithSrc {
   T val;
@@ -34,4 +38,45 @@ auto compare_blob() {
       }};
 }
 
+template <typename T, std::predicate<const T &, const T &> Comp = std::less<>>
+auto compare_blob_three_way() {
+  return BlobComparator{
+      sizeof(T), alignof(T), three_way([](const void *a, const void *b) {
+        auto &x = *static_cast<const T *>(a);
+        auto &y = *static_cast<const T *>(b);
+        return Comp{}(x, y) ? -1 : Comp{}(y, x) ? 1 : 0;
+      })};
+}
+
+/// An element that remembers its original position `id`, so that tests can
+/// tell which of several equal elements ended up where.
+struct Tagged {
+  int key;
+  size_t id;
+  bool operator==(const Tagged &) const = default;
+};
+
+/// Tags each of `keys` modulo `modulus` with its index. Few distinct keys
+/// make ties common, so that stability is observable.
+inline std::vector<Tagged> tag(const std::vector<int> &keys, int modulus) {
+  std::vector<Tagged> res;
+  for (size_t i = 0; i < keys.size(); i++)
+    res.push_back({keys[i] % modulus, i});
+  return res;
+}
+
+inline bool key_less(const Tagged &x, const Tagged &y) { return x.key < y.key; }
+
+/// Compares the keys of two `Tagged` like a qsort comparator.
+inline int compare_tagged(const void *a, const void *b) {
+  int x = static_cast<const Tagged *>(a)->key;
+  int y = static_cast<const Tagged *>(b)->key;
+  return (x > y) - (x < y);
+}
+
+/// `v` sorted by key, equal keys in their original order.
+inline std::vector<Tagged> stable_sorted(std::vector<Tagged> v) {
+  std::stable_sort(v.begin(), v.end(), key_less);
+  return v;
+}
 } // namespace driftsort
@@ -0,0 +1,161 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Sorts a binary file of fixed-width records by a key inside each record.
+
+#include "driftsort/external.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+
+static void usage(const char *argv0) {
+  std::fprintf(
+      stderr,
+      "usage: %s -r SIZE -w WIDTH [options] INPUT [OUTPUT]\n"
+      "\n"
+      "Sorts INPUT, a file of fixed-width records, into OUTPUT, or in place\n"
+      "if OUTPUT is omitted. Equal keys keep their order.\n"
+      "\n"
+      "  -r, --record-size SIZE  record size in bytes\n"
+      "  -o, --key-offset OFFSET key offset inside a record (default 0)\n"
+      "  -w, --key-width WIDTH   key width in bytes\n"
+      "  -t, --key-type TYPE     unsigned, signed, float or bytes\n"
+      "                          (default unsigned)\n"
+      "  -d, --descending        sort in descending key order\n"
+      "  -m, --memory SIZE       memory budget, with optional K, M or G\n"
+      "                          suffix (default 256M)\n"
+      "  -T, --temp-dir DIR      directory for sorted runs (default $TMPDIR\n"
+      "                          or /tmp)\n",
+      argv0);
+}
+
+static bool parse_size(const char *s, size_t &out) {
+  char *end;
+  errno = 0;
+  unsigned long long value = std::strtoull(s, &end, 10);
+  if (errno != 0 || end == s)
+    return false;
+  unsigned shift = 0;
+  switch (*end) {
+  case 'k':
+  case 'K':
+    shift = 10;
+    end++;
+    break;
+  case 'm':
+  case 'M':
+    shift = 20;
+    end++;
+    break;
+  case 'g':
+  case 'G':
+    shift = 30;
+    end++;
+    break;
+  default:
+    break;
+  }
+  if (*end != '\0' || value > (~0ull >> shift))
+    return false;
+  out = static_cast<size_t>(value << shift);
+  return true;
+}
+
+static bool parse_key_type(const char *s, driftsort::KeyType &out) {
+  if (std::strcmp(s, "unsigned") == 0)
+    out = driftsort::KeyType::unsigned_int;
+  else if (std::strcmp(s, "signed") == 0)
+    out = driftsort::KeyType::signed_int;
+  else if (std::strcmp(s, "float") == 0)
+    out = driftsort::KeyType::floating;
+  else if (std::strcmp(s, "bytes") == 0)
+    out = driftsort::KeyType::bytes;
+  else
+    return false;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  static const option long_options[] = {
+      {"record-size", required_argument, nullptr, 'r'},
+      {"key-offset", required_argument, nullptr, 'o'},
+      {"key-width", required_argument, nullptr, 'w'},
+      {"key-type", required_argument, nullptr, 't'},
+      {"descending", no_argument, nullptr, 'd'},
+      {"memory", required_argument, nullptr, 'm'},
+      {"temp-dir", required_argument, nullptr, 'T'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0},
+  };
+
+  driftsort::ExternalSortOptions options{
+      0, {0, 0, driftsort::KeyType::unsigned_int, false}};
+  if (const char *tmpdir = std::getenv("TMPDIR"))
+    options.temp_dir = tmpdir;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "r:o:w:t:dm:T:h", long_options,
+                            nullptr)) != -1) {
+    bool ok = true;
+    switch (opt) {
+    case 'r':
+      ok = parse_size(optarg, options.record_size);
+      break;
+    case 'o':
+      ok = parse_size(optarg, options.key.offset);
+      break;
+    case 'w':
+      ok = parse_size(optarg, options.key.width);
+      break;
+    case 't':
+      ok = parse_key_type(optarg, options.key.type);
+      break;
+    case 'd':
+      options.key.descending = true;
+      break;
+    case 'm':
+      ok = parse_size(optarg, options.memory_budget) &&
+           options.memory_budget != 0;
+      break;
+    case 'T':
+      options.temp_dir = optarg;
+      break;
+    case 'h':
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    if (!ok) {
+      std::fprintf(stderr, "%s: invalid argument for -%c: %s\n", argv[0],
+                   opt, optarg);
+      return EXIT_FAILURE;
+    }
+  }
+
+  int positional = argc - optind;
+  if (positional < 1 || positional > 2 || options.record_size == 0 ||
+      options.key.width == 0) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (!driftsort::key::is_valid(options.key, options.record_size)) {
+    std::fprintf(stderr, "%s: key does not fit the record or type\n",
+                 argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const char *input = argv[optind];
+  const char *output = positional == 2 ? argv[optind + 1] : nullptr;
+  if (int err = driftsort::sort_file(input, output, options)) {
+    std::fprintf(stderr, "%s: %s: %s\n", argv[0], input, std::strerror(err));
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,333 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Calibrates the tuning constants of driftsort for the machine it runs on and
+// writes them as a header for DRIFTSORT_POLICY_HEADER.
+//
+// Built with DRIFTSORT_TUNABLE, so that `policy::TUNING` can be changed
+// between runs. Each size class is tuned by coordinate descent over its
+// constants on the patterns of the benchmarks, scoring a tuning by its time
+// relative to the defaults, averaged over all cases so that each one counts
+// the same.
+
+#include "driftsort/driftsort.h"
+#include "driftsort/policy.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <random>
+#include <vector>
+
+using driftsort::policy::Tuning;
+
+namespace {
+enum class Pattern { random, sorted, reversed, half_sorted, few_distinct };
+constexpr Pattern PATTERNS[] = {Pattern::random, Pattern::sorted,
+                                Pattern::reversed, Pattern::half_sorted,
+                                Pattern::few_distinct};
+// A representative element size of every size class.
+constexpr size_t CLASS_SIZES[driftsort::policy::SIZE_CLASSES] = {4, 8, 16, 32};
+
+struct Options {
+  // Elements sorted per measurement, in as many arrays as fit.
+  size_t elements = size_t{1} << 18;
+  size_t max_length = size_t{1} << 17;
+  int repetitions = 3;
+  bool verbose = false;
+};
+
+int compare_keys(const void *a, const void *b) {
+  uint32_t x, y;
+  std::memcpy(&x, a, sizeof(x));
+  std::memcpy(&y, b, sizeof(y));
+  return (x > y) - (x < y);
+}
+
+std::vector<uint32_t> keys(Pattern pattern, size_t length, std::mt19937 &rng) {
+  std::vector<uint32_t> v(length);
+  for (size_t i = 0; i < length; i++)
+    v[i] = static_cast<uint32_t>(i);
+  switch (pattern) {
+  case Pattern::random:
+    std::shuffle(v.begin(), v.end(), rng);
+    break;
+  case Pattern::sorted:
+    break;
+  case Pattern::reversed:
+    std::reverse(v.begin(), v.end());
+    break;
+  case Pattern::half_sorted:
+    // As in the half-sorted benchmark: a quarter of random swaps.
+    for (size_t i = 0; i < length / 4; i++)
+      std::swap(v[i], v[std::uniform_int_distribution<size_t>(
+                          i, length - 1)(rng)]);
+    break;
+  case Pattern::few_distinct:
+    for (auto &x : v)
+      x = rng() % 16;
+    break;
+  }
+  return v;
+}
+
+/// Arrays of one pattern and length, laid out back to back, with the time
+/// the default tuning takes to sort them.
+struct Case {
+  size_t length;
+  size_t count;
+  std::vector<std::byte> input;
+  double baseline = 0;
+};
+
+class Tuner {
+  size_t element_size;
+  Options options;
+  std::vector<Case> cases;
+  std::vector<std::byte> work;
+
+  double time(Case &c) {
+    double best = 0;
+    for (int r = 0; r < options.repetitions; r++) {
+      std::memcpy(work.data(), c.input.data(), c.input.size());
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < c.count; i++)
+        driftsort::qsort_r(work.data() + i * c.length * element_size,
+                           c.length, element_size,
+                           driftsort::three_way(compare_keys));
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (r == 0 || elapsed.count() < best)
+        best = elapsed.count();
+    }
+    return best;
+  }
+
+public:
+  Tuner(size_t element_size, const Options &options)
+      : element_size(element_size), options(options) {
+    std::mt19937 rng(42);
+    size_t work_bytes = 0;
+    for (Pattern pattern : PATTERNS) {
+      for (size_t length = 8; length <= options.max_length; length *= 4) {
+        Case c{length, std::max<size_t>(options.elements / length, 1), {}};
+        c.input.resize(c.count * length * element_size);
+        for (size_t i = 0; i < c.count; i++) {
+          std::vector<uint32_t> k = keys(pattern, length, rng);
+          for (size_t j = 0; j < length; j++)
+            std::memcpy(&c.input[(i * length + j) * element_size], &k[j],
+                        sizeof(uint32_t));
+        }
+        work_bytes = std::max(work_bytes, c.input.size());
+        cases.push_back(std::move(c));
+      }
+    }
+    work.resize(work_bytes);
+    for (Case &c : cases)
+      c.baseline = time(c);
+  }
+
+  /// Mean time of the current tuning relative to the baseline.
+  double score() {
+    double sum = 0;
+    for (Case &c : cases)
+      sum += time(c) / c.baseline;
+    return sum / static_cast<double>(cases.size());
+  }
+};
+
+struct Parameter {
+  const char *name;
+  size_t Tuning::*field;
+  std::vector<size_t> candidates;
+};
+
+const std::vector<Parameter> &parameters() {
+  static const std::vector<Parameter> list = {
+      {"smallsort_threshold",
+       &Tuning::smallsort_threshold,
+       {16, 20, 24, 32, 40, 48, 64}},
+      {"max_len_always_insertion_sort",
+       &Tuning::max_len_always_insertion_sort,
+       {8, 12, 16, 20, 24, 32}},
+      {"min_sqrt_run_len", &Tuning::min_sqrt_run_len, {16, 32, 64, 128}},
+      {"pseudo_median_rec_threshold",
+       &Tuning::pseudo_median_rec_threshold,
+       {32, 64, 128, 256}},
+      {"heap_alloc_threshold",
+       &Tuning::heap_alloc_threshold,
+       {1024, 2048, 4096, 8192, 16384}},
+      {"max_full_alloc_bytes",
+       &Tuning::max_full_alloc_bytes,
+       {size_t{1} << 18, size_t{1} << 20, size_t{1} << 22, size_t{1} << 23,
+        size_t{1} << 24}},
+  };
+  return list;
+}
+
+// A candidate replaces the current value only if it is this much faster,
+// so that noise does not move the tuning.
+constexpr double MIN_GAIN = 0.03;
+
+/// Tunes the size class of `element_size` in place.
+void tune_class(size_t element_size, const Options &options) {
+  Tuning &tuning =
+      driftsort::policy::TUNING[driftsort::policy::size_class(element_size)];
+  Tuner tuner(element_size, options);
+  double current = tuner.score();
+  for (const Parameter &parameter : parameters()) {
+    size_t best_value = tuning.*parameter.field;
+    for (size_t value : parameter.candidates) {
+      if (value == best_value)
+        continue;
+      tuning.*parameter.field = value;
+      if (!driftsort::policy::valid(tuning))
+        continue;
+      double s = tuner.score();
+      if (options.verbose)
+        std::fprintf(stderr, "  %zu bytes: %s = %zu: %.3f\n", element_size,
+                     parameter.name, value, s);
+      if (s < current * (1 - MIN_GAIN)) {
+        current = s;
+        best_value = value;
+      }
+    }
+    tuning.*parameter.field = best_value;
+  }
+}
+
+/// Tunes the partition unroll factor, which all size classes share.
+void tune_unroll(const Options &options) {
+  std::vector<Tuner> tuners;
+  for (size_t element_size : CLASS_SIZES)
+    tuners.emplace_back(element_size, options);
+  auto score = [&] {
+    double sum = 0;
+    for (Tuner &tuner : tuners)
+      sum += tuner.score();
+    return sum / static_cast<double>(tuners.size());
+  };
+  size_t &unroll = driftsort::policy::PARTITION_UNROLL;
+  double current = score();
+  size_t best_value = unroll;
+  for (size_t value : {size_t{1}, size_t{2}, size_t{4}, size_t{8}}) {
+    if (value == best_value)
+      continue;
+    unroll = value;
+    double s = score();
+    if (options.verbose)
+      std::fprintf(stderr, "  partition_unroll = %zu: %.3f\n", value, s);
+    if (s < current * (1 - MIN_GAIN)) {
+      current = s;
+      best_value = value;
+    }
+  }
+  unroll = best_value;
+}
+
+void write_header(std::FILE *out) {
+  std::fprintf(out,
+               "// Generated by driftsort-tune. Build with\n"
+               "// -DDRIFTSORT_POLICY_HEADER=\"<path of this file>\".\n"
+               "\n"
+               "#pragma once\n"
+               "\n"
+               "#define DRIFTSORT_TUNING \\\n"
+               "  { \\\n");
+  for (size_t c = 0; c < driftsort::policy::SIZE_CLASSES; c++) {
+    const Tuning &t = driftsort::policy::TUNING[c];
+    std::fprintf(out, "    {%zu, %zu, %zu, %zu, %zu, %zu}, \\\n",
+                 t.smallsort_threshold, t.max_len_always_insertion_sort,
+                 t.min_sqrt_run_len, t.pseudo_median_rec_threshold,
+                 t.heap_alloc_threshold, t.max_full_alloc_bytes);
+  }
+  std::fprintf(out,
+               "  }\n"
+               "#define DRIFTSORT_PARTITION_UNROLL %zu\n",
+               driftsort::policy::PARTITION_UNROLL);
+}
+
+void usage(const char *argv0) {
+  std::fprintf(
+      stderr,
+      "usage: %s [options]\n"
+      "\n"
+      "Finds the fastest driftsort tuning for this machine and writes it as\n"
+      "a header for -DDRIFTSORT_POLICY_HEADER.\n"
+      "\n"
+      "  -o, --output FILE  write the header to FILE (default stdout)\n"
+      "  -q, --quick        measure smaller workloads, less precisely\n"
+      "  -v, --verbose      report every candidate on stderr\n",
+      argv0);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  static const option long_options[] = {
+      {"output", required_argument, nullptr, 'o'},
+      {"quick", no_argument, nullptr, 'q'},
+      {"verbose", no_argument, nullptr, 'v'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0},
+  };
+
+  Options options;
+  const char *output = nullptr;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "o:qvh", long_options, nullptr)) !=
+         -1) {
+    switch (opt) {
+    case 'o':
+      output = optarg;
+      break;
+    case 'q':
+      options.elements = size_t{1} << 15;
+      options.max_length = size_t{1} << 13;
+      options.repetitions = 2;
+      break;
+    case 'v':
+      options.verbose = true;
+      break;
+    case 'h':
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (optind != argc) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  for (size_t element_size : CLASS_SIZES) {
+    if (options.verbose)
+      std::fprintf(stderr, "tuning %zu-byte elements\n", element_size);
+    tune_class(element_size, options);
+  }
+  if (options.verbose)
+    std::fprintf(stderr, "tuning the partition unroll factor\n");
+  tune_unroll(options);
+
+  std::FILE *out = output != nullptr ? std::fopen(output, "w") : stdout;
+  if (out == nullptr) {
+    std::fprintf(stderr, "%s: %s: %s\n", argv[0], output,
+                 std::strerror(errno));
+    return EXIT_FAILURE;
+  }
+  write_header(out);
+  if (out != stdout && std::fclose(out) != 0) {
+    std::fprintf(stderr, "%s: %s: %s\n", argv[0], output,
+                 std::strerror(errno));
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}